@@ -123,12 +123,24 @@ PYBIND11_MODULE(rigidipc, m)
         .def_readwrite("name", &RigidBody::name)
         .def_readwrite("group_id", &RigidBody::group_id)
         .def_readwrite("type", &RigidBody::type)
-        .def_readonly("vertices", &RigidBody::vertices)
+        .def_property_readonly(
+            "vertices",
+            [](const RigidBody& self) -> const Eigen::MatrixXd& {
+                return self.vertices();
+            })
         .def(
             "world_vertices",
             [](const RigidBody& self) { return self.world_vertices(); })
-        .def_readonly("edges", &RigidBody::edges)
-        .def_readonly("faces", &RigidBody::faces)
+        .def_property_readonly(
+            "edges",
+            [](const RigidBody& self) -> const Eigen::MatrixXi& {
+                return self.edges();
+            })
+        .def_property_readonly(
+            "faces",
+            [](const RigidBody& self) -> const Eigen::MatrixXi& {
+                return self.faces();
+            })
         .def_readwrite("pose", &RigidBody::pose)
         .def_readwrite("kinematic_poses", &RigidBody::kinematic_poses);
 
@@ -150,6 +162,28 @@ PYBIND11_MODULE(rigidipc, m)
             // Essential: keep object alive while iterator exists
             py::keep_alive<0, 1>(), py::return_value_policy::reference);
 
+    py::class_<StateSnapshot>(m, "State")
+        .def(py::init<>())
+        .def_property_readonly("dim", &StateSnapshot::dim)
+        .def_property_readonly("num_bodies", &StateSnapshot::num_bodies)
+        .def_readonly("positions", &StateSnapshot::positions)
+        .def_readonly("rotations", &StateSnapshot::rotations)
+        .def_readonly("linear_velocities", &StateSnapshot::linear_velocities)
+        .def_readonly(
+            "angular_velocities", &StateSnapshot::angular_velocities)
+        .def_readonly("Qdots", &StateSnapshot::Qdots)
+        .def_readonly("Qddots", &StateSnapshot::Qddots)
+        .def_readonly("has_diagnostics", &StateSnapshot::has_diagnostics)
+        .def_readonly("linear_momentum", &StateSnapshot::linear_momentum)
+        .def_readonly("angular_momentum", &StateSnapshot::angular_momentum)
+        .def_readonly("kinetic_energy", &StateSnapshot::kinetic_energy)
+        .def_readonly("potential_energy", &StateSnapshot::potential_energy)
+        .def_readonly("min_distance", &StateSnapshot::min_distance)
+        .def(
+            "to_json",
+            [](const StateSnapshot& self) { return self.to_json().dump(); },
+            "Convert the state to a JSON string");
+
     py::class_<SimState>(m, "Simulation")
         .def(py::init<>())
         .def(
@@ -166,13 +200,29 @@ PYBIND11_MODULE(rigidipc, m)
             },
             py::return_value_policy::reference)
         .def("step", &SimState::simulation_step, "Take a single step")
+        .def(
+            "state",
+            [](const SimState& sim, StateSnapshot& snapshot) {
+                sim.problem_ptr->state_snapshot(snapshot);
+            },
+            "Write the current state into a (reused) snapshot",
+            py::arg("snapshot"))
+        .def(
+            "saved_state",
+            [](SimState& sim, size_t i, StateSnapshot& snapshot) {
+                sim.get_state(i, snapshot);
+            },
+            "Write the i-th saved state into a (reused) snapshot",
+            py::arg("i"), py::arg("snapshot"))
+        .def("num_states", &SimState::num_states, "Number of saved states")
         .def(
             "run", &SimState::run_simulation, "Run the entire simulation",
             py::arg("fout"))
         .def(
             "save_obj_sequence", &SimState::save_obj_sequence,
-            "Save the simulation as a sequence of OBJ files",
-            py::arg("dir_name"))
+            "Save the simulation as a sequence of OBJ files (or one OBJ per "
+            "body and per-frame transforms if per_body is true)",
+            py::arg("dir_name"), py::arg("per_body") = false)
         .def(
             "save_gltf", &SimState::save_gltf,
             "Save the simulation as a GLTF animation file", py::arg("filename"))
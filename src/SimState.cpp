@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -34,11 +36,18 @@ SimState::SimState()
     , m_num_simulation_steps(0)
     , m_max_simulation_steps(-1)
     , m_checkpoint_frequency(100)
+    , m_step_num_substeps(0)
+    , m_step_num_iterations(0)
+    , m_output_chunk_size(size_t(1) << 22)
+    , m_output_max_pending_chunks(4)
+    , m_is_temporary_trajectory(false)
     , m_dirty_constraints(false)
 {
     initial_rss = getCurrentRSS();
 }
 
+SimState::~SimState() { close_trajectory(); }
+
 void to_lower(std::string& s)
 {
     std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
@@ -101,9 +110,13 @@ bool SimState::load_simulation(const nlohmann::json& input_args)
         return false;
     }
 
-    // now reload simulation history
-    state_sequence = input_args["animation"]["state_sequence"]
-                         .get<std::vector<nlohmann::json>>();
+    // now reload simulation history (replacing the initial state)
+    close_trajectory();
+    if (!trajectory_reader.open(input_args, scene_file)
+        || trajectory_reader.num_frames() == 0) {
+        spdlog::error("Unable to read the saved simulation states!");
+        return false;
+    }
     if (input_args.find("stats") != input_args.end()) {
         const auto& stats = input_args["stats"];
         step_timings = stats["step_timings"].get<std::vector<double>>();
@@ -112,8 +125,10 @@ bool SimState::load_simulation(const nlohmann::json& input_args)
         step_minimum_distances =
             stats["step_minimum_distances"].get<std::vector<double>>();
     }
-    m_num_simulation_steps = int(state_sequence.size()) - 1;
-    problem_ptr->state(state_sequence.back());
+    m_num_simulation_steps = int(trajectory_reader.num_frames()) - 1;
+    StateSnapshot snapshot;
+    trajectory_reader.state(m_num_simulation_steps, snapshot);
+    problem_ptr->state(snapshot);
     return true;
 }
 
@@ -128,6 +143,24 @@ bool SimState::init(const nlohmann::json& args_in)
         "timestep": 0.01,
         "scene_type": "distance_barrier_rb_problem",
         "solver": "ipc_solver",
+        "adaptive_timestep": {
+            "enabled": false,
+            "min_timestep": 1e-5,
+            "shrink_factor": 0.5,
+            "grow_factor": 1.5,
+            "max_iterations": 50,
+            "min_iterations": 10,
+            "min_toi": 0.1
+        },
+        "output": {
+            "chunk_size": 4194304,
+            "max_pending_chunks": 4,
+            "gltf": {
+                "translation_tolerance": 0,
+                "rotation_tolerance": 0,
+                "quantize_rotations": false
+            }
+        },
         "rigid_body_problem": {
             "rigid_bodies": [],
             "coefficient_restitution": 0.0,
@@ -135,7 +168,10 @@ bool SimState::init(const nlohmann::json& args_in)
             "gravity": [0.0, 0.0, 0.0],
             "collision_eps": 0.0,
             "time_stepper": "default",
-            "do_intersection_check": false
+            "warm_start": "none",
+            "body_hessian_regularization": "tikhonov",
+            "do_intersection_check": false,
+            "mesh_cache": ""
         },
         "homotopy_solver": {
             "inner_solver": "DEPRECATED",
@@ -152,6 +188,9 @@ bool SimState::init(const nlohmann::json& args_in)
             "velocity_conv_tol": null,
             "is_velocity_conv_tol_abs": false,
             "line_search_lower_bound": null,
+            "hessian_reuse": false,
+            "max_hessian_reuse": 10,
+            "line_search_batch_size": 1,
             "linear_solver": {
                 "name": "Eigen::SimplicialLDLT",
                 "max_iter": 1000,
@@ -164,6 +203,14 @@ bool SimState::init(const nlohmann::json& args_in)
             "dhat_epsilon": 1e-9,
             "min_barrier_stiffness_scale": null
         },
+        "newton_cg_solver": {
+            "max_cg_iterations": 1000,
+            "max_forcing_term": 0.5
+        },
+        "lbfgs_solver": {
+            "history_size": 8,
+            "hessian_refresh_interval": 10
+        },
         "ncp_solver": {
             "max_iterations": 1000,
             "do_line_search": false,
@@ -177,7 +224,9 @@ bool SimState::init(const nlohmann::json& args_in)
             "trajectory_type": "piecewise_linear",
             "initial_barrier_activation_distance": 1e-3,
             "minimum_separation_distance": 0,
-            "barrier_type": "ipc"
+            "barrier_type": "ipc",
+            "candidate_skin": 0,
+            "sort_constraints": false
         },
         "friction_constraints": {
             "static_friction_speed_bound": 1e-3,
@@ -209,6 +258,12 @@ bool SimState::init(const nlohmann::json& args_in)
     json newton_settings = args["newton_solver"];    // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with the solvers derived from it
+    for (const char* solver : { "newton_cg_solver", "lbfgs_solver" }) {
+        json solver_settings = args["ipc_solver"];
+        solver_settings.merge_patch(args[solver]);
+        args[solver] = solver_settings;
+    }
 
     // check that incomming json doesn't have any unkown keys to avoid stupid
     // bugs
@@ -232,6 +287,12 @@ bool SimState::init(const nlohmann::json& args_in)
     newton_settings = args["newton_solver"];         // make a copy of newton
     newton_settings.merge_patch(args["ipc_solver"]); // apply ipc to newton
     args["ipc_solver"] = newton_settings; // set ipc to updated newton
+    // Share the IPC solver settings with the solvers derived from it
+    for (const char* solver : { "newton_cg_solver", "lbfgs_solver" }) {
+        json solver_settings = args["ipc_solver"];
+        solver_settings.merge_patch(args[solver]);
+        args[solver] = solver_settings;
+    }
 
     auto problem_name = args["scene_type"].get<std::string>();
     auto tmp_problem_ptr = ProblemFactory::factory().get_problem(problem_name);
@@ -254,13 +315,35 @@ bool SimState::init(const nlohmann::json& args_in)
         m_max_simulation_steps = int(ceil(max_time / problem_ptr->timestep()));
     }
 
+    adaptive_timestep.settings(args["adaptive_timestep"]);
+    if (adaptive_timestep.enabled
+        && !problem_ptr->supports_adaptive_timestep()) {
+        spdlog::warn(
+            "Disabling the adaptive time-step because the problem requires a "
+            "fixed time-step (e.g., kinematic pose sequences)");
+        adaptive_timestep.enabled = false;
+    }
+
+    m_output_chunk_size = args["output"]["chunk_size"].get<size_t>();
+    m_output_max_pending_chunks =
+        args["output"]["max_pending_chunks"].get<size_t>();
+    const nlohmann::json& gltf_args = args["output"]["gltf"];
+    m_gltf_options.translation_tolerance =
+        gltf_args["translation_tolerance"].get<double>();
+    m_gltf_options.rotation_tolerance =
+        gltf_args["rotation_tolerance"].get<double>();
+    m_gltf_options.quantize_rotations =
+        gltf_args["quantize_rotations"].get<bool>();
+
     m_num_simulation_steps = 0;
     m_dirty_constraints = true;
 
-    state_sequence.clear();
-    state_sequence.push_back(problem_ptr->state());
+    close_trajectory();
+    trajectory_reader.close();
+    append_state();
     step_timings.clear();
     solver_iterations.clear();
+    num_substeps.clear();
     num_contacts.clear();
     step_minimum_distances.clear();
 
@@ -271,6 +354,15 @@ nlohmann::json SimState::get_active_config()
 {
     nlohmann::json active_args;
     active_args["timestep"] = problem_ptr->timestep();
+    active_args["adaptive_timestep"] = adaptive_timestep.settings();
+    active_args["output"]["chunk_size"] = m_output_chunk_size;
+    active_args["output"]["max_pending_chunks"] = m_output_max_pending_chunks;
+    active_args["output"]["gltf"]["translation_tolerance"] =
+        m_gltf_options.translation_tolerance;
+    active_args["output"]["gltf"]["rotation_tolerance"] =
+        m_gltf_options.rotation_tolerance;
+    active_args["output"]["gltf"]["quantize_rotations"] =
+        m_gltf_options.quantize_rotations;
     active_args["scene_type"] = problem_ptr->name();
 
     active_args[problem_ptr->name()] = problem_ptr->settings();
@@ -322,19 +414,31 @@ void SimState::run_simulation(const std::string& fout)
     std::string chkpt_base =
         (fout_path.parent_path() / fout_path.stem()).string();
 
+    // Stream the states to a trajectory file next to the results
+    fs::path trajectory_path = fout_path;
+    trajectory_path.replace_extension(".traj");
+    if (!open_trajectory(trajectory_path.string())) {
+        spdlog::error(
+            "Unable to write the trajectory to {}", trajectory_path.string());
+    }
+
     if (m_max_simulation_steps <= 0) {
         m_max_simulation_steps = 1000;
     }
 
+    // Restarted simulations continue from the checkpointed step
+    const int first_step = m_num_simulation_steps;
+
     spdlog::info("Starting simulation {}", scene_file);
-    spdlog::info("Running {} iterations", m_max_simulation_steps);
+    spdlog::info(
+        "Running {} iterations", m_max_simulation_steps - first_step);
 
     igl::Timer timer;
     timer.start();
 
     m_solve_collisions = true;
-    print_progress_bar(0, m_max_simulation_steps, 0);
-    for (int i = 0; i < m_max_simulation_steps; ++i) {
+    print_progress_bar(first_step, m_max_simulation_steps, 0);
+    for (int i = first_step; i < m_max_simulation_steps; ++i) {
         simulation_step();
         save_simulation_step();
         spdlog::info(
@@ -344,9 +448,8 @@ void SimState::run_simulation(const std::string& fout)
         if ((i + 1) % m_checkpoint_frequency == 0
             && (i + 1) < m_max_simulation_steps) {
             std::string chkpt_fout = fmt::format(
-                "{}-chkpt{:05d}.json", chkpt_base, m_num_simulation_steps);
-            save_simulation(chkpt_fout);
-            spdlog::info("Simulation checkpoint saved to {}", chkpt_fout);
+                "{}-chkpt{:05d}.ckpt", chkpt_base, m_num_simulation_steps);
+            save_checkpoint(chkpt_fout);
         }
         print_progress_bar(
             i + 1, m_max_simulation_steps, timer.getElapsedTime());
@@ -356,8 +459,9 @@ void SimState::run_simulation(const std::string& fout)
     fmt::print(
         "Simulation finished (total_runtime={:g}s average_fps={:g})\n",
         timer.getElapsedTime(),
-        m_max_simulation_steps / timer.getElapsedTime());
+        (m_max_simulation_steps - first_step) / timer.getElapsedTime());
 
+    close_trajectory();
     save_simulation(fout);
     spdlog::info("Simulation results saved to {}", fout);
     fs::path gltf_filename(fout);
@@ -369,17 +473,171 @@ void SimState::run_simulation(const std::string& fout)
     LOG_PROFILER(scene_file);
 }
 
+bool SimState::save_checkpoint(const std::string& filename)
+{
+    PROFILE_POINT("SimState::save_checkpoint");
+    PROFILE_START();
+
+    // The checkpoint references the states in the trajectory
+    if (m_is_temporary_trajectory
+        || (!trajectory_writer.is_open()
+            && trajectory_reader.filename().empty())) {
+        fs::path trajectory_path(filename);
+        trajectory_path.replace_extension(".traj");
+        if (!open_trajectory(trajectory_path.string())) {
+            PROFILE_END();
+            return false;
+        }
+    }
+    // Do not flush the trajectory here as it would block the stepping (the
+    // buffered states are submitted below)
+    const std::string trajectory_filename = trajectory_writer.is_open()
+        ? trajectory_writer.filename()
+        : trajectory_reader.filename();
+
+    checkpoint::Header header;
+    std::memcpy(header.magic, checkpoint::MAGIC, 8);
+    header.version = checkpoint::VERSION;
+    header.dim = problem_ptr->dim();
+    header.num_bodies = problem_ptr->num_bodies();
+    header.num_simulation_steps = m_num_simulation_steps;
+    header.num_states = num_states();
+    header.timestep = problem_ptr->timestep();
+    header.adaptive_timestep = adaptive_timestep.timestep();
+
+    CheckpointBuffer buffer;
+    buffer.write_value(header);
+    // Path of the trajectory relative to the checkpoint
+    buffer.write_string(
+        fs::proximate(
+            fs::absolute(trajectory_filename),
+            fs::absolute(filename).parent_path())
+            .string());
+    problem_ptr->save_checkpoint(buffer);
+
+    if (trajectory_writer.is_open()) {
+        // Only save the checkpoint once its states are in the trajectory,
+        // and write them now instead of when their chunk is full
+        const size_t num_states = header.num_states;
+        trajectory_writer.submit_chunk();
+        checkpoint_writer.write(
+            filename, std::move(buffer), [this, num_states]() {
+                return trajectory_writer.wait_durable(num_states);
+            });
+    } else {
+        checkpoint_writer.write(filename, std::move(buffer));
+    }
+
+    PROFILE_END();
+    return true;
+}
+
+bool SimState::load_checkpoint(const std::string& filename)
+{
+    CheckpointBuffer buffer;
+    if (!buffer.load(filename)) {
+        return false;
+    }
+
+    const auto header = buffer.read_value<checkpoint::Header>();
+    fs::path trajectory_path = fs::absolute(filename).parent_path()
+        / buffer.read_string();
+    if (!buffer.good()
+        || std::memcmp(header.magic, checkpoint::MAGIC, 8) != 0
+        || header.version != checkpoint::VERSION) {
+        spdlog::error("Invalid checkpoint file: {}", filename);
+        return false;
+    }
+    if (int(header.dim) != problem_ptr->dim()
+        || header.num_bodies != problem_ptr->num_bodies()) {
+        spdlog::error("Checkpoint does not match the scene: {}", filename);
+        return false;
+    }
+    if (!problem_ptr->load_checkpoint(buffer)) {
+        spdlog::error("Invalid checkpoint file: {}", filename);
+        return false;
+    }
+    problem_ptr->timestep(header.timestep);
+    adaptive_timestep.timestep(header.adaptive_timestep);
+
+    // Continue the trajectory up to the checkpointed state
+    close_trajectory();
+    if (!trajectory_reader.open(trajectory_path.string(), header.num_states)
+        || trajectory_reader.num_frames() != header.num_states) {
+        spdlog::error(
+            "Unable to read the checkpointed states from {}",
+            trajectory_path.string());
+        return false;
+    }
+
+    m_num_simulation_steps = int(header.num_simulation_steps);
+    m_dirty_constraints = true;
+
+    // The statistics of the steps before the restart are not checkpointed
+    step_timings.assign(m_num_simulation_steps, -1);
+    solver_iterations.assign(m_num_simulation_steps, -1);
+    num_substeps.assign(m_num_simulation_steps, -1);
+    num_contacts.assign(m_num_simulation_steps, -1);
+    step_minimum_distances.assign(m_num_simulation_steps, -1);
+
+    spdlog::info(
+        "Restarting simulation from {} (sim_step={:d})", filename,
+        m_num_simulation_steps);
+    return true;
+}
+
 void SimState::simulation_step()
 {
     m_num_simulation_steps += 1;
+    m_step_had_collision = false;
     m_step_has_collision = false;
     m_step_has_intersections = false;
+    m_step_num_substeps = 0;
+    m_step_num_iterations = 0;
+
+    const auto count_line_search_failures = [&]() {
+        nlohmann::json stats = problem_ptr->solver().stats();
+        return stats.value("num_newton_ls_fails", 0)
+            + stats.value("num_grad_ls_fails", 0);
+    };
+
+    // Advance the time-step with (possibly) multiple substeps. The last
+    // substep ends exactly at the end of the time-step, so the saved states
+    // are still sampled at the configured frame rate.
+    const double frame_timestep = problem_ptr->timestep();
+    adaptive_timestep.begin_frame(frame_timestep);
 
     step_timer.start();
-    problem_ptr->simulation_step(
-        m_step_had_collision, m_step_has_intersections, m_solve_collisions);
+    do {
+        double substep = adaptive_timestep.next_substep();
+        problem_ptr->timestep(substep);
+
+        int prev_line_search_failures = count_line_search_failures();
+        bool had_collision = false, has_intersections = false;
+        problem_ptr->simulation_step(
+            had_collision, has_intersections, m_solve_collisions);
+        m_step_had_collision |= had_collision;
+        m_step_has_intersections |= has_intersections;
+        m_step_num_substeps++;
+        m_step_num_iterations += problem_ptr->opt_result.num_iterations;
+
+        SubstepDifficulty difficulty;
+        difficulty.success = problem_ptr->opt_result.success;
+        difficulty.num_iterations = problem_ptr->opt_result.num_iterations;
+        difficulty.num_line_search_failures =
+            count_line_search_failures() - prev_line_search_failures;
+        difficulty.earliest_toi = problem_ptr->step_earliest_toi();
+        adaptive_timestep.end_substep(substep, difficulty);
+    } while (!adaptive_timestep.is_frame_finished());
+    problem_ptr->timestep(frame_timestep);
     step_timer.stop();
 
+    if (m_step_num_substeps > 1) {
+        spdlog::debug(
+            "sim_state action=simulation_step sim_it={} num_substeps={:d}",
+            m_num_simulation_steps, m_step_num_substeps);
+    }
+
     if (m_step_had_collision) {
         spdlog::debug("sim_state action=simulation_step status=had_collision");
     }
@@ -408,11 +666,12 @@ void SimState::save_simulation_step()
     PROFILE_POINT("SimState::save_simulation_step");
     PROFILE_START();
 
-    state_sequence.push_back(problem_ptr->state());
+    append_state();
     step_timings.push_back(step_timer.getElapsedTime());
-    solver_iterations.push_back(problem_ptr->opt_result.num_iterations);
+    solver_iterations.push_back(m_step_num_iterations);
+    num_substeps.push_back(m_step_num_substeps);
     num_contacts.push_back(problem_ptr->num_contacts());
-    step_minimum_distances.push_back(problem_ptr->compute_min_distance());
+    step_minimum_distances.push_back(problem_ptr->step_min_distance());
 
     PROFILE_END();
 }
@@ -422,10 +681,28 @@ bool SimState::save_simulation(const std::string& filename)
     PROFILE_POINT("SimState::save_simulation");
     PROFILE_START();
 
+    // Keep the states in a trajectory file next to the results unless they
+    // are already saved in one
+    if (m_is_temporary_trajectory || trajectory().filename().empty()) {
+        fs::path trajectory_path(filename);
+        trajectory_path.replace_extension(".traj");
+        if (!open_trajectory(trajectory_path.string())) {
+            PROFILE_END();
+            return false;
+        }
+    }
+    const TrajectoryReader& states = trajectory();
+
     nlohmann::json results;
     results["args"] = args;
     results["animation"] = nlohmann::json();
-    results["animation"]["state_sequence"] = state_sequence;
+    // Path of the trajectory relative to the results
+    results["animation"]["trajectory"] =
+        fs::proximate(
+            fs::absolute(states.filename()),
+            fs::absolute(filename).parent_path())
+            .string();
+    results["animation"]["num_states"] = states.num_frames();
 
     nlohmann::json stats;
     stats["dim"] = problem_ptr->dim();
@@ -437,6 +714,7 @@ bool SimState::save_simulation(const std::string& filename)
     stats["memory"] = getPeakRSS() - initial_rss;
     stats["step_timings"] = step_timings;
     stats["solver_iterations"] = solver_iterations;
+    stats["num_substeps"] = num_substeps;
     stats["num_contacts"] = num_contacts;
     stats["step_minimum_distances"] = step_minimum_distances;
     stats["solve_stats"] = problem_ptr->solver().stats();
@@ -454,48 +732,138 @@ bool SimState::save_simulation(const std::string& filename)
     return true;
 }
 
-bool SimState::save_obj_sequence(const std::string& dir_name)
+bool SimState::save_obj_sequence(const std::string& dir_name, bool per_body)
 {
-    // Create the output directory if it does not exist
-    fs::path dir_path(dir_name);
-    fs::create_directories(dir_path);
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
 
-    bool success = true;
-    for (int i = 0; i < state_sequence.size(); i++) {
-        const auto& state = state_sequence[i];
-        problem_ptr->state(state);
-        write_obj(
-            (dir_path / fmt::format("{:05d}.obj", i)).string(), *problem_ptr,
-            false);
-    }
+    return write_obj_sequence(
+        dir_name, rbp->m_assembler, trajectory(), per_body);
+}
+
+bool SimState::save_gltf(const std::string& filename)
+{
+    std::shared_ptr<RigidBodyProblem> rbp =
+        std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
 
-    problem_ptr->state(state_sequence.back());
+    return write_gltf(
+        filename, rbp->m_assembler, trajectory(), m_gltf_options);
+}
 
-    return success;
+size_t SimState::num_states()
+{
+    return trajectory_writer.is_open() ? trajectory_writer.num_frames()
+                                       : trajectory_reader.num_frames();
 }
 
-bool SimState::save_gltf(const std::string& filename)
+void SimState::append_state()
 {
-    std::vector<PosesD> poses(state_sequence.size());
-
-    bool success = true;
-    for (int i = 0; i < state_sequence.size(); i++) {
-        const auto& state = state_sequence[i];
-        std::vector<nlohmann::json> jrbs = state["rigid_bodies"];
-        for (int j = 0; j < jrbs.size(); j++) {
-            VectorMax3d position;
-            VectorMax3d rotation;
-            from_json(jrbs[j]["position"], position);
-            from_json(jrbs[j]["rotation"], rotation);
-            poses[i].emplace_back(position, rotation);
+    if (!trajectory_writer.is_open()) {
+        // Use a temporary trajectory until the simulation is saved
+        fs::path filename = fs::temp_directory_path()
+            / fmt::format(
+                "rigid_ipc_{:x}_{:x}.traj", reinterpret_cast<uintptr_t>(this),
+                std::chrono::steady_clock::now().time_since_epoch().count());
+        if (!open_trajectory(filename.string())) {
+            spdlog::error("Unable to save the simulation state!");
+            return;
         }
+        m_is_temporary_trajectory = true;
     }
 
     std::shared_ptr<RigidBodyProblem> rbp =
         std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+    assert(rbp != nullptr);
+    trajectory_writer.append(rbp->m_assembler);
+}
 
-    return write_gltf(
-        filename, rbp->m_assembler, poses, problem_ptr->timestep());
+bool SimState::open_trajectory(const std::string& filename)
+{
+    if (trajectory_writer.is_open()
+        && trajectory_writer.filename() == filename) {
+        return true;
+    }
+
+    update_trajectory_reader();
+    std::error_code ec;
+    // Continue the trajectory being read (e.g., when restarting from a
+    // checkpoint) instead of rewriting its states
+    const bool is_append = !trajectory_reader.filename().empty()
+        && fs::equivalent(trajectory_reader.filename(), filename, ec);
+
+    std::string prev_filename = trajectory_writer.filename();
+    bool is_prev_temporary =
+        trajectory_writer.is_open() && m_is_temporary_trajectory;
+    trajectory_writer.close();
+    // The queued checkpoints wait on the closed trajectory
+    checkpoint_writer.wait();
+    m_is_temporary_trajectory = false;
+
+    bool is_open;
+    if (is_append) {
+        const size_t num_frames = trajectory_reader.num_frames();
+        trajectory_reader.close();
+        is_open = trajectory_writer.reopen(
+            filename, num_frames, m_output_chunk_size,
+            m_output_max_pending_chunks);
+    } else {
+        // Store the meshes so the trajectory can be post-processed on its own
+        std::shared_ptr<RigidBodyProblem> rbp =
+            std::dynamic_pointer_cast<RigidBodyProblem>(problem_ptr);
+        is_open = rbp != nullptr
+            ? trajectory_writer.open(
+                filename, rbp->m_assembler, problem_ptr->timestep(),
+                m_output_chunk_size, m_output_max_pending_chunks)
+            : trajectory_writer.open(
+                filename, problem_ptr->dim(), problem_ptr->num_bodies(),
+                problem_ptr->timestep(), m_output_chunk_size,
+                m_output_max_pending_chunks);
+    }
+    if (!is_open) {
+        return false;
+    }
+
+    // Copy the existing states to the new trajectory
+    for (size_t i = 0; i < trajectory_reader.num_frames(); i++) {
+        trajectory_writer.append(trajectory_reader.frame(i));
+    }
+    trajectory_reader.close();
+
+    if (is_prev_temporary && !is_append) {
+        fs::remove(prev_filename, ec);
+    }
+    return true;
+}
+
+void SimState::close_trajectory()
+{
+    if (!trajectory_writer.is_open()) {
+        return;
+    }
+
+    std::string filename = trajectory_writer.filename();
+    trajectory_writer.close();
+    // Closing the trajectory lets the queued checkpoints be written
+    checkpoint_writer.wait();
+    trajectory_reader.close();
+    if (m_is_temporary_trajectory) {
+        std::error_code ec;
+        fs::remove(filename, ec);
+        m_is_temporary_trajectory = false;
+    } else {
+        trajectory_reader.open(filename);
+    }
+}
+
+void SimState::update_trajectory_reader()
+{
+    if (trajectory_writer.is_open()
+        && (trajectory_reader.filename() != trajectory_writer.filename()
+            || trajectory_reader.num_frames()
+                < trajectory_writer.num_frames())) {
+        trajectory_writer.flush();
+        trajectory_reader.open(trajectory_writer.filename());
+    }
 }
 
 } // namespace ipc::rigid
@@ -5,14 +5,19 @@
 
 #include <memory> // shared_ptr
 
+#include <io/checkpoint.hpp>
+#include <io/trajectory.hpp>
+#include <io/write_gltf.hpp>
 #include <physics/simulation_problem.hpp>
 #include <solvers/optimization_solver.hpp>
+#include <time_stepper/adaptive_timestep.hpp>
 
 namespace ipc::rigid {
 
 class SimState {
 public:
     SimState();
+    ~SimState();
 
     bool load_scene(const std::string& filename, const std::string& patch = "");
     bool reload_scene();
@@ -24,11 +29,39 @@ public:
     bool save_simulation(const std::string& filename);
     void save_simulation_step();
 
-    bool save_obj_sequence(const std::string& dir_name);
+    /// Save the simulation as a sequence of OBJ files (see
+    /// write_obj_sequence())
+    bool save_obj_sequence(const std::string& dir_name, bool per_body = false);
     bool save_gltf(const std::string& filename);
 
     void run_simulation(const std::string& fout);
 
+    /// Save the state needed to restart the simulation (in the background)
+    bool save_checkpoint(const std::string& filename);
+    /// Restart the simulation of the loaded scene from a checkpoint
+    bool load_checkpoint(const std::string& filename);
+
+    /// Number of saved states (time-steps + 1)
+    size_t num_states();
+    /// Get the i-th saved state
+    nlohmann::json get_state(size_t i) { return trajectory().state(i); }
+    /// Get the i-th saved state without converting it to JSON
+    void get_state(size_t i, StateSnapshot& snapshot)
+    {
+        trajectory().state(i, snapshot);
+    }
+    /// Get the poses of the i-th saved state
+    PosesD get_poses(size_t i) { return trajectory().poses(i); }
+    /// Reader of the saved states
+    const TrajectoryReader& trajectory()
+    {
+        update_trajectory_reader();
+        return trajectory_reader;
+    }
+
+    /// Write the saved (and future) states to a trajectory file
+    bool open_trajectory(const std::string& filename);
+
     const nlohmann::json& get_config() { return args; }
     nlohmann::json get_active_config();
 
@@ -42,18 +75,47 @@ public:
     int m_num_simulation_steps; ///< counts simulation steps
     int m_max_simulation_steps; ///< maximum number of time-steps to take
     int m_checkpoint_frequency; ///< time-steps between checkpoints
+    int m_step_num_substeps;    ///< substeps taken by the last step
+    int m_step_num_iterations;  ///< solver iterations of the last step
+
+    /// Controller of the substeps used to advance each (output) time-step
+    AdaptiveTimestep adaptive_timestep;
+    /// Keyframe reduction and quantization of the glTF animation
+    GLTFOptions m_gltf_options;
 
     std::string scene_file;
 
     nlohmann::json args;
 
-    std::vector<nlohmann::json> state_sequence;
     std::vector<double> step_timings;
     std::vector<int> solver_iterations;
+    std::vector<int> num_substeps;
     std::vector<int> num_contacts;
     std::vector<double> step_minimum_distances;
 
 protected:
+    /// Append the current state of the problem to the trajectory
+    void append_state();
+    /// Stop writing the trajectory (deleting it if it is temporary)
+    void close_trajectory();
+    /// Make the reader include all states written so far
+    void update_trajectory_reader();
+
+    /// Size in bytes of the chunks of states written to the trajectory
+    size_t m_output_chunk_size;
+    /// Full chunks that can wait for the I/O thread before stepping blocks
+    size_t m_output_max_pending_chunks;
+
+    /// Append-only log of the states of the simulation
+    TrajectoryWriter trajectory_writer;
+    /// Reader of the states written so far (or of loaded results)
+    TrajectoryReader trajectory_reader;
+    /// Is the trajectory a temporary file (i.e., not saved yet)?
+    bool m_is_temporary_trajectory;
+
+    /// Writes the checkpoints without blocking the simulation
+    CheckpointWriter checkpoint_writer;
+
     igl::Timer step_timer;
     size_t initial_rss;
 
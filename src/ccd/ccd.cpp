@@ -178,8 +178,8 @@ bool edge_vertex_ccd(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long e0_id = bodyB.edges(edge_id, 0);
-    long e1_id = bodyB.edges(edge_id, 1);
+    long e0_id = bodyB.edges()(edge_id, 0);
+    long e1_id = bodyB.edges()(edge_id, 1);
 
     switch (trajectory) {
     case TrajectoryType::LINEAR: {
@@ -241,10 +241,10 @@ bool edge_edge_ccd(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long ea0_id = bodyA.edges(edgeA_id, 0);
-    long ea1_id = bodyA.edges(edgeA_id, 1);
-    long eb0_id = bodyB.edges(edgeB_id, 0);
-    long eb1_id = bodyB.edges(edgeB_id, 1);
+    long ea0_id = bodyA.edges()(edgeA_id, 0);
+    long ea1_id = bodyA.edges()(edgeA_id, 1);
+    long eb0_id = bodyB.edges()(edgeB_id, 0);
+    long eb1_id = bodyB.edges()(edgeB_id, 1);
 
     switch (trajectory) {
     case TrajectoryType::LINEAR: {
@@ -311,9 +311,9 @@ bool face_vertex_ccd(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long f0_id = bodyB.faces(face_id, 0);
-    long f1_id = bodyB.faces(face_id, 1);
-    long f2_id = bodyB.faces(face_id, 2);
+    long f0_id = bodyB.faces()(face_id, 0);
+    long f1_id = bodyB.faces()(face_id, 1);
+    long f2_id = bodyB.faces()(face_id, 2);
 
     switch (trajectory) {
     case TrajectoryType::LINEAR: {
@@ -373,8 +373,8 @@ double edge_vertex_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long e0_id = bodyB.edges(edge_id, 0);
-    long e1_id = bodyB.edges(edge_id, 1);
+    long e0_id = bodyB.edges()(edge_id, 0);
+    long e1_id = bodyB.edges()(edge_id, 1);
 
     Eigen::Vector2d v, e0, e1;
     switch (trajectory) {
@@ -428,10 +428,10 @@ void edge_edge_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long ea0_id = bodyA.edges(edgeA_id, 0);
-    long ea1_id = bodyA.edges(edgeA_id, 1);
-    long eb0_id = bodyB.edges(edgeB_id, 0);
-    long eb1_id = bodyB.edges(edgeB_id, 1);
+    long ea0_id = bodyA.edges()(edgeA_id, 0);
+    long ea1_id = bodyA.edges()(edgeA_id, 1);
+    long eb0_id = bodyB.edges()(edgeB_id, 0);
+    long eb1_id = bodyB.edges()(edgeB_id, 1);
 
     Eigen::Vector3d ea0, ea1, eb0, eb1;
     switch (trajectory) {
@@ -462,11 +462,11 @@ void edge_edge_closest_point(
         PoseD poseA_toi = PoseD::interpolate(poseA_t0, poseA_t1, toi);
         PoseD poseB_toi = PoseD::interpolate(poseB_t0, poseB_t1, toi);
 
-        ea0 = bodyA.world_vertex(poseA_toi, bodyA.edges(edgeA_id, 0));
-        ea1 = bodyA.world_vertex(poseA_toi, bodyA.edges(edgeA_id, 1));
+        ea0 = bodyA.world_vertex(poseA_toi, bodyA.edges()(edgeA_id, 0));
+        ea1 = bodyA.world_vertex(poseA_toi, bodyA.edges()(edgeA_id, 1));
 
-        eb0 = bodyB.world_vertex(poseB_toi, bodyB.edges(edgeB_id, 0));
-        eb1 = bodyB.world_vertex(poseB_toi, bodyB.edges(edgeB_id, 1));
+        eb0 = bodyB.world_vertex(poseB_toi, bodyB.edges()(edgeB_id, 0));
+        eb1 = bodyB.world_vertex(poseB_toi, bodyB.edges()(edgeB_id, 1));
         break;
     }
     }
@@ -495,9 +495,9 @@ void face_vertex_closest_point(
     const PoseD& poseA_t1 = poses_t1[bodyA_id];
     const PoseD& poseB_t0 = poses_t0[bodyB_id];
     const PoseD& poseB_t1 = poses_t1[bodyB_id];
-    long f0_id = bodyB.faces(face_id, 0);
-    long f1_id = bodyB.faces(face_id, 1);
-    long f2_id = bodyB.faces(face_id, 2);
+    long f0_id = bodyB.faces()(face_id, 0);
+    long f1_id = bodyB.faces()(face_id, 1);
+    long f2_id = bodyB.faces()(face_id, 2);
 
     Eigen::Vector3d p, f0, f1, f2;
     switch (trajectory) {
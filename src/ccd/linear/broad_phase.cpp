@@ -286,11 +286,11 @@ void detect_collision_candidates_linear_bvh(
                 const auto RB_t1 =
                     poses_t1[bodyB_id].construct_rotation_matrix();
                 const Eigen::MatrixXd VA_t0 =
-                    ((bodyA.vertices * RA_t0.transpose()).rowwise()
+                    ((bodyA.vertices() * RA_t0.transpose()).rowwise()
                      + (pA_t0 - pB_t0).transpose())
                     * RB_t0;
                 const Eigen::MatrixXd VA_t1 =
-                    ((bodyA.vertices * RA_t1.transpose()).rowwise()
+                    ((bodyA.vertices() * RA_t1.transpose()).rowwise()
                      + (pA_t1 - pB_t1).transpose())
                     * RB_t1;
 
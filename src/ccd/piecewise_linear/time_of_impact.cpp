@@ -122,8 +122,8 @@ bool compute_piecewise_linear_edge_vertex_time_of_impact(
     assert(minimum_separation_distance >= 0);
 
     const long vi = vertex_id;
-    const long e0i = bodyB.edges(edge_id, 0);
-    const long e1i = bodyB.edges(edge_id, 1);
+    const long e0i = bodyB.edges()(edge_id, 0);
+    const long e1i = bodyB.edges()(edge_id, 1);
 
     double distance_t0 = sqrt(point_edge_distance(
         bodyA.world_vertex(poseA_t0, vi), //
@@ -287,10 +287,10 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
     assert(dim == 3);
     assert(minimum_separation_distance >= 0);
 
-    const long ea0i = bodyA.edges(edgeA_id, 0);
-    const long ea1i = bodyA.edges(edgeA_id, 1);
-    const long eb0i = bodyB.edges(edgeB_id, 0);
-    const long eb1i = bodyB.edges(edgeB_id, 1);
+    const long ea0i = bodyA.edges()(edgeA_id, 0);
+    const long ea1i = bodyA.edges()(edgeA_id, 1);
+    const long eb0i = bodyB.edges()(edgeB_id, 0);
+    const long eb1i = bodyB.edges()(edgeB_id, 1);
 
     double distance_t0 = sqrt(edge_edge_distance(
         bodyA.world_vertex(poseA_t0, ea0i), bodyA.world_vertex(poseA_t0, ea1i),
@@ -333,10 +333,10 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
         PoseD poseB_ti1 = PoseD::interpolate(poseB_t0, poseB_t1, ti1);
 
         double distance_ti0 = sqrt(edge_edge_distance(
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 1))));
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 1))));
 
 #ifdef USE_DECREASING_DISTANCE_CHECK
         if (distance_ti0 < DECREASING_DISTANCE_FACTOR * distance_t0
@@ -409,14 +409,14 @@ bool compute_piecewise_linear_edge_edge_time_of_impact(
         // 1: ccd with max_itr and t=[0, t_max]
         const int CCD_TYPE = 1;
         is_impacting = inclusion_ccd::edgeEdgeCCD_double(
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti0, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti0, bodyB.edges(edgeB_id, 1)),
-            bodyA.world_vertex(poseA_ti1, bodyA.edges(edgeA_id, 0)),
-            bodyA.world_vertex(poseA_ti1, bodyA.edges(edgeA_id, 1)),
-            bodyB.world_vertex(poseB_ti1, bodyB.edges(edgeB_id, 0)),
-            bodyB.world_vertex(poseB_ti1, bodyB.edges(edgeB_id, 1)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti0, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti0, bodyB.edges()(edgeB_id, 1)),
+            bodyA.world_vertex(poseA_ti1, bodyA.edges()(edgeA_id, 0)),
+            bodyA.world_vertex(poseA_ti1, bodyA.edges()(edgeA_id, 1)),
+            bodyB.world_vertex(poseB_ti1, bodyB.edges()(edgeB_id, 0)),
+            bodyB.world_vertex(poseB_ti1, bodyB.edges()(edgeB_id, 1)),
             { { -1, -1, -1 } },        // rounding error
             min_distance,              // minimum separation distance
             toi,                       // time of impact
@@ -484,9 +484,9 @@ bool compute_piecewise_linear_face_vertex_time_of_impact(
     assert(minimum_separation_distance >= 0);
 
     const long vi = vertex_id;
-    const long f0i = bodyB.faces(face_id, 0);
-    const long f1i = bodyB.faces(face_id, 1);
-    const long f2i = bodyB.faces(face_id, 2);
+    const long f0i = bodyB.faces()(face_id, 0);
+    const long f1i = bodyB.faces()(face_id, 1);
+    const long f2i = bodyB.faces()(face_id, 2);
 
     double distance_t0 = sqrt(point_triangle_distance(
         bodyA.world_vertex(poseA_t0, vi), bodyB.world_vertex(poseB_t0, f0i),
@@ -289,7 +289,7 @@ void detect_intersection_candidates_rigid_bvh(
                 const auto& pA = poses[bodyA_id].position;
                 const auto& pB = poses[bodyB_id].position;
                 const MatrixXI VA =
-                    ((bodies[bodyA_id].vertices * RA.transpose()).rowwise()
+                    ((bodies[bodyA_id].vertices() * RA.transpose()).rowwise()
                      + (pA - pB).transpose())
                     * RB;
 
@@ -54,12 +54,12 @@ void detect_body_pair_collision_candidates_from_aabbs(
     const RigidBody& bodyB = bodies[bodyB_id];
 
     const std::vector<AABB> bodyB_vertex_aabbs =
-        vertex_aabbs(bodyB.vertices, inflation_radius);
-    const Eigen::MatrixXi &EA = bodyA.edges, &EB = bodyB.edges,
-                          &FA = bodyA.faces, &FB = bodyB.faces;
+        vertex_aabbs(bodyB.vertices(), inflation_radius);
+    const Eigen::MatrixXi &EA = bodyA.edges(), &EB = bodyB.edges(),
+                          &FA = bodyA.faces(), &FB = bodyB.faces();
 
-    const auto& selectorA = bodyA.mesh_selector;
-    const auto& selectorB = bodyB.mesh_selector;
+    const auto& selectorA = bodyA.mesh_selector();
+    const auto& selectorB = bodyB.mesh_selector();
 
     auto bodyA_edge_aabb = [&](size_t ei) {
         return AABB(
@@ -90,7 +90,7 @@ void detect_body_pair_collision_candidates_from_aabbs(
         AABB fa_aabb = bodyA_face_aabb(fa_id);
 
         std::vector<unsigned int> ids;
-        bodyB.bvh.intersect_box(
+        bodyB.bvh().intersect_box(
             // Grow the box by inflation_radius because the BVH is not grown
             fa_aabb.getMin().array() - inflation_radius,
             fa_aabb.getMax().array() + inflation_radius, //
@@ -199,7 +199,7 @@ void detect_body_pair_collision_candidates_from_aabbs(
         AABB ea_aabb = bodyA_edge_aabb(ea_id);
 
         std::vector<unsigned int> ids;
-        bodyB.bvh.intersect_box(
+        bodyB.bvh().intersect_box(
             // Grow the box by inflation_radius because the BVH is not grown
             ea_aabb.getMin().array() - inflation_radius,
             ea_aabb.getMax().array() + inflation_radius, //
@@ -273,7 +273,7 @@ void detect_body_pair_collision_candidates_from_aabbs(
         AABB va_aabb = bodyA_vertex_aabbs[va_id];
 
         std::vector<unsigned int> ids;
-        bodyB.bvh.intersect_box(
+        bodyB.bvh().intersect_box(
             // Grow the box by inflation_radius because the BVH is not grown
             va_aabb.getMin().array() - inflation_radius,
             va_aabb.getMax().array() + inflation_radius, //
@@ -335,12 +335,12 @@ void detect_body_pair_intersection_candidates_from_aabbs(
     const RigidBody& bodyB = bodies[bodyB_id];
 
     const std::vector<AABB> bodyB_vertex_aabbs =
-        vertex_aabbs(bodyB.vertices, inflation_radius);
-    const Eigen::MatrixXi &EA = bodyA.edges, &EB = bodyB.edges,
-                          &FA = bodyA.faces, &FB = bodyB.faces;
+        vertex_aabbs(bodyB.vertices(), inflation_radius);
+    const Eigen::MatrixXi &EA = bodyA.edges(), &EB = bodyB.edges(),
+                          &FA = bodyA.faces(), &FB = bodyB.faces();
 
-    const auto& selectorA = bodyA.mesh_selector;
-    const auto& selectorB = bodyB.mesh_selector;
+    const auto& selectorA = bodyA.mesh_selector();
+    const auto& selectorB = bodyB.mesh_selector();
 
     auto bodyA_edge_aabb = [&](size_t ei) {
         return AABB(
@@ -368,7 +368,7 @@ void detect_body_pair_intersection_candidates_from_aabbs(
         AABB fa_aabb = bodyA_face_aabb(fa_id);
 
         std::vector<unsigned int> ids;
-        bodyB.bvh.intersect_box(
+        bodyB.bvh().intersect_box(
             // Grow the box by inflation_radius because the BVH is not grown
             fa_aabb.getMin().array() - inflation_radius,
             fa_aabb.getMax().array() + inflation_radius, //
@@ -392,7 +392,7 @@ void detect_body_pair_intersection_candidates_from_aabbs(
                 AABB fb_aabb = bodyB_face_aabb(fb_id);
 
                 for (int ei = 0; ei < FA.cols(); ei++) {
-                    long ea_id = bodyA.mesh_selector.face_to_edge(fa_id, ei);
+                    long ea_id = bodyA.mesh_selector().face_to_edge(fa_id, ei);
                     if (selectorA.edge_to_face(ea_id) == fa_id) {
                         AABB ea_aabb = bodyA_edge_aabb(ea_id);
                         if (AABB::are_overlapping(ea_aabb, fb_aabb)) {
@@ -400,8 +400,8 @@ void detect_body_pair_intersection_candidates_from_aabbs(
                         }
                     }
 
-                    long eb_id = bodyB.mesh_selector.face_to_edge(fb_id, ei);
-                    if (bodyB.mesh_selector.edge_to_face(eb_id) == fb_id) {
+                    long eb_id = bodyB.mesh_selector().face_to_edge(fb_id, ei);
+                    if (bodyB.mesh_selector().edge_to_face(eb_id) == fb_id) {
                         AABB eb_aabb = bodyB_edge_aabb(eb_id);
                         if (AABB::are_overlapping(fa_aabb, eb_aabb)) {
                             add_fe(fa_id, eb_id);
@@ -419,7 +419,7 @@ void detect_body_pair_intersection_candidates_from_aabbs(
         AABB ea_aabb = bodyA_edge_aabb(ea_id);
 
         std::vector<unsigned int> ids;
-        bodyB.bvh.intersect_box(
+        bodyB.bvh().intersect_box(
             // Grow the box by inflation_radius because the BVH is not grown
             ea_aabb.getMin().array() - inflation_radius,
             ea_aabb.getMax().array() + inflation_radius, //
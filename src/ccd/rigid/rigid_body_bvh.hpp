@@ -83,7 +83,7 @@ inline void detect_body_pair_collision_candidates_bvh(
     const auto& pA = poses[bodyA_id].position;
     const auto& pB = poses[bodyB_id].position;
     const MatrixX<T> VA =
-        ((bodies[bodyA_id].vertices * RA.transpose()).rowwise()
+        ((bodies[bodyA_id].vertices() * RA.transpose()).rowwise()
          + (pA - pB).transpose())
         * RB;
     // PROFILE_END();
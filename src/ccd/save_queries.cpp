@@ -54,9 +54,9 @@ void save_ccd_candidate(
 
     query["edge"] = nlohmann::json();
     query["edge"]["vertex0"] =
-        to_json(bodyB.vertices.row(bodyB.edges(edge_id, 0)).transpose());
+        to_json(bodyB.vertices().row(bodyB.edges()(edge_id, 0)).transpose());
     query["edge"]["vertex1"] =
-        to_json(bodyB.vertices.row(bodyB.edges(edge_id, 1)).transpose());
+        to_json(bodyB.vertices().row(bodyB.edges()(edge_id, 1)).transpose());
     query["edge"]["pose_t0"] = nlohmann::json();
     query["edge"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyB_id].position);
@@ -70,7 +70,7 @@ void save_ccd_candidate(
 
     query["vertex"] = nlohmann::json();
     query["vertex"]["vertex"] =
-        to_json(bodyA.vertices.row(vertex_id).transpose());
+        to_json(bodyA.vertices().row(vertex_id).transpose());
     query["vertex"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyA_id].position);
     query["vertex"]["pose_t0"]["rotation"] =
@@ -101,11 +101,11 @@ void save_ccd_candidate(
 
     query["face"] = nlohmann::json();
     query["face"]["vertex0"] =
-        to_json(bodyB.vertices.row(bodyB.faces(face_id, 0)).transpose());
+        to_json(bodyB.vertices().row(bodyB.faces()(face_id, 0)).transpose());
     query["face"]["vertex1"] =
-        to_json(bodyB.vertices.row(bodyB.faces(face_id, 1)).transpose());
+        to_json(bodyB.vertices().row(bodyB.faces()(face_id, 1)).transpose());
     query["face"]["vertex2"] =
-        to_json(bodyB.vertices.row(bodyB.faces(face_id, 2)).transpose());
+        to_json(bodyB.vertices().row(bodyB.faces()(face_id, 2)).transpose());
     query["face"]["pose_t0"] = nlohmann::json();
     query["face"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyB_id].position);
@@ -119,7 +119,7 @@ void save_ccd_candidate(
 
     query["vertex"] = nlohmann::json();
     query["vertex"]["vertex"] =
-        to_json(bodyA.vertices.row(vertex_id).transpose());
+        to_json(bodyA.vertices().row(vertex_id).transpose());
     query["vertex"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyA_id].position);
     query["vertex"]["pose_t0"]["rotation"] =
@@ -149,9 +149,9 @@ void save_ccd_candidate(
 
     query["edge0"] = nlohmann::json();
     query["edge0"]["vertex0"] =
-        to_json(bodyA.vertices.row(bodyA.edges(edgeA_id, 0)).transpose());
+        to_json(bodyA.vertices().row(bodyA.edges()(edgeA_id, 0)).transpose());
     query["edge0"]["vertex1"] =
-        to_json(bodyA.vertices.row(bodyA.edges(edgeA_id, 1)).transpose());
+        to_json(bodyA.vertices().row(bodyA.edges()(edgeA_id, 1)).transpose());
     query["edge0"]["pose_t0"] = nlohmann::json();
     query["edge0"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyA_id].position);
@@ -165,9 +165,9 @@ void save_ccd_candidate(
 
     query["edge1"] = nlohmann::json();
     query["edge1"]["vertex0"] =
-        to_json(bodyB.vertices.row(bodyB.edges(edgeB_id, 0)).transpose());
+        to_json(bodyB.vertices().row(bodyB.edges()(edgeB_id, 0)).transpose());
     query["edge1"]["vertex1"] =
-        to_json(bodyB.vertices.row(bodyB.edges(edgeB_id, 1)).transpose());
+        to_json(bodyB.vertices().row(bodyB.edges()(edgeB_id, 1)).transpose());
     query["edge1"]["pose_t0"] = nlohmann::json();
     query["edge1"]["pose_t0"]["position"] =
         to_json(poses_t0[bodyB_id].position);
@@ -0,0 +1,123 @@
+#include "checkpoint.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <random>
+
+#include <fmt/format.h>
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+bool CheckpointBuffer::load(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        spdlog::error("Unable to open checkpoint file: {}", filename);
+        return false;
+    }
+    m_data.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(m_data.data(), m_data.size());
+    m_position = 0;
+    m_good = bool(file);
+    return m_good;
+}
+
+bool CheckpointBuffer::save(const std::string& filename) const
+{
+    // Write to a temporary file first so a crash never leaves a partially
+    // written checkpoint behind. The name is unique to this process (random
+    // tag) and call (counter), so concurrent writers of the same file (e.g.,
+    // processes sharing a mesh cache) never write to the same temporary file.
+    static const uint32_t process_tag = std::random_device()();
+    static std::atomic<uint64_t> counter(0);
+    std::string tmp_filename =
+        fmt::format("{}.{:08x}.{}.tmp", filename, process_tag, counter++);
+    std::error_code ec;
+    {
+        std::ofstream file(tmp_filename, std::ios::binary | std::ios::trunc);
+        file.write(m_data.data(), m_data.size());
+        if (!file) {
+            spdlog::error("Unable to write checkpoint file: {}", filename);
+            file.close();
+            fs::remove(tmp_filename, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp_filename, filename, ec);
+    if (ec) {
+        std::error_code remove_ec;
+        fs::remove(tmp_filename, remove_ec);
+        spdlog::error(
+            "Unable to write checkpoint file: {} ({})", filename, ec.message());
+        return false;
+    }
+    return true;
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void CheckpointWriter::write(
+    const std::string& filename,
+    CheckpointBuffer&& checkpoint,
+    std::function<bool()> is_ready)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(
+            { filename, std::move(checkpoint), std::move(is_ready) });
+        if (!m_thread.joinable()) {
+            m_thread = std::thread(&CheckpointWriter::run, this);
+        }
+    }
+    m_condition.notify_all();
+}
+
+void CheckpointWriter::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [&] { return m_queue.empty() && !m_is_writing; });
+}
+
+void CheckpointWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            return; // Stopped with nothing left to write
+        }
+
+        QueuedCheckpoint queued = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_is_writing = true;
+
+        lock.unlock();
+        if (queued.is_ready && !queued.is_ready()) {
+            spdlog::error(
+                "Checkpoint references data that was never written: {}",
+                queued.filename);
+        } else if (queued.checkpoint.save(queued.filename)) {
+            spdlog::info("Simulation checkpoint saved to {}", queued.filename);
+        }
+        lock.lock();
+
+        m_is_writing = false;
+        m_condition.notify_all();
+    }
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+namespace checkpoint {
+    /// @brief Header of a simulation checkpoint file.
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t dim;
+        uint64_t num_bodies;
+        uint64_t num_simulation_steps;
+        uint64_t num_states; ///< Number of states in the trajectory
+        double timestep;
+        double adaptive_timestep; ///< Current substep size
+    };
+    static_assert(sizeof(Header) == 56, "Unexpected padding");
+
+    static const char MAGIC[8] = "RIPCCKP";
+    static const uint32_t VERSION = 1;
+} // namespace checkpoint
+
+/**
+ * @brief Binary buffer of the state needed to restart a simulation.
+ *
+ * Values are stored back to back in native byte order. Matrices are stored
+ * as their number of rows and columns followed by their col-major
+ * coefficients, and vectors as their size followed by their elements.
+ * Reading past the end (or a matrix that does not fit) marks the buffer as
+ * bad instead of throwing.
+ */
+class CheckpointBuffer {
+public:
+    CheckpointBuffer() = default;
+    /// @brief Read from a copy of bytes.
+    CheckpointBuffer(const char* data, size_t size)
+        : m_data(data, data + size)
+    {
+    }
+
+    /// @brief Read a checkpoint file.
+    bool load(const std::string& filename);
+    /// @brief Write the checkpoint to a file (replacing it atomically).
+    bool save(const std::string& filename) const;
+
+    const std::vector<char>& data() const { return m_data; }
+    /// @brief Have all reads so far succeeded?
+    bool good() const { return m_good; }
+
+    template <typename T> void write_value(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T> T read_value()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        T value {};
+        if (m_good && m_position + sizeof(T) <= m_data.size()) {
+            std::memcpy(&value, m_data.data() + m_position, sizeof(T));
+            m_position += sizeof(T);
+        } else {
+            m_good = false;
+        }
+        return value;
+    }
+
+    template <typename Derived>
+    void write_matrix(const Eigen::MatrixBase<Derived>& matrix)
+    {
+        using Scalar = typename Derived::Scalar;
+        write_value<int64_t>(matrix.rows());
+        write_value<int64_t>(matrix.cols());
+        for (Eigen::Index j = 0; j < matrix.cols(); j++) {
+            for (Eigen::Index i = 0; i < matrix.rows(); i++) {
+                write_value<Scalar>(matrix(i, j));
+            }
+        }
+    }
+
+    template <typename Derived>
+    void read_matrix(Eigen::PlainObjectBase<Derived>& matrix)
+    {
+        using Scalar = typename Derived::Scalar;
+        const int64_t rows = read_value<int64_t>();
+        const int64_t cols = read_value<int64_t>();
+        if (!m_good || rows < 0 || cols < 0
+            || !fits(rows, Derived::RowsAtCompileTime,
+                     Derived::MaxRowsAtCompileTime)
+            || !fits(cols, Derived::ColsAtCompileTime,
+                     Derived::MaxColsAtCompileTime)
+            || m_position + rows * cols * sizeof(Scalar) > m_data.size()) {
+            m_good = false;
+            return;
+        }
+        matrix.resize(rows, cols);
+        for (Eigen::Index j = 0; j < cols; j++) {
+            for (Eigen::Index i = 0; i < rows; i++) {
+                matrix(i, j) = read_value<Scalar>();
+            }
+        }
+    }
+
+    template <typename T> void write_vector(const std::vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        write_value<uint64_t>(v.size());
+        const char* bytes = reinterpret_cast<const char*>(v.data());
+        m_data.insert(m_data.end(), bytes, bytes + v.size() * sizeof(T));
+    }
+
+    template <typename T> void read_vector(std::vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        const uint64_t size = read_value<uint64_t>();
+        if (!m_good || size > (m_data.size() - m_position) / sizeof(T)) {
+            m_good = false;
+            return;
+        }
+        v.resize(size);
+        std::memcpy(v.data(), m_data.data() + m_position, size * sizeof(T));
+        m_position += size * sizeof(T);
+    }
+
+    void write_pose(const PoseD& pose)
+    {
+        write_matrix(pose.position);
+        write_matrix(pose.rotation);
+    }
+
+    void read_pose(PoseD& pose)
+    {
+        read_matrix(pose.position);
+        read_matrix(pose.rotation);
+    }
+
+    void write_string(const std::string& s)
+    {
+        write_value<uint64_t>(s.size());
+        m_data.insert(m_data.end(), s.begin(), s.end());
+    }
+
+    std::string read_string()
+    {
+        const uint64_t size = read_value<uint64_t>();
+        if (!m_good || m_position + size > m_data.size()) {
+            m_good = false;
+            return "";
+        }
+        std::string s(m_data.data() + m_position, size);
+        m_position += size;
+        return s;
+    }
+
+protected:
+    static bool fits(int64_t n, int size, int max_size)
+    {
+        return (size == Eigen::Dynamic || n == size)
+            && (max_size == Eigen::Dynamic || n <= max_size);
+    }
+
+    std::vector<char> m_data;
+    size_t m_position = 0; ///< Read position
+    bool m_good = true;
+};
+
+/**
+ * @brief Writes checkpoints on a background thread.
+ *
+ * Checkpoints are queued and written in order, so saving one never blocks
+ * the simulation on disk I/O.
+ */
+class CheckpointWriter {
+public:
+    CheckpointWriter() = default;
+    ~CheckpointWriter();
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Queue a checkpoint to be written to a file.
+     *
+     * @param is_ready  Called on the background thread before the checkpoint
+     *                  is saved, it can wait for the data the checkpoint
+     *                  references (e.g., the trajectory states) to be written.
+     *                  The checkpoint is dropped if it returns false.
+     */
+    void write(
+        const std::string& filename,
+        CheckpointBuffer&& checkpoint,
+        std::function<bool()> is_ready = nullptr);
+
+    /// @brief Wait for all queued checkpoints to be written.
+    void wait();
+
+protected:
+    void run();
+
+    struct QueuedCheckpoint {
+        std::string filename;
+        CheckpointBuffer checkpoint;
+        std::function<bool()> is_ready;
+    };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<QueuedCheckpoint> m_queue;
+    bool m_is_writing = false;
+    bool m_stop = false;
+};
+
+} // namespace ipc::rigid
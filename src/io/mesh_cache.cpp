@@ -0,0 +1,200 @@
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <fmt/format.h>
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/checkpoint.hpp>
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+namespace mesh_cache {
+    enum Type : uint32_t { MESH = 0, GEOMETRIES = 1 };
+
+    uint64_t hash(const void* data, size_t size, uint64_t seed)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < size; i++) {
+            h ^= bytes[i];
+            h *= 0x100000001b3;
+        }
+        return h;
+    }
+
+    /// @brief Write an entry (a header and its payload) to a file.
+    void save_entry(
+        const std::string& filename,
+        Type type,
+        uint64_t key,
+        const CheckpointBuffer& payload)
+    {
+        Header header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.type = type;
+        header.key = key;
+        header.payload_size = payload.data().size();
+        header.checksum = hash(payload.data().data(), payload.data().size());
+
+        std::vector<char> data(sizeof(Header) + payload.data().size());
+        std::memcpy(data.data(), &header, sizeof(Header));
+        std::copy(
+            payload.data().begin(), payload.data().end(),
+            data.begin() + sizeof(Header));
+        CheckpointBuffer(data.data(), data.size()).save(filename);
+    }
+
+    /// @brief Read the payload of an entry if it is complete and matches the
+    ///        type and key.
+    bool load_entry(
+        const std::string& filename,
+        Type type,
+        uint64_t key,
+        CheckpointBuffer& payload)
+    {
+        CheckpointBuffer buffer;
+        if (!fs::exists(filename) || !buffer.load(filename)) {
+            return false;
+        }
+        Header header = buffer.read_value<Header>();
+        if (!buffer.good()
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.version != VERSION || header.type != type
+            || header.key != key) {
+            return false;
+        }
+
+        const char* data = buffer.data().data() + sizeof(Header);
+        const size_t size = buffer.data().size() - sizeof(Header);
+        if (header.payload_size != size
+            || header.checksum != hash(data, size)) {
+            spdlog::warn("Corrupted mesh cache entry {}, rebuilding", filename);
+            return false;
+        }
+        payload = CheckpointBuffer(data, size);
+        return true;
+    }
+} // namespace mesh_cache
+
+MeshCache::MeshCache(const std::string& directory)
+    : m_directory(directory)
+{
+    if (enabled()) {
+        std::error_code ec;
+        fs::create_directories(m_directory, ec);
+        if (ec) {
+            spdlog::warn(
+                "Unable to create mesh cache directory {} ({}), disabling "
+                "the mesh cache",
+                m_directory, ec.message());
+            m_directory.clear();
+        }
+    }
+}
+
+bool MeshCache::hash_file(const std::string& filename, uint64_t& key)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    key = 0xcbf29ce484222325;
+    std::vector<char> chunk(size_t(1) << 16);
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        key = mesh_cache::hash(chunk.data(), size_t(file.gcount()), key);
+    }
+    return file.eof();
+}
+
+std::string MeshCache::filename(uint64_t key, const char* extension) const
+{
+    return (fs::path(m_directory) / fmt::format("{:016x}{}", key, extension))
+        .string();
+}
+
+bool MeshCache::load_mesh(
+    uint64_t key,
+    Eigen::MatrixXd& vertices,
+    Eigen::MatrixXi& edges,
+    Eigen::MatrixXi& faces) const
+{
+    CheckpointBuffer buffer;
+    if (!enabled()
+        || !mesh_cache::load_entry(
+            filename(key, ".mesh"), mesh_cache::MESH, key, buffer)) {
+        return false;
+    }
+    buffer.read_matrix(vertices);
+    buffer.read_matrix(edges);
+    buffer.read_matrix(faces);
+    return buffer.good();
+}
+
+void MeshCache::save_mesh(
+    uint64_t key,
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces) const
+{
+    if (!enabled()) {
+        return;
+    }
+    CheckpointBuffer buffer;
+    buffer.write_matrix(vertices);
+    buffer.write_matrix(edges);
+    buffer.write_matrix(faces);
+    mesh_cache::save_entry(
+        filename(key, ".mesh"), mesh_cache::MESH, key, buffer);
+}
+
+bool MeshCache::load_geometries(
+    uint64_t key,
+    std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries) const
+{
+    CheckpointBuffer buffer;
+    if (!enabled()
+        || !mesh_cache::load_entry(
+            filename(key, ".geom"), mesh_cache::GEOMETRIES, key, buffer)) {
+        return false;
+    }
+    uint64_t num_geometries = buffer.read_value<uint64_t>();
+    std::vector<std::shared_ptr<const RigidBodyGeometry>> loaded;
+    for (uint64_t i = 0; i < num_geometries && buffer.good(); i++) {
+        std::shared_ptr<const RigidBodyGeometry> geometry =
+            RigidBodyGeometry::read(buffer);
+        if (geometry == nullptr) {
+            return false;
+        }
+        loaded.push_back(geometry);
+    }
+    if (!buffer.good()) {
+        return false;
+    }
+    geometries = std::move(loaded);
+    return true;
+}
+
+void MeshCache::save_geometries(
+    uint64_t key,
+    const std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries)
+    const
+{
+    if (!enabled()) {
+        return;
+    }
+    CheckpointBuffer buffer;
+    buffer.write_value<uint64_t>(geometries.size());
+    for (const auto& geometry : geometries) {
+        geometry->write(buffer);
+    }
+    mesh_cache::save_entry(
+        filename(key, ".geom"), mesh_cache::GEOMETRIES, key, buffer);
+}
+
+} // namespace ipc::rigid
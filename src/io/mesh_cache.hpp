@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <physics/rigid_body_geometry.hpp>
+
+namespace ipc::rigid {
+
+namespace mesh_cache {
+    /// @brief Header of a mesh cache file.
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t type; ///< Mesh or geometries
+        uint64_t key;
+        uint64_t payload_size; ///< Number of bytes after the header
+        uint64_t checksum;     ///< Hash of the bytes after the header
+    };
+    static_assert(sizeof(Header) == 40, "Unexpected padding");
+
+    static const char MAGIC[8] = "RIPCMSH";
+    static const uint32_t VERSION = 2;
+
+    /// @brief Hash bytes (64-bit FNV-1a) starting from a previous hash.
+    uint64_t
+    hash(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325);
+} // namespace mesh_cache
+
+/**
+ * @brief On-disk cache of parsed meshes and processed rigid body geometry.
+ *
+ * Meshes are keyed by the hash of their file's content, so editing a mesh
+ * invalidates its entries. Geometries are keyed by the content hash and the
+ * processing parameters (scale, rotation, alignment, and component
+ * splitting). Each entry is a binary file in the cache directory. The BVHs
+ * are rebuilt from the cached vertices when loading.
+ *
+ * Entries are written to a unique temporary file and renamed, so several
+ * processes (or threads) can share a cache directory. Loading checks the
+ * size and checksum of an entry, and a truncated or corrupted entry is
+ * treated as missing (so it is rebuilt and saved again).
+ */
+class MeshCache {
+public:
+    /// @param directory  Directory of the cache (empty disables the cache)
+    explicit MeshCache(const std::string& directory = "");
+
+    bool enabled() const { return !m_directory.empty(); }
+
+    /// @brief Hash the content of a file.
+    static bool hash_file(const std::string& filename, uint64_t& key);
+
+    /// @brief Load a parsed mesh.
+    bool load_mesh(
+        uint64_t key,
+        Eigen::MatrixXd& vertices,
+        Eigen::MatrixXi& edges,
+        Eigen::MatrixXi& faces) const;
+    /// @brief Save a parsed mesh.
+    void save_mesh(
+        uint64_t key,
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& edges,
+        const Eigen::MatrixXi& faces) const;
+
+    /// @brief Load the geometries (one per component) of a processed mesh.
+    bool load_geometries(
+        uint64_t key,
+        std::vector<std::shared_ptr<const RigidBodyGeometry>>& geometries)
+        const;
+    /// @brief Save the geometries (one per component) of a processed mesh.
+    void save_geometries(
+        uint64_t key,
+        const std::vector<std::shared_ptr<const RigidBodyGeometry>>&
+            geometries) const;
+
+protected:
+    std::string filename(uint64_t key, const char* extension) const;
+
+    std::string m_directory;
+};
+
+} // namespace ipc::rigid
@@ -1,5 +1,8 @@
 #include "read_rb_scene.hpp"
 
+#include <algorithm>
+#include <map>
+#include <tuple>
 #include <unordered_set>
 
 #include <Eigen/Geometry>
@@ -9,8 +12,10 @@
 #include <igl/PI.h>
 #include <igl/read_triangle_mesh.h>
 #include <igl/remove_unreferenced.h>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
+#include <io/mesh_cache.hpp>
 #include <io/read_obj.hpp>
 #include <io/serialize_json.hpp>
 #include <logger.hpp>
@@ -53,13 +58,103 @@ VectorMax3d read_angular_field(const nlohmann::json& field, int dim)
     return v;
 }
 
+/// @brief Read a triangle mesh or an OBJ file with codimensional elements.
+bool read_mesh(
+    const std::string& filename,
+    Eigen::MatrixXd& vertices,
+    Eigen::MatrixXi& edges,
+    Eigen::MatrixXi& faces)
+{
+    spdlog::info("loading mesh: {:s}", filename);
+    bool success;
+    if (fs::path(filename).extension() == ".obj") {
+        success = read_obj(filename, vertices, edges, faces);
+    } else {
+        success = igl::read_triangle_mesh(filename, vertices, faces);
+        // Initialize edges
+        if (faces.size()) {
+            igl::edges(faces, edges);
+        }
+    }
+    assert(faces.size() == 0 || faces.cols() == 3);
+    return success;
+}
+
+/// @brief Transformed mesh to build the shared geometries of bodies from.
+struct GeometryTask {
+    Eigen::MatrixXd vertices; ///< Scaled and rotated vertices
+    Eigen::MatrixXi edges, faces;
+    bool align_to_principal_axes;
+    bool split_components;
+    /// @brief Key of the geometries in the mesh cache (0 if not cached)
+    uint64_t cache_key;
+    /// @brief Geometry of the mesh or one per connected component
+    std::vector<std::shared_ptr<const RigidBodyGeometry>> geometries;
+};
+
+void build_geometries(GeometryTask& task)
+{
+    if (!task.split_components) {
+        task.geometries.push_back(std::make_shared<const RigidBodyGeometry>(
+            task.vertices, task.edges, task.faces,
+            task.align_to_principal_axes));
+        return;
+    }
+
+    // TODO: Handle codimensional edges too
+    assert(task.faces.cols() == 3);
+    Eigen::VectorXi C;
+    igl::facet_components(task.faces, C);
+    int num_components = C.maxCoeff();
+    std::vector<std::vector<int>> CFs(num_components + 1);
+    for (int j = 0; j < task.faces.cols(); j++) {
+        for (int i = 0; i < task.faces.rows(); i++) {
+            CFs[C[i]].push_back(task.faces(i, j));
+        }
+    }
+
+    for (int ci = 0; ci < CFs.size(); ci++) {
+        Eigen::MatrixXi F = Eigen::Map<Eigen::MatrixXi>(
+            CFs[ci].data(), CFs[ci].size() / 3, 3);
+        Eigen::MatrixXd CV;
+        Eigen::MatrixXi CF;
+        Eigen::VectorXi I;
+        igl::remove_unreferenced(task.vertices, F, CV, CF, I);
+        Eigen::MatrixXi CE;
+        igl::edges(CF, CE);
+        task.geometries.push_back(std::make_shared<const RigidBodyGeometry>(
+            CV, CE, CF, task.align_to_principal_axes));
+    }
+}
+
+/// @brief Parsed arguments of a rigid body in the scene.
+struct RigidBodyArgs {
+    size_t geometry_task_id;
+    std::string name;
+    PoseD pose, velocity, force;
+    double density;
+    VectorXb is_dof_fixed;
+    bool is_oriented;
+    int group_id;
+    RigidBodyType type;
+    double kinematic_max_time;
+    std::deque<PoseD> kinematic_poses;
+};
+
 bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
 {
     using namespace nlohmann;
     int dim = -1, ndof, angular_dim;
 
-    std::unordered_map<std::string, int> rb_name_to_count;
+    // The scene is loaded in phases so the expensive parts (reading meshes
+    // and building the geometries) run in parallel while the bodies keep
+    // the order of the scene.
 
+    // 1. Merge the arguments of the enabled bodies with the defaults and
+    //    collect the unique meshes.
+    std::vector<json> body_args;
+    std::vector<std::string> mesh_filenames;
+    std::unordered_map<std::string, size_t> mesh_ids;
     for (auto& jrb : scene["rigid_bodies"]) {
         // NOTE:
         // All units by default are expressed in standard SI units
@@ -103,10 +198,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             continue;
         }
 
-        Eigen::MatrixXd vertices;
-        Eigen::MatrixXi faces, edges;
-        std::string rb_name;
-
         std::string mesh_fname = args["mesh"].get<std::string>();
         if (mesh_fname != "") {
             fs::path mesh_path(mesh_fname);
@@ -114,24 +205,67 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
                 // TODO: First check a path relative to the input file
                 mesh_path = fs::path(RIGID_IPC_MESHES_DIR) / mesh_path;
             }
-            spdlog::info("loading mesh: {:s}", mesh_path.string());
-            bool success;
-            if (mesh_path.extension() == ".obj") {
-                success = read_obj(mesh_path.string(), vertices, edges, faces);
-            } else {
-                success = igl::read_triangle_mesh(
-                    mesh_path.string(), vertices, faces);
-                // Initialize edges
-                if (faces.size()) {
-                    igl::edges(faces, edges);
-                }
-            }
-            assert(faces.size() == 0 || faces.cols() == 3);
-            if (!success) {
-                return false;
+            args["mesh"] = mesh_path.string();
+            if (mesh_ids.emplace(mesh_path.string(), mesh_filenames.size())
+                    .second) {
+                mesh_filenames.push_back(mesh_path.string());
             }
+        }
+
+        body_args.push_back(std::move(args));
+    }
+
+    // 2. Read each mesh once (or load it from the mesh cache).
+    MeshCache cache(
+        scene.contains("mesh_cache") ? scene["mesh_cache"].get<std::string>()
+                                     : "");
+    std::vector<Eigen::MatrixXd> mesh_vertices(mesh_filenames.size());
+    std::vector<Eigen::MatrixXi> mesh_edges(mesh_filenames.size()),
+        mesh_faces(mesh_filenames.size());
+    std::vector<uint64_t> mesh_hashes(mesh_filenames.size(), 0);
+    std::vector<char> mesh_read(mesh_filenames.size(), false);
+    tbb::parallel_for(size_t(0), mesh_filenames.size(), [&](size_t i) {
+        if (cache.enabled()
+            && MeshCache::hash_file(mesh_filenames[i], mesh_hashes[i])
+            && cache.load_mesh(
+                mesh_hashes[i], mesh_vertices[i], mesh_edges[i],
+                mesh_faces[i])) {
+            mesh_read[i] = true;
+            return;
+        }
+        mesh_read[i] = read_mesh(
+            mesh_filenames[i], mesh_vertices[i], mesh_edges[i], mesh_faces[i]);
+        if (mesh_read[i] && mesh_hashes[i] != 0) {
+            cache.save_mesh(
+                mesh_hashes[i], mesh_vertices[i], mesh_edges[i],
+                mesh_faces[i]);
+        }
+    });
+    if (std::find(mesh_read.begin(), mesh_read.end(), false)
+        != mesh_read.end()) {
+        return false;
+    }
 
-            rb_name = mesh_path.stem().string();
+    // 3. Parse the bodies' arguments. Bodies of the same mesh with the same
+    //    scale, rotation, and alignment share a single geometry (including
+    //    its BVH).
+    using GeometryKey =
+        std::tuple<std::string, std::vector<double>, bool, bool>;
+    std::map<GeometryKey, size_t> geometry_task_ids;
+    std::vector<GeometryTask> geometry_tasks;
+    std::vector<RigidBodyArgs> rbs_args;
+    rbs_args.reserve(body_args.size());
+    for (json& args : body_args) {
+        Eigen::MatrixXd vertices;
+        Eigen::MatrixXi faces, edges;
+        std::string rb_name, mesh_key = args["mesh"].get<std::string>();
+
+        if (mesh_key != "") {
+            size_t mesh_id = mesh_ids.at(mesh_key);
+            vertices = mesh_vertices[mesh_id];
+            edges = mesh_edges[mesh_id];
+            faces = mesh_faces[mesh_id];
+            rb_name = fs::path(mesh_key).stem().string();
         } else {
             // Assumes that edges contains the edges of the faces too.
             from_json(args["vertices"], vertices);
@@ -182,7 +316,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             assert(scale.size() >= dim);
             scale.conservativeResize(dim);
         }
-        vertices *= scale.asDiagonal();
 
         // Rotate around the models origin NOT the rigid bodies center of mass
         VectorMax3d rotation = read_angular_field(args["rotation"], dim);
@@ -195,7 +328,6 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
         } else {
             R = Eigen::Rotation2Dd(rotation(0)).toRotationMatrix();
         }
-        vertices = vertices * R.transpose();
         rotation.setZero(angular_dim); // Zero initial body rotation
 
         VectorMax3d linear_velocity;
@@ -243,45 +375,73 @@ bool read_rb_scene(const nlohmann::json& scene, std::vector<RigidBody>& rbs)
             kinematic_poses.push_back(pose);
         }
 
-        if (args["split_components"].get<bool>()) {
-            // TODO: Handle codimensional edges too
-            assert(faces.cols() == 3);
-            Eigen::VectorXi C;
-            igl::facet_components(faces, C);
-            int num_components = C.maxCoeff();
-            std::vector<std::vector<int>> CFs(num_components + 1);
-            for (int j = 0; j < faces.cols(); j++) {
-                for (int i = 0; i < faces.rows(); i++) {
-                    CFs[C[i]].push_back(faces(i, j));
-                }
+        bool split_components = args["split_components"].get<bool>();
+        bool align =
+            RigidBodyGeometry::align_to_principal_axes(dim, is_dof_fixed);
+
+        size_t geometry_task_id = geometry_tasks.size();
+        bool is_new_geometry = true;
+        uint64_t cache_key = 0;
+        if (!mesh_key.empty()) {
+            std::vector<double> transform(scale.data(), scale.data() + dim);
+            transform.insert(transform.end(), R.data(), R.data() + R.size());
+            auto inserted = geometry_task_ids.emplace(
+                GeometryKey(mesh_key, transform, align, split_components),
+                geometry_task_id);
+            geometry_task_id = inserted.first->second;
+            is_new_geometry = inserted.second;
+
+            uint64_t mesh_hash = mesh_hashes[mesh_ids.at(mesh_key)];
+            if (mesh_hash != 0) {
+                const bool flags[2] = { align, split_components };
+                cache_key = mesh_cache::hash(
+                    transform.data(), transform.size() * sizeof(double),
+                    mesh_cache::hash(flags, sizeof(flags), mesh_hash));
             }
+        }
 
-            for (int ci = 0; ci < CFs.size(); ci++) {
-                Eigen::MatrixXi F = Eigen::Map<Eigen::MatrixXi>(
-                    CFs[ci].data(), CFs[ci].size() / 3, 3);
-                Eigen::MatrixXd CV;
-                Eigen::MatrixXi CF;
-                Eigen::VectorXi I;
-                igl::remove_unreferenced(vertices, F, CV, CF, I);
-                Eigen::MatrixXi CE;
-                igl::edges(CF, CE);
-                // WARNING: angular velocity and torque will be around the
-                // components center of mass not the entire meshes.
-                rbs.emplace_back(
-                    CV, CE, CF, PoseD(position, VectorMax3d::Zero(angular_dim)),
-                    PoseD(linear_velocity, angular_velocity),
-                    PoseD(force, torque), density, is_dof_fixed, is_oriented,
-                    group_id, rb_type, kinematic_max_time, kinematic_poses);
-                rbs.back().name = fmt::format("{}-part{:03d}", rb_name, ci);
-            }
-        } else {
+        if (is_new_geometry) {
+            vertices *= scale.asDiagonal();
+            vertices = vertices * R.transpose();
+            geometry_tasks.push_back(GeometryTask {
+                vertices, edges, faces, align, split_components, cache_key });
+        }
+
+        rbs_args.push_back(RigidBodyArgs {
+            geometry_task_id, rb_name,
+            PoseD(position, VectorMax3d::Zero(angular_dim)),
+            PoseD(linear_velocity, angular_velocity), PoseD(force, torque),
+            density, is_dof_fixed, is_oriented, group_id, rb_type,
+            kinematic_max_time, kinematic_poses });
+    }
+
+    // 4. Center, align, and build the BVH of each unique geometry.
+    tbb::parallel_for(size_t(0), geometry_tasks.size(), [&](size_t i) {
+        GeometryTask& task = geometry_tasks[i];
+        if (task.cache_key != 0
+            && cache.load_geometries(task.cache_key, task.geometries)) {
+            return;
+        }
+        build_geometries(task);
+        if (task.cache_key != 0) {
+            cache.save_geometries(task.cache_key, task.geometries);
+        }
+    });
+
+    // 5. Create the bodies in the order of the scene.
+    for (const RigidBodyArgs& args : rbs_args) {
+        const GeometryTask& task = geometry_tasks[args.geometry_task_id];
+        for (int ci = 0; ci < task.geometries.size(); ci++) {
+            // WARNING: angular velocity and torque will be around the
+            // components center of mass not the entire meshes.
             rbs.emplace_back(
-                vertices, edges, faces,
-                PoseD(position, VectorMax3d::Zero(angular_dim)),
-                PoseD(linear_velocity, angular_velocity), PoseD(force, torque),
-                density, is_dof_fixed, is_oriented, group_id, rb_type,
-                kinematic_max_time, kinematic_poses);
-            rbs.back().name = rb_name;
+                task.geometries[ci], args.pose, args.velocity, args.force,
+                args.density, args.is_dof_fixed, args.is_oriented,
+                args.group_id, args.type, args.kinematic_max_time,
+                args.kinematic_poses);
+            rbs.back().name = task.split_components
+                ? fmt::format("{}-part{:03d}", args.name, ci)
+                : args.name;
         }
     }
 
@@ -0,0 +1,768 @@
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/checkpoint.hpp>
+#include <io/serialize_json.hpp>
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+////////////////////////////////////////////////////////////////////////////////
+// Writer
+
+bool TrajectoryWriter::open(
+    const std::string& filename,
+    int dim,
+    size_t num_bodies,
+    double timestep,
+    size_t chunk_bytes,
+    size_t max_pending_chunks)
+{
+    return open(
+        filename, dim, num_bodies, timestep, std::vector<char>(), chunk_bytes,
+        max_pending_chunks);
+}
+
+bool TrajectoryWriter::open(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    double timestep,
+    size_t chunk_bytes,
+    size_t max_pending_chunks)
+{
+    // Store each unique geometry once
+    std::unordered_map<const RigidBodyGeometry*, uint64_t> geometry_ids;
+    std::vector<const RigidBodyGeometry*> geometries;
+    for (const RigidBody& body : bodies.m_rbs) {
+        if (geometry_ids.emplace(body.geometry.get(), geometries.size())
+                .second) {
+            geometries.push_back(body.geometry.get());
+        }
+    }
+
+    CheckpointBuffer table;
+    table.write_value<uint64_t>(geometries.size());
+    for (const RigidBodyGeometry* geometry : geometries) {
+        geometry->write(table);
+    }
+    for (const RigidBody& body : bodies.m_rbs) {
+        table.write_value<uint64_t>(geometry_ids[body.geometry.get()]);
+        table.write_string(body.name);
+        table.write_value<int32_t>(int32_t(body.type));
+        table.write_value<int32_t>(body.group_id);
+        table.write_value(body.is_oriented);
+        table.write_matrix(body.is_dof_fixed);
+    }
+
+    return open(
+        filename, bodies.dim(), bodies.num_bodies(), timestep, table.data(),
+        chunk_bytes, max_pending_chunks);
+}
+
+bool TrajectoryWriter::open(
+    const std::string& filename,
+    int dim,
+    size_t num_bodies,
+    double timestep,
+    const std::vector<char>& mesh_table,
+    size_t chunk_bytes,
+    size_t max_pending_chunks)
+{
+    close();
+
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        spdlog::error("Unable to create trajectory file: {}", filename);
+        return false;
+    }
+    m_filename = filename;
+
+    std::memcpy(m_header.magic, trajectory::HEADER_MAGIC, 8);
+    m_header.version = trajectory::VERSION;
+    m_header.dim = uint32_t(dim);
+    m_header.num_bodies = num_bodies;
+    m_header.record_size = trajectory::record_size(dim);
+    m_header.timestep = timestep;
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+
+    // Pad the mesh table so the records of the chunks are aligned in the file
+    // (and in its memory map)
+    trajectory::MeshTable table_header;
+    std::memcpy(table_header.magic, trajectory::MESH_TABLE_MAGIC, 8);
+    const size_t table_offset = sizeof(m_header) + sizeof(table_header);
+    const size_t padding = (trajectory::ALIGNMENT
+                            - (table_offset + mesh_table.size())
+                                % trajectory::ALIGNMENT)
+        % trajectory::ALIGNMENT;
+    table_header.size = mesh_table.size() + padding;
+    m_file.write(
+        reinterpret_cast<const char*>(&table_header), sizeof(table_header));
+    m_file.write(mesh_table.data(), mesh_table.size());
+    m_file.write(std::string(padding, '\0').data(), padding);
+    m_offset = table_offset + table_header.size;
+
+    m_chunks.clear();
+    m_num_frames = 0;
+    start(chunk_bytes, max_pending_chunks);
+
+    return bool(m_file);
+}
+
+bool TrajectoryWriter::reopen(
+    const std::string& filename,
+    size_t num_frames,
+    size_t chunk_bytes,
+    size_t max_pending_chunks)
+{
+    close();
+
+    TrajectoryReader reader;
+    if (!reader.open(filename, num_frames)) {
+        return false;
+    }
+    if (reader.num_frames() != num_frames) {
+        spdlog::error(
+            "Trajectory file has fewer than {} frames: {}", num_frames,
+            filename);
+        return false;
+    }
+    m_header = reader.header();
+    const size_t frame_bytes =
+        m_header.num_bodies * m_header.record_size * sizeof(double);
+
+    // Keep the chunks of the first frames (the last one possibly shortened)
+    m_chunks.clear();
+    m_offset = reader.chunks_offset();
+    bool is_last_chunk_shortened = false;
+    for (const trajectory::Chunk& chunk : reader.chunks()) {
+        if (chunk.first_frame >= num_frames) {
+            break;
+        }
+        m_chunks.push_back(chunk);
+        if (chunk.first_frame + chunk.num_frames > num_frames) {
+            m_chunks.back().num_frames = num_frames - chunk.first_frame;
+            is_last_chunk_shortened = true;
+        }
+        m_offset = chunk.offset + sizeof(chunk)
+            + m_chunks.back().num_frames * frame_bytes;
+    }
+    reader.close();
+
+    if (is_last_chunk_shortened) {
+        std::fstream file(
+            filename, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(m_chunks.back().offset);
+        file.write(
+            reinterpret_cast<const char*>(&m_chunks.back()),
+            sizeof(trajectory::Chunk));
+        if (!file) {
+            spdlog::error("Unable to write to trajectory file: {}", filename);
+            return false;
+        }
+    }
+    // Drop the later frames and the index
+    std::error_code ec;
+    fs::resize_file(filename, m_offset, ec);
+    if (ec) {
+        spdlog::error(
+            "Unable to truncate trajectory file: {} ({})", filename,
+            ec.message());
+        return false;
+    }
+
+    m_file.open(filename, std::ios::binary | std::ios::app);
+    if (!m_file) {
+        spdlog::error("Unable to open trajectory file: {}", filename);
+        return false;
+    }
+    m_filename = filename;
+
+    m_num_frames = num_frames;
+    start(chunk_bytes, max_pending_chunks);
+
+    return bool(m_file);
+}
+
+void TrajectoryWriter::start(size_t chunk_bytes, size_t max_pending_chunks)
+{
+    const size_t record_values = m_header.num_bodies * m_header.record_size;
+    size_t frame_bytes = std::max(record_values * sizeof(double), size_t(1));
+    m_frames_per_chunk = std::max(chunk_bytes / frame_bytes, size_t(1));
+    m_buffer.clear();
+    m_buffer.reserve(m_frames_per_chunk * record_values);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // The frames before are already in the file
+        m_num_durable_frames = m_num_frames;
+        m_stop = false;
+    }
+    m_max_pending_chunks = max_pending_chunks;
+    if (m_max_pending_chunks > 0) {
+        m_thread = std::thread(&TrajectoryWriter::run, this);
+    }
+}
+
+void TrajectoryWriter::append(const RigidBodyAssembler& bodies)
+{
+    assert(is_open());
+    assert(bodies.num_bodies() == m_header.num_bodies);
+    assert(bodies.dim() == int(m_header.dim));
+
+    const size_t start = m_buffer.size();
+    m_buffer.resize(start + m_header.num_bodies * m_header.record_size);
+    double* record = m_buffer.data() + start;
+    for (const RigidBody& body : bodies.m_rbs) {
+        const auto copy = [&](const auto& values) {
+            std::copy_n(values.data(), values.size(), record);
+            record += values.size();
+        };
+        copy(body.pose.position);
+        copy(body.pose.rotation);
+        copy(body.velocity.position);
+        copy(body.velocity.rotation);
+        if (m_header.dim == 3) {
+            copy(body.Qdot);
+            copy(body.Qddot);
+        }
+    }
+    assert(record == m_buffer.data() + m_buffer.size());
+
+    if (++m_num_frames % m_frames_per_chunk == 0) {
+        submit_chunk();
+    }
+}
+
+void TrajectoryWriter::append(const double* records)
+{
+    assert(is_open());
+    m_buffer.insert(
+        m_buffer.end(), records,
+        records + m_header.num_bodies * m_header.record_size);
+    if (++m_num_frames % m_frames_per_chunk == 0) {
+        submit_chunk();
+    }
+}
+
+void TrajectoryWriter::submit_chunk()
+{
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    trajectory::Chunk chunk;
+    std::memcpy(chunk.magic, trajectory::CHUNK_MAGIC, 8);
+    chunk.num_frames =
+        m_buffer.size() / (m_header.num_bodies * m_header.record_size);
+    chunk.first_frame = m_num_frames - chunk.num_frames;
+    chunk.offset = m_offset;
+    m_offset += sizeof(chunk) + m_buffer.size() * sizeof(double);
+    m_chunks.push_back(chunk);
+
+    if (m_max_pending_chunks == 0) {
+        write_chunk(chunk, m_buffer);
+        mark_durable(chunk);
+        m_buffer.clear();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Backpressure: wait for the I/O thread to catch up
+    m_condition.wait(
+        lock, [&] { return m_pending.size() < m_max_pending_chunks; });
+    std::vector<double> buffer;
+    if (!m_free_buffers.empty()) {
+        buffer = std::move(m_free_buffers.back());
+        m_free_buffers.pop_back();
+    } else {
+        buffer.reserve(m_buffer.capacity());
+    }
+    m_pending.emplace_back(chunk, std::move(m_buffer));
+    m_buffer = std::move(buffer);
+    lock.unlock();
+    m_condition.notify_all();
+}
+
+void TrajectoryWriter::write_chunk(
+    const trajectory::Chunk& chunk, const std::vector<double>& records)
+{
+    m_file.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+    m_file.write(
+        reinterpret_cast<const char*>(records.data()),
+        records.size() * sizeof(double));
+    m_file.flush();
+    if (!m_file) {
+        spdlog::error("Unable to write to trajectory file: {}", m_filename);
+    }
+}
+
+void TrajectoryWriter::mark_durable(const trajectory::Chunk& chunk)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_num_durable_frames = chunk.first_frame + chunk.num_frames;
+    }
+    m_condition.notify_all();
+}
+
+void TrajectoryWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_condition.wait(lock, [&] { return m_stop || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            return; // Stopped with nothing left to write
+        }
+
+        // Keep the chunk in the queue while writing it so flush() waits
+        std::pair<trajectory::Chunk, std::vector<double>>& pending =
+            m_pending.front();
+        lock.unlock();
+        write_chunk(pending.first, pending.second);
+        lock.lock();
+
+        m_num_durable_frames =
+            pending.first.first_frame + pending.first.num_frames;
+        pending.second.clear();
+        m_free_buffers.push_back(std::move(pending.second));
+        m_pending.pop_front();
+        m_condition.notify_all();
+    }
+}
+
+void TrajectoryWriter::flush()
+{
+    if (!is_open()) {
+        return;
+    }
+
+    submit_chunk();
+    if (m_max_pending_chunks > 0) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [&] { return m_pending.empty(); });
+    }
+
+    m_file.flush();
+    if (!m_file) {
+        spdlog::error("Unable to write to trajectory file: {}", m_filename);
+    }
+}
+
+size_t TrajectoryWriter::num_durable_frames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_durable_frames;
+}
+
+bool TrajectoryWriter::wait_durable(size_t num_frames)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(
+        lock, [&] { return m_num_durable_frames >= num_frames || m_stop; });
+    return m_num_durable_frames >= num_frames;
+}
+
+void TrajectoryWriter::close()
+{
+    if (!is_open()) {
+        return;
+    }
+
+    flush();
+    // Also wakes up the threads waiting for frames to be written
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    trajectory::Footer footer;
+    footer.index_offset = m_offset;
+    footer.num_chunks = m_chunks.size();
+    footer.num_frames = m_num_frames;
+    std::memcpy(footer.magic, trajectory::FOOTER_MAGIC, 8);
+    m_file.write(
+        reinterpret_cast<const char*>(m_chunks.data()),
+        m_chunks.size() * sizeof(trajectory::Chunk));
+    m_file.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    m_file.close();
+
+    m_chunks.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reader
+
+bool TrajectoryReader::open(const std::string& filename, size_t max_num_frames)
+{
+    close();
+    m_filename = filename;
+
+#if defined(_WIN32)
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        spdlog::error("Unable to open trajectory file: {}", filename);
+        return false;
+    }
+    m_buffer.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(m_buffer.data(), m_buffer.size());
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        spdlog::error("Unable to open trajectory file: {}", filename);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        spdlog::error("Invalid trajectory file: {}", filename);
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file open
+    if (data == MAP_FAILED) {
+        spdlog::error("Unable to map trajectory file: {}", filename);
+        return false;
+    }
+    m_data = static_cast<const char*>(data);
+    m_size = st.st_size;
+    m_is_mapped = true;
+#endif
+
+    if (m_size < sizeof(trajectory::Header)) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+    if (std::memcmp(m_header.magic, trajectory::HEADER_MAGIC, 8) != 0
+        || m_header.version != trajectory::VERSION
+        || m_header.record_size != trajectory::record_size(m_header.dim)) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+
+    size_t first_chunk_offset = sizeof(m_header);
+    trajectory::MeshTable table_header;
+    if (m_size < first_chunk_offset + sizeof(table_header)) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+    std::memcpy(
+        &table_header, m_data + first_chunk_offset, sizeof(table_header));
+    first_chunk_offset += sizeof(table_header);
+    if (std::memcmp(table_header.magic, trajectory::MESH_TABLE_MAGIC, 8) != 0
+        || table_header.size > m_size - first_chunk_offset) {
+        spdlog::error("Invalid trajectory file: {}", filename);
+        close();
+        return false;
+    }
+    m_mesh_table_offset = first_chunk_offset;
+    m_mesh_table_size = table_header.size;
+    first_chunk_offset += table_header.size;
+    const size_t frame_bytes =
+        m_header.num_bodies * m_header.record_size * sizeof(double);
+
+    // Read the index of a closed trajectory
+    trajectory::Footer footer;
+    bool has_index = false;
+    if (m_size >= first_chunk_offset + sizeof(footer)) {
+        std::memcpy(&footer, m_data + m_size - sizeof(footer), sizeof(footer));
+        has_index =
+            std::memcmp(footer.magic, trajectory::FOOTER_MAGIC, 8) == 0
+            && footer.index_offset
+                    + footer.num_chunks * sizeof(trajectory::Chunk)
+                    + sizeof(footer)
+                == m_size;
+    }
+    if (has_index) {
+        m_chunks.resize(footer.num_chunks);
+        std::memcpy(
+            m_chunks.data(), m_data + footer.index_offset,
+            m_chunks.size() * sizeof(trajectory::Chunk));
+    } else {
+        // Scan the chunks of an open (or truncated) trajectory
+        size_t offset = first_chunk_offset;
+        trajectory::Chunk chunk;
+        while (offset + sizeof(chunk) <= m_size) {
+            std::memcpy(&chunk, m_data + offset, sizeof(chunk));
+            size_t chunk_end =
+                offset + sizeof(chunk) + chunk.num_frames * frame_bytes;
+            if (std::memcmp(chunk.magic, trajectory::CHUNK_MAGIC, 8) != 0
+                || chunk.offset != offset || chunk_end > m_size) {
+                break; // Partially written chunk
+            }
+            m_chunks.push_back(chunk);
+            offset = chunk_end;
+        }
+    }
+
+    // The records are read in place, so they must be aligned (the file is
+    // mapped at a page boundary)
+    m_num_frames = 0;
+    for (const trajectory::Chunk& chunk : m_chunks) {
+        if (chunk.offset % trajectory::ALIGNMENT != 0) {
+            spdlog::error("Misaligned chunk in trajectory file: {}", filename);
+            close();
+            return false;
+        }
+        if (chunk.first_frame != m_num_frames) {
+            spdlog::error("Invalid trajectory file: {}", filename);
+            close();
+            return false;
+        }
+        m_num_frames += chunk.num_frames;
+    }
+    m_num_frames = std::min(m_num_frames, max_num_frames);
+
+    return true;
+}
+
+bool TrajectoryReader::open(
+    const nlohmann::json& results, const std::string& results_filename)
+{
+    const nlohmann::json& animation = results["animation"];
+    if (animation.contains("trajectory")) {
+        fs::path path = animation["trajectory"].get<std::string>();
+        if (path.is_relative()) {
+            path = fs::path(results_filename).parent_path() / path;
+        }
+        return open(
+            path.string(),
+            animation.value(
+                "num_states", std::numeric_limits<size_t>::max()));
+    }
+    return open(
+        animation["state_sequence"].get<std::vector<nlohmann::json>>(),
+        results["args"]["timestep"].get<double>());
+}
+
+bool TrajectoryReader::open(
+    const std::vector<nlohmann::json>& state_sequence, double timestep)
+{
+    close();
+    m_filename = "";
+    if (state_sequence.empty()) {
+        return false;
+    }
+
+    const nlohmann::json& jrbs0 = state_sequence[0]["rigid_bodies"];
+    const int dim = jrbs0.empty() ? 3 : int(jrbs0[0]["position"].size());
+    std::memcpy(m_header.magic, trajectory::HEADER_MAGIC, 8);
+    m_header.version = trajectory::VERSION;
+    m_header.dim = uint32_t(dim);
+    m_header.num_bodies = jrbs0.size();
+    m_header.record_size = trajectory::record_size(dim);
+    m_header.timestep = timestep;
+
+    const size_t frame_size = m_header.num_bodies * m_header.record_size;
+    trajectory::Chunk chunk;
+    std::memcpy(chunk.magic, trajectory::CHUNK_MAGIC, 8);
+    chunk.first_frame = 0;
+    chunk.num_frames = state_sequence.size();
+    chunk.offset = 0;
+    m_chunks.push_back(chunk);
+
+    m_buffer.resize(sizeof(chunk) + chunk.num_frames * frame_size * 8);
+    double* record = reinterpret_cast<double*>(m_buffer.data() + sizeof(chunk));
+    for (const nlohmann::json& state : state_sequence) {
+        const nlohmann::json& jrbs = state["rigid_bodies"];
+        if (jrbs.size() != m_header.num_bodies) {
+            spdlog::error("Inconsistent number of bodies in state sequence");
+            close();
+            return false;
+        }
+        for (const nlohmann::json& jrb : jrbs) {
+            const auto copy = [&](const nlohmann::json& jvalues, int n) {
+                VectorMax3d values;
+                from_json(jvalues, values);
+                assert(values.size() == n);
+                std::copy_n(values.data(), n, record);
+                record += n;
+            };
+            const auto copy_matrix = [&](const char* key) {
+                Eigen::Matrix3d M = Eigen::Matrix3d::Zero();
+                if (jrb.contains(key)) {
+                    from_json(jrb[key], M);
+                }
+                std::copy_n(M.data(), M.size(), record);
+                record += M.size();
+            };
+            copy(jrb["position"], PoseD::dim_to_pos_ndof(dim));
+            copy(jrb["rotation"], PoseD::dim_to_rot_ndof(dim));
+            copy(jrb["linear_velocity"], PoseD::dim_to_pos_ndof(dim));
+            copy(jrb["angular_velocity"], PoseD::dim_to_rot_ndof(dim));
+            if (dim == 3) {
+                copy_matrix("Qdot");
+                copy_matrix("Qddot");
+            }
+        }
+    }
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    m_num_frames = chunk.num_frames;
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+#if !defined(_WIN32)
+    if (m_is_mapped && m_data != nullptr) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_is_mapped = false;
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_chunks.clear();
+    m_num_frames = 0;
+    m_mesh_table_offset = 0;
+    m_mesh_table_size = 0;
+}
+
+const double* TrajectoryReader::frame(size_t i) const
+{
+    assert(i < m_num_frames);
+    // Find the last chunk starting at or before frame i
+    auto chunk = std::upper_bound(
+        m_chunks.begin(), m_chunks.end(), i,
+        [](size_t i, const trajectory::Chunk& chunk) {
+            return i < chunk.first_frame;
+        });
+    assert(chunk != m_chunks.begin());
+    --chunk;
+    const size_t frame_size = m_header.num_bodies * m_header.record_size;
+    return reinterpret_cast<const double*>(
+               m_data + chunk->offset + sizeof(trajectory::Chunk))
+        + (i - chunk->first_frame) * frame_size;
+}
+
+PosesD TrajectoryReader::poses(size_t i) const
+{
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim());
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim());
+    typedef Eigen::Map<const Eigen::VectorXd> MapVector;
+
+    const double* record = frame(i);
+    PosesD poses;
+    poses.reserve(num_bodies());
+    for (size_t j = 0; j < num_bodies(); j++) {
+        poses.emplace_back(
+            VectorMax3d(MapVector(record, pos_ndof)),
+            VectorMax3d(MapVector(record + pos_ndof, rot_ndof)));
+        record += record_size();
+    }
+    return poses;
+}
+
+nlohmann::json TrajectoryReader::state(size_t i) const
+{
+    StateSnapshot snapshot;
+    state(i, snapshot);
+    return snapshot.to_json();
+}
+
+void TrajectoryReader::state(size_t i, StateSnapshot& snapshot) const
+{
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim());
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim());
+    typedef Eigen::Map<const Eigen::VectorXd> MapVector;
+
+    snapshot.resize(dim(), num_bodies());
+    snapshot.has_diagnostics = false;
+    snapshot.min_distance = -1;
+
+    const double* record = frame(i);
+    for (size_t j = 0; j < num_bodies(); j++) {
+        const double* values = record;
+        snapshot.positions.col(j) = MapVector(values, pos_ndof);
+        values += pos_ndof;
+        snapshot.rotations.col(j) = MapVector(values, rot_ndof);
+        values += rot_ndof;
+        snapshot.linear_velocities.col(j) = MapVector(values, pos_ndof);
+        values += pos_ndof;
+        snapshot.angular_velocities.col(j) = MapVector(values, rot_ndof);
+        values += rot_ndof;
+        if (dim() == 3) {
+            snapshot.Qdots.col(j) = MapVector(values, 9);
+            values += 9;
+            snapshot.Qddots.col(j) = MapVector(values, 9);
+        }
+        record += record_size();
+    }
+}
+
+bool TrajectoryReader::bodies(std::vector<RigidBody>& rbs) const
+{
+    if (!has_meshes()) {
+        return false;
+    }
+
+    CheckpointBuffer table(m_data + m_mesh_table_offset, m_mesh_table_size);
+    const uint64_t num_geometries = table.read_value<uint64_t>();
+    std::vector<std::shared_ptr<const RigidBodyGeometry>> geometries;
+    for (uint64_t i = 0; i < num_geometries && table.good(); i++) {
+        std::shared_ptr<const RigidBodyGeometry> geometry =
+            RigidBodyGeometry::read(table);
+        if (geometry == nullptr || geometry->dim() != dim()) {
+            return false;
+        }
+        geometries.push_back(geometry);
+    }
+
+    const PoseD zero = PoseD::Zero(dim());
+    PosesD poses0 = num_frames() > 0 ? poses(0) : PosesD();
+    std::vector<RigidBody> loaded;
+    loaded.reserve(num_bodies());
+    for (size_t i = 0; i < num_bodies(); i++) {
+        const uint64_t geometry_id = table.read_value<uint64_t>();
+        std::string name = table.read_string();
+        const auto type = RigidBodyType(table.read_value<int32_t>());
+        const int group_id = table.read_value<int32_t>();
+        const bool is_oriented = table.read_value<bool>();
+        VectorMax6b is_dof_fixed;
+        table.read_matrix(is_dof_fixed);
+        if (!table.good() || geometry_id >= geometries.size()
+            || is_dof_fixed.size() != zero.ndof()) {
+            return false;
+        }
+
+        loaded.emplace_back(
+            geometries[geometry_id], zero, zero, zero, /*density=*/1.0,
+            is_dof_fixed, is_oriented, group_id, type);
+        RigidBody& rb = loaded.back();
+        rb.name = name;
+        // The recorded poses already include the center of mass and R₀
+        if (!poses0.empty()) {
+            rb.pose = rb.pose_prev = poses0[i];
+        }
+    }
+
+    rbs = std::move(loaded);
+    return true;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <physics/pose.hpp>
+#include <physics/rigid_body_assembler.hpp>
+#include <physics/state_snapshot.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Binary trajectory of the states of a rigid body simulation.
+ *
+ * The file is append-only and laid out as
+ *
+ *     header | mesh table | chunk₀ | chunk₁ | ... | index | footer
+ *
+ * The mesh table stores the body-space geometry of each unique mesh and,
+ * per body, its geometry, name, type, group, and fixed DoF, so the bodies
+ * can be rebuilt without the scene (e.g., for post-processing). It is empty
+ * if the trajectory was written without the bodies, and padded so the chunks
+ * start at a multiple of 8 bytes (readers reject misaligned chunks). Each
+ * chunk is a chunk header followed by the records of a run of consecutive
+ * frames. Every frame stores one fixed-size record of float64 values per body:
+ *
+ *     position | rotation | linear velocity | angular velocity
+ *              | Qdot (3D only, 3×3 col-major) | Qddot (3D only)
+ *
+ * The index and footer are written when the trajectory is closed. A
+ * trajectory that was not closed (e.g., a simulation that is still running
+ * or crashed) is read by scanning the chunk headers instead.
+ *
+ * @note All values are stored in native (little-endian) byte order.
+ */
+namespace trajectory {
+    /// @brief File header.
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t dim;
+        uint64_t num_bodies;
+        uint64_t record_size; ///< Number of float64 values per body
+        double timestep;
+    };
+    static_assert(sizeof(Header) == 40, "Unexpected padding");
+
+    /// @brief Header of the mesh table.
+    struct MeshTable {
+        char magic[8];
+        uint64_t size; ///< Size of the (padded) table contents in bytes
+    };
+    static_assert(sizeof(MeshTable) == 16, "Unexpected padding");
+
+    /// @brief Header of a chunk of frames (also its entry in the index).
+    struct Chunk {
+        char magic[8];
+        uint64_t first_frame;
+        uint64_t num_frames;
+        uint64_t offset; ///< Offset of the chunk header in the file
+    };
+    static_assert(sizeof(Chunk) == 32, "Unexpected padding");
+
+    /// @brief File footer.
+    struct Footer {
+        uint64_t index_offset;
+        uint64_t num_chunks;
+        uint64_t num_frames;
+        char magic[8];
+    };
+    static_assert(sizeof(Footer) == 32, "Unexpected padding");
+
+    static const char HEADER_MAGIC[8] = "RIPCTRJ";
+    static const char MESH_TABLE_MAGIC[8] = "RIPCMTB";
+    static const char CHUNK_MAGIC[8] = "RIPCCHK";
+    static const char FOOTER_MAGIC[8] = "RIPCIDX";
+    static const uint32_t VERSION = 2;
+    /// @brief Alignment of the chunks in the file (so records can be read in
+    /// place).
+    static const size_t ALIGNMENT = alignof(double);
+
+    /// @brief Number of float64 values stored per body and frame.
+    inline size_t record_size(int dim) { return dim == 2 ? 6 : 30; }
+} // namespace trajectory
+
+/**
+ * @brief Append-only writer of a binary trajectory.
+ *
+ * Frames are copied into the current chunk buffer. Full chunks are either
+ * written immediately or, if there can be pending chunks, handed to an I/O
+ * thread so the simulation thread never waits on the disk (unless all
+ * pending chunk slots are full).
+ */
+class TrajectoryWriter {
+public:
+    TrajectoryWriter() = default;
+    ~TrajectoryWriter() { close(); }
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /**
+     * @brief Create a new trajectory file (overwriting any existing file).
+     *
+     * @param filename      Path of the trajectory file.
+     * @param dim           Spatial dimension of the bodies.
+     * @param num_bodies    Number of bodies in every frame.
+     * @param timestep      Time between frames.
+     * @param chunk_bytes   Frames are buffered and written in chunks of
+     *                      about this many bytes.
+     * @param max_pending_chunks  Number of full chunks that can wait for
+     *                            the I/O thread before append() blocks
+     *                            (0 writes chunks on the calling thread).
+     *
+     * @return Returns false if the file could not be created.
+     */
+    bool open(
+        const std::string& filename,
+        int dim,
+        size_t num_bodies,
+        double timestep,
+        size_t chunk_bytes = size_t(1) << 22,
+        size_t max_pending_chunks = 0);
+
+    /**
+     * @brief Create a new trajectory file storing the meshes of the bodies.
+     *
+     * @param filename  Path of the trajectory file.
+     * @param bodies    Bodies of every frame.
+     *
+     * @see open(const std::string&, int, size_t, double, size_t, size_t)
+     */
+    bool open(
+        const std::string& filename,
+        const RigidBodyAssembler& bodies,
+        double timestep,
+        size_t chunk_bytes = size_t(1) << 22,
+        size_t max_pending_chunks = 0);
+
+    /**
+     * @brief Reopen an existing trajectory file to append frames to it.
+     *
+     * The frames after the first num_frames ones and the index are
+     * discarded, so the header, mesh table, and kept frames are not
+     * rewritten.
+     *
+     * @param filename    Path of the trajectory file.
+     * @param num_frames  Number of frames to keep.
+     *
+     * @return Returns false if the file is not a valid trajectory with at
+     *         least num_frames frames.
+     *
+     * @see open(const std::string&, int, size_t, double, size_t, size_t)
+     */
+    bool reopen(
+        const std::string& filename,
+        size_t num_frames,
+        size_t chunk_bytes = size_t(1) << 22,
+        size_t max_pending_chunks = 0);
+
+    /// @brief Is the writer open?
+    bool is_open() const { return m_file.is_open(); }
+
+    /// @brief Append the current state of the bodies as a frame.
+    void append(const RigidBodyAssembler& bodies);
+    /// @brief Append a frame of records (num_bodies × record_size values).
+    void append(const double* records);
+
+    /// @brief Write the buffered frames to the file (waiting for the I/O
+    /// thread).
+    void flush();
+
+    /// @brief Write the buffered frames as a (possibly short) chunk, or
+    /// queue it for the I/O thread without waiting for it to be written.
+    /// Only blocks if max_pending_chunks chunks are already waiting.
+    void submit_chunk();
+
+    /// @brief Number of leading frames already written to the file (does
+    /// not block).
+    size_t num_durable_frames() const;
+    /**
+     * @brief Wait until the first frames are written to the file.
+     *
+     * Frames are written when their chunk is full, so this can wait for
+     * later appends (or submit_chunk(), flush(), or close()) on another
+     * thread.
+     *
+     * @return Returns false if the writer was closed before the frames were
+     *         written.
+     */
+    bool wait_durable(size_t num_frames);
+
+    /// @brief Write the buffered frames and the index, then close the file.
+    void close();
+
+    /// @brief Number of frames appended (including buffered frames).
+    size_t num_frames() const { return m_num_frames; }
+    const std::string& filename() const { return m_filename; }
+
+protected:
+    bool open(
+        const std::string& filename,
+        int dim,
+        size_t num_bodies,
+        double timestep,
+        const std::vector<char>& mesh_table,
+        size_t chunk_bytes,
+        size_t max_pending_chunks);
+
+    /// @brief Start buffering the frames after the first m_num_frames.
+    void start(size_t chunk_bytes, size_t max_pending_chunks);
+
+    /// @brief Write a chunk and hand it to the OS (not thread-safe).
+    void write_chunk(
+        const trajectory::Chunk& chunk, const std::vector<double>& records);
+    /// @brief Mark the frames up to the end of a chunk as written.
+    void mark_durable(const trajectory::Chunk& chunk);
+    /// @brief Body of the I/O thread.
+    void run();
+
+    std::ofstream m_file;
+    std::string m_filename;
+    trajectory::Header m_header;
+    std::vector<trajectory::Chunk> m_chunks;
+    /// @brief Records of the frames not yet written.
+    std::vector<double> m_buffer;
+    size_t m_frames_per_chunk = 1;
+    size_t m_num_frames = 0;
+    uint64_t m_offset = 0; ///< End of the file once all chunks are written
+
+    // I/O thread
+    size_t m_max_pending_chunks = 0;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    /// @brief Chunks waiting to be written (the front one is being written).
+    std::deque<std::pair<trajectory::Chunk, std::vector<double>>> m_pending;
+    /// @brief Written chunk buffers reused to avoid allocations.
+    std::vector<std::vector<double>> m_free_buffers;
+    /// @brief Number of leading frames written to the file.
+    size_t m_num_durable_frames = 0;
+    bool m_stop = false;
+};
+
+/**
+ * @brief Reader of a binary trajectory.
+ *
+ * The file is memory mapped (where supported), so frames are only paged in
+ * when accessed.
+ */
+class TrajectoryReader {
+public:
+    TrajectoryReader() = default;
+    ~TrajectoryReader() { close(); }
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    /**
+     * @brief Open a trajectory file.
+     *
+     * @param filename        Path of the trajectory file.
+     * @param max_num_frames  Only read up to this many frames.
+     *
+     * @return Returns false if the file is not a valid trajectory.
+     */
+    bool open(
+        const std::string& filename,
+        size_t max_num_frames = std::numeric_limits<size_t>::max());
+
+    /**
+     * @brief Open the trajectory of saved simulation results.
+     *
+     * Supports both results referencing a trajectory file and older results
+     * storing a JSON state sequence (which is converted in memory).
+     *
+     * @param results           Saved simulation results.
+     * @param results_filename  Path of the results (trajectory paths are
+     *                          relative to it).
+     */
+    bool open(
+        const nlohmann::json& results, const std::string& results_filename);
+
+    /// @brief Read a JSON state sequence (converted in memory).
+    bool open(
+        const std::vector<nlohmann::json>& state_sequence, double timestep);
+
+    void close();
+
+    bool is_open() const { return m_data != nullptr; }
+
+    size_t num_frames() const { return m_num_frames; }
+    size_t num_bodies() const { return m_header.num_bodies; }
+    int dim() const { return int(m_header.dim); }
+    double timestep() const { return m_header.timestep; }
+    size_t record_size() const { return m_header.record_size; }
+    const std::string& filename() const { return m_filename; }
+
+    const trajectory::Header& header() const { return m_header; }
+    /// @brief Chunks of the file (including frames past max_num_frames).
+    const std::vector<trajectory::Chunk>& chunks() const { return m_chunks; }
+    /// @brief Offset of the first chunk in the file.
+    size_t chunks_offset() const
+    {
+        return m_mesh_table_offset + m_mesh_table_size;
+    }
+
+    /// @brief Records of a frame (num_bodies × record_size values).
+    const double* frame(size_t i) const;
+
+    /// @brief Poses of the bodies in a frame.
+    PosesD poses(size_t i) const;
+
+    /// @brief State of a frame in the format of RigidBodyProblem::state().
+    nlohmann::json state(size_t i) const;
+    /// @brief State of a frame (without momentum and energy).
+    void state(size_t i, StateSnapshot& snapshot) const;
+
+    /// @brief Does the trajectory store the meshes of the bodies?
+    bool has_meshes() const { return m_mesh_table_size > 0; }
+
+    /**
+     * @brief Rebuild the bodies from the mesh table.
+     *
+     * Bodies sharing a mesh share its geometry. The bodies are in the pose
+     * of the first frame. Only the geometry, name, type, group, and fixed
+     * DoF are stored, so the masses use a unit density.
+     *
+     * @return Returns false if the trajectory has no (valid) mesh table.
+     */
+    bool bodies(std::vector<RigidBody>& rbs) const;
+
+protected:
+    trajectory::Header m_header;
+    size_t m_mesh_table_offset = 0; ///< Offset of the mesh table contents
+    size_t m_mesh_table_size = 0;   ///< Size of the mesh table contents
+    std::vector<trajectory::Chunk> m_chunks;
+    size_t m_num_frames = 0;
+    std::string m_filename;
+
+    const char* m_data = nullptr; ///< Start of the file contents
+    size_t m_size = 0;            ///< Size of the file contents
+    bool m_is_mapped = false;     ///< Is m_data a memory map?
+    std::vector<char> m_buffer;   ///< Contents when not memory mapped
+};
+
+} // namespace ipc::rigid
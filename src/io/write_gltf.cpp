@@ -1,232 +1,636 @@
 #include "write_gltf.hpp"
 
-#define TINYGLTF_IMPLEMENTATION
-#define TINYGLTF_NO_INCLUDE_JSON
-#define TINYGLTF_NO_STB_IMAGE
-#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+#include <Eigen/Geometry>
 #include <nlohmann/json.hpp>
-#include <tiny_gltf.h>
+#include <tbb/parallel_for.h>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <logger.hpp>
 
 namespace ipc::rigid {
 
-bool write_gltf(
-    const std::string& filename,
-    const RigidBodyAssembler& bodies,
-    const std::vector<PosesD>& poses,
-    double timestep,
-    bool embed_buffers,
-    bool write_binary,
-    bool prettyPrint)
-{
-    typedef float Float;
-    int float_component_type;
-    if (std::is_same<Float, float>::value) {
-        float_component_type = TINYGLTF_COMPONENT_TYPE_FLOAT;
-    } else {
-        // assert(std::is_same<Float, double>::value);
-        float_component_type = TINYGLTF_COMPONENT_TYPE_DOUBLE;
-    }
+namespace {
+    // glTF constants
+    enum ComponentType : int {
+        SHORT = 5122,
+        UNSIGNED_INT = 5125,
+        FLOAT = 5126,
+    };
+    enum Mode : int { POINTS = 0, LINES = 1, TRIANGLES = 4 };
+    enum Target : int { ARRAY_BUFFER = 34962, ELEMENT_ARRAY_BUFFER = 34963 };
+
+    const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    const uint32_t GLB_JSON_CHUNK = 0x4E4F534A; // "JSON"
+    const uint32_t GLB_BIN_CHUNK = 0x004E4942;  // "BIN\0"
+
+    /// @brief Maximum number of poses read into memory at once (the bodies
+    /// are processed in groups of at most this many poses).
+    const size_t MAX_BUFFERED_POSES = size_t(1) << 20;
+
+    /// @brief Translations and rotations of a body in every frame.
+    struct Track {
+        std::vector<Eigen::Vector3d> positions;
+        std::vector<Eigen::Quaterniond> rotations;
 
-    using namespace tinygltf;
-
-    assert(bodies.dim() == 3);
-    size_t num_bodies = bodies.num_bodies();
-    assert(poses.size() > 0);
-    size_t num_steps = poses.size();
-
-    Model model;
-    model.defaultScene = 0;
-
-    model.asset.version = "2.0";
-    model.asset.generator = "RigidIPC";
-
-    Scene& scene = model.scenes.emplace_back();
-    scene.name = "RigidIPCSimulation";
-    scene.nodes.resize(num_bodies);
-    std::iota(scene.nodes.begin(), scene.nodes.end(), 0);
-
-    model.nodes.resize(num_bodies);
-    model.animations.resize(1);
-    Animation& animation = model.animations[0];
-    animation.name = "Simulation";
-    animation.channels.resize(2 * num_bodies);
-    animation.samplers.resize(2 * num_bodies);
-    model.meshes.resize(num_bodies);
-    // Four accessors per bidy: vertices, faces, translations, and rotations
-    model.accessors.resize(4 * num_bodies + 1);
+        size_t size() const { return positions.size(); }
+
+        void resize(size_t num_frames)
+        {
+            positions.resize(num_frames);
+            rotations.resize(num_frames);
+        }
+
+        /// @brief Keep consecutive rotations in the same hemisphere so
+        /// interpolating them takes the shortest path.
+        void make_continuous()
+        {
+            for (size_t j = 1; j < size(); j++) {
+                if (rotations[j].dot(rotations[j - 1]) < 0) {
+                    rotations[j].coeffs() *= -1;
+                }
+            }
+        }
+
+        /// @brief Is frame j within a fraction of the tolerances of frame k?
+        bool is_near(
+            size_t k, size_t j, double fraction, const GLTFOptions& options)
+            const
+        {
+            return (positions[j] - positions[k]).norm()
+                <= fraction * options.translation_tolerance
+                && rotations[j].angularDistance(rotations[k])
+                <= fraction * options.rotation_tolerance;
+        }
+    };
+
+    /**
+     * @brief Read the tracks of a group of consecutive bodies.
+     *
+     * The poses are read frame by frame, so the records of the group are
+     * read together instead of striding through every frame once per body.
+     */
+    template <typename PoseAt>
+    void read_tracks(
+        const PoseAt& pose_at,
+        size_t first_body,
+        size_t num_frames,
+        std::vector<Track>& tracks)
     {
-        Accessor& accessor = model.accessors[2 * num_bodies];
-        accessor.name = "Times";
-        accessor.bufferView = 2 * num_bodies;
-        accessor.componentType = float_component_type;
-        accessor.count = num_steps;
-        accessor.minValues.push_back(timestep);
-        accessor.maxValues.push_back(num_steps * timestep);
-        accessor.type = TINYGLTF_TYPE_SCALAR;
+        for (Track& track : tracks) {
+            track.resize(num_frames);
+        }
+        tbb::parallel_for(size_t(0), num_frames, [&](size_t j) {
+            Eigen::Vector3d r;
+            for (size_t i = 0; i < tracks.size(); i++) {
+                pose_at(j, first_body + i, tracks[i].positions[j], r);
+                tracks[i].rotations[j] = construct_quaternion(r);
+            }
+        });
+        tbb::parallel_for(size_t(0), tracks.size(), [&](size_t i) {
+            tracks[i].make_continuous();
+        });
     }
 
-    for (int i = 0; i < num_bodies; i++) {
-        Node& node = model.nodes[i];
-        node.mesh = i;
-        node.name = bodies[i].name;
-        node.translation = { { poses[0][i].position.x(),
-                               poses[0][i].position.y(),
-                               poses[0][i].position.z() } };
-        Eigen::Quaternion<double> q = poses[0][i].construct_quaternion();
-        node.rotation = { { q.x(), q.y(), q.z(), q.w() } };
-
-        animation.channels[2 * i + 0].sampler = 2 * i;
-        animation.channels[2 * i + 0].target_node = i;
-        animation.channels[2 * i + 0].target_path = "translation";
-        animation.channels[2 * i + 1].sampler = 2 * i + 1;
-        animation.channels[2 * i + 1].target_node = i;
-        animation.channels[2 * i + 1].target_path = "rotation";
-
-        animation.samplers[2 * i + 0].input = 2 * num_bodies;
-        animation.samplers[2 * i + 0].output = 2 * num_bodies + 2 * i + 1;
-        animation.samplers[2 * i + 0].interpolation = "LINEAR";
-        animation.samplers[2 * i + 1].input = 2 * num_bodies;
-        animation.samplers[2 * i + 1].output = 2 * num_bodies + 2 * i + 2;
-        animation.samplers[2 * i + 1].interpolation = "LINEAR";
-
-        Mesh& mesh = model.meshes[i];
-        mesh.name = bodies[i].name;
-        Primitive& primitive = mesh.primitives.emplace_back();
-        primitive.attributes["POSITION"] = 2 * i;
-        primitive.indices = 2 * i + 1;
-        primitive.mode = TINYGLTF_MODE_TRIANGLES;
-
-        Accessor* accessor = &model.accessors[2 * i];
-        accessor->name = bodies[i].name + "Vertices";
-        accessor->bufferView = 2 * i;
-        accessor->componentType = float_component_type;
-        accessor->count = bodies[i].num_vertices();
-        // accessor->max = ...;
-        // accessor->min = ...;
-        accessor->type = TINYGLTF_TYPE_VEC3;
-
-        accessor = &model.accessors[2 * i + 1];
-        accessor->name = bodies[i].name + "Faces";
-        accessor->bufferView = 2 * i + 1;
-        accessor->componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
-        accessor->count = 3 * bodies[i].num_faces();
-        accessor->type = TINYGLTF_TYPE_SCALAR;
-
-        accessor = &model.accessors[2 * num_bodies + 2 * i + 1];
-        accessor->name = bodies[i].name + "Translations";
-        accessor->bufferView = 2 * num_bodies + 2 * i + 1;
-        accessor->componentType = float_component_type;
-        accessor->count = num_steps;
-        accessor->type = TINYGLTF_TYPE_VEC3;
-
-        accessor = &model.accessors[2 * num_bodies + 2 * i + 2];
-        accessor->name = bodies[i].name + "Rotations";
-        accessor->bufferView = 2 * num_bodies + 2 * i + 2;
-        accessor->componentType = float_component_type;
-        accessor->count = num_steps;
-        accessor->type = TINYGLTF_TYPE_VEC4;
-
-        BufferView& buffer_view = model.bufferViews[2 * i];
-    }
+    /**
+     * @brief Ball of the slopes (change per frame) that interpolate the
+     * frames since a keyframe within a tolerance.
+     *
+     * Frame i reproduces a linear interpolation from keyframe k with slope v
+     * if |x_k + (i - k) v - x_i| ≤ tol, i.e., if v is in a ball of radius
+     * tol / (i - k). The intersection of these balls is bounded from inside
+     * by the largest ball it contains, so checking a segment is O(1).
+     */
+    struct SlopeBound {
+        Eigen::Vector3d center = Eigen::Vector3d::Zero();
+        /// @brief Radius of the ball (infinite if unconstrained and negative
+        /// if empty).
+        double radius = std::numeric_limits<double>::infinity();
+
+        bool contains(const Eigen::Vector3d& slope) const
+        {
+            return std::isinf(radius) || (slope - center).norm() <= radius;
+        }
 
-    ///////////////////////////////////////////////////////////////////////////
-
-    model.bufferViews.resize(4 * num_bodies + 1);
-    size_t byte_offset = 0;
-    for (int i = 0; i < num_bodies; i++) {
-        BufferView* buffer_view = &model.bufferViews[2 * i];
-        buffer_view->name = bodies[i].name + "Vertices";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = sizeof(Float) * bodies[i].vertices.size();
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
-
-        buffer_view = &model.bufferViews[2 * i + 1];
-        buffer_view->name = bodies[i].name + "Faces";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = sizeof(unsigned int) * bodies[i].faces.size();
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
+        /// @brief Intersect with the ball of center c and radius r.
+        void intersect(const Eigen::Vector3d& c, double r)
+        {
+            const double d = (c - center).norm();
+            if (d + r <= radius) {
+                // The new ball is inside the bound
+                center = c;
+                radius = r;
+            } else if (d + radius <= r) {
+                // The bound is inside the new ball
+            } else if (d >= radius + r) {
+                radius = -1;
+            } else {
+                // Largest ball in the lens: centered on the segment between
+                // the centers between where the two spheres cross it
+                center += (0.5 * (d - r + radius) / d) * (c - center);
+                radius = 0.5 * (radius + r - d);
+            }
+        }
+    };
+
+    /// @brief Rotation vector from q0 to q1 (along the shortest path as
+    /// Quaterniond::slerp).
+    Eigen::Vector3d
+    rotation_between(const Eigen::Quaterniond& q0, const Eigen::Quaterniond& q1)
+    {
+        Eigen::AngleAxisd r(q0.conjugate() * q1);
+        return r.angle() * r.axis();
     }
+
+    /**
+     * @brief Greedily select the keyframes needed to reproduce a track.
+     *
+     * The interpolation error of the growing segment is bounded with a
+     * SlopeBound per component. For rotations, the angle between the
+     * rotations with rotation vectors a and b from the keyframe is at most
+     * |a - b|, so the bound is conservative for slerp too.
+     *
+     * @return The keyframes (only the first one if the body never moves).
+     */
+    std::vector<uint32_t>
+    select_keyframes(const Track& track, const GLTFOptions& options)
     {
-        BufferView& buffer_view = model.bufferViews[2 * num_bodies];
-        buffer_view.name = "Times";
-        buffer_view.buffer = 0;
-        buffer_view.byteLength = num_steps * sizeof(Float);
-        buffer_view.byteOffset = byte_offset;
-        byte_offset += buffer_view.byteLength;
+        std::vector<uint32_t> keyframes = { 0 };
+        size_t k = 0;
+        SlopeBound translation_bound, rotation_bound;
+        // Are all frames since the last keyframe within half the tolerances
+        // of it (so any interpolation from it is within the tolerances)?
+        bool is_static = true;
+        for (size_t j = 1; j < track.size(); j++) {
+            is_static = is_static && track.is_near(k, j, 0.5, options);
+
+            Eigen::Vector3d dx = track.positions[j] - track.positions[k];
+            Eigen::Vector3d dr =
+                rotation_between(track.rotations[k], track.rotations[j]);
+            if (!is_static
+                && !(translation_bound.contains(dx / double(j - k))
+                     && rotation_bound.contains(dr / double(j - k)))) {
+                k = j - 1;
+                keyframes.push_back(uint32_t(k));
+                is_static = track.is_near(k, j, 0.5, options);
+                translation_bound = SlopeBound();
+                rotation_bound = SlopeBound();
+                dx = track.positions[j] - track.positions[k];
+                dr = rotation_between(track.rotations[k], track.rotations[j]);
+            }
+
+            // Frame j is in between the keyframes of any longer segment
+            translation_bound.intersect(
+                dx / double(j - k),
+                options.translation_tolerance / double(j - k));
+            rotation_bound.intersect(
+                dr / double(j - k),
+                options.rotation_tolerance / double(j - k));
+        }
+        if (track.size() > 1 && !(is_static && keyframes.size() == 1)) {
+            keyframes.push_back(uint32_t(track.size() - 1));
+        }
+        return keyframes;
     }
-    for (int i = 0; i < num_bodies; i++) {
-        BufferView* buffer_view =
-            &model.bufferViews[2 * num_bodies + 2 * i + 1];
-        buffer_view->name = bodies[i].name + "Translations";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = 3 * sizeof(Float) * num_steps;
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
-
-        buffer_view = &model.bufferViews[2 * num_bodies + 2 * i + 2];
-        buffer_view->name = bodies[i].name + "Rotations";
-        buffer_view->buffer = 0;
-        buffer_view->byteLength = 4 * sizeof(Float) * num_steps;
-        buffer_view->byteOffset = byte_offset;
-        byte_offset += buffer_view->byteLength;
+
+    template <typename T>
+    void write_values(std::ostream& out, const std::vector<T>& values)
+    {
+        out.write(
+            reinterpret_cast<const char*>(values.data()),
+            values.size() * sizeof(T));
     }
 
-    ///////////////////////////////////////////////////////////////////////////
+    /// @brief Buffer views of the data in the order it is streamed.
+    class BufferLayout {
+    public:
+        explicit BufferLayout(nlohmann::json& gltf)
+            : gltf(gltf)
+        {
+        }
+
+        /// @brief Add a buffer view and an accessor of it.
+        /// @return The index of the accessor.
+        int add(
+            const std::string& name,
+            int component_type,
+            size_t component_size,
+            const std::string& type,
+            size_t count,
+            int target = 0)
+        {
+            static const std::unordered_map<std::string, size_t>
+                num_components = { { "SCALAR", 1 },
+                                   { "VEC3", 3 },
+                                   { "VEC4", 4 } };
+            // All element sizes are multiples of 4 bytes, so every view is
+            // 4-byte aligned without padding
+            size_t byte_length =
+                count * num_components.at(type) * component_size;
+            assert(byte_length % 4 == 0);
+
+            nlohmann::json view;
+            view["name"] = name;
+            view["buffer"] = 0;
+            view["byteOffset"] = byte_offset;
+            view["byteLength"] = byte_length;
+            if (target != 0) {
+                view["target"] = target;
+            }
+            gltf["bufferViews"].push_back(view);
+            byte_offset += byte_length;
+
+            nlohmann::json accessor;
+            accessor["name"] = name;
+            accessor["bufferView"] = gltf["bufferViews"].size() - 1;
+            accessor["componentType"] = component_type;
+            accessor["count"] = count;
+            accessor["type"] = type;
+            gltf["accessors"].push_back(accessor);
+            return int(gltf["accessors"].size()) - 1;
+        }
+
+        nlohmann::json& accessor(int i) { return gltf["accessors"][i]; }
+
+        size_t byte_length() const { return byte_offset; }
+
+    protected:
+        nlohmann::json& gltf;
+        size_t byte_offset = 0;
+    };
+
+    template <typename PoseAt>
+    bool write_animation(
+        const std::string& filename,
+        const RigidBodyAssembler& bodies,
+        size_t num_frames,
+        double timestep,
+        const GLTFOptions& options,
+        const PoseAt& pose_at)
+    {
+        if (bodies.dim() != 3) {
+            spdlog::error("Only 3D simulations can be exported to glTF");
+            return false;
+        }
+        if (num_frames == 0) {
+            spdlog::error("No frames to export to glTF");
+            return false;
+        }
+        const size_t num_bodies = bodies.num_bodies();
+
+        // Select the keyframes of each body
+        std::vector<std::vector<uint32_t>> keyframes(num_bodies);
+        const size_t group_size =
+            std::max(MAX_BUFFERED_POSES / num_frames, size_t(1));
+        std::vector<Track> tracks;
+        for (size_t first = 0; first < num_bodies; first += group_size) {
+            tracks.resize(std::min(group_size, num_bodies - first));
+            read_tracks(pose_at, first, num_frames, tracks);
+            tbb::parallel_for(size_t(0), tracks.size(), [&](size_t i) {
+                keyframes[first + i] = select_keyframes(tracks[i], options);
+            });
+        }
+
+        nlohmann::json gltf;
+        gltf["asset"] = { { "version", "2.0" }, { "generator", "RigidIPC" } };
+        gltf["accessors"] = nlohmann::json::array();
+        gltf["bufferViews"] = nlohmann::json::array();
+        BufferLayout layout(gltf);
 
-    std::vector<unsigned char> byte_data(byte_offset);
-    size_t byte_i = 0;
-    for (int i = 0; i < num_bodies; i++) {
-        Eigen::MatrixXd V = bodies[i].vertices;
-        for (int r = 0; r < V.rows(); r++) {
-            for (int c = 0; c < V.cols(); c++) {
-                Float v = V(r, c);
-                std::memcpy(&byte_data[byte_i], &v, sizeof(Float));
-                byte_i += sizeof(Float);
+        // One mesh per unique geometry
+        std::unordered_map<const RigidBodyGeometry*, int> mesh_ids;
+        std::vector<const RigidBodyGeometry*> meshes;
+        for (const RigidBody& body : bodies.m_rbs) {
+            if (mesh_ids.emplace(body.geometry.get(), int(meshes.size()))
+                    .second) {
+                meshes.push_back(body.geometry.get());
+                const RigidBodyGeometry& geometry = *meshes.back();
+
+                nlohmann::json primitive;
+                int vertices = layout.add(
+                    body.name + "Vertices", FLOAT, sizeof(float), "VEC3",
+                    geometry.num_vertices(), ARRAY_BUFFER);
+                Eigen::Vector3f min = geometry.vertices.colwise()
+                                          .minCoeff()
+                                          .transpose()
+                                          .cast<float>();
+                Eigen::Vector3f max = geometry.vertices.colwise()
+                                          .maxCoeff()
+                                          .transpose()
+                                          .cast<float>();
+                layout.accessor(vertices)["min"] = { min.x(), min.y(),
+                                                     min.z() };
+                layout.accessor(vertices)["max"] = { max.x(), max.y(),
+                                                     max.z() };
+                primitive["attributes"]["POSITION"] = vertices;
+                if (geometry.num_faces() > 0) {
+                    primitive["indices"] = layout.add(
+                        body.name + "Faces", UNSIGNED_INT, sizeof(uint32_t),
+                        "SCALAR", geometry.faces.size(),
+                        ELEMENT_ARRAY_BUFFER);
+                    primitive["mode"] = TRIANGLES;
+                } else if (geometry.num_edges() > 0) {
+                    primitive["indices"] = layout.add(
+                        body.name + "Edges", UNSIGNED_INT, sizeof(uint32_t),
+                        "SCALAR", geometry.edges.size(),
+                        ELEMENT_ARRAY_BUFFER);
+                    primitive["mode"] = LINES;
+                } else {
+                    primitive["mode"] = POINTS;
+                }
+                gltf["meshes"].push_back(
+                    { { "name", body.name },
+                      { "primitives", nlohmann::json::array({ primitive }) } });
             }
         }
 
-        Eigen::MatrixXi F = bodies[i].faces;
-        for (int r = 0; r < F.rows(); r++) {
-            for (int c = 0; c < F.cols(); c++) {
-                unsigned int fij = F(r, c);
-                std::memcpy(&byte_data[byte_i], &fij, sizeof(unsigned int));
-                byte_i += sizeof(unsigned int);
+        // Times of every frame, shared by the bodies that keep all frames
+        int times = -1;
+        const auto set_time_range = [&](int accessor, uint32_t first,
+                                        uint32_t last) {
+            layout.accessor(accessor)["min"] =
+                nlohmann::json::array({ float(first * timestep) });
+            layout.accessor(accessor)["max"] =
+                nlohmann::json::array({ float(last * timestep) });
+        };
+        for (const std::vector<uint32_t>& body_keyframes : keyframes) {
+            if (body_keyframes.size() == num_frames && num_frames > 1) {
+                times = layout.add(
+                    "Times", FLOAT, sizeof(float), "SCALAR", num_frames);
+                set_time_range(times, 0, uint32_t(num_frames - 1));
+                break;
             }
         }
-    }
-    for (int i = 0; i < num_steps; i++) {
-        Float t = i * timestep;
-        std::memcpy(&byte_data[byte_i], &t, sizeof(Float));
-        byte_i += sizeof(Float);
-    }
-    for (int i = 0; i < num_bodies; i++) {
-        for (int j = 0; j < num_steps; j++) {
-            Eigen::Vector3d p = poses[j][i].position;
-            for (int d = 0; d < p.size(); d++) {
-                Float pd = p[d];
-                std::memcpy(&byte_data[byte_i], &pd, sizeof(Float));
-                byte_i += sizeof(Float);
+
+        // Nodes and animation tracks
+        nlohmann::json channels = nlohmann::json::array();
+        nlohmann::json samplers = nlohmann::json::array();
+        for (size_t i = 0; i < num_bodies; i++) {
+            const std::string& name = bodies[i].name;
+            Eigen::Vector3d p, r;
+            pose_at(0, i, p, r);
+            const Eigen::Quaterniond q = construct_quaternion(r);
+            gltf["nodes"].push_back(
+                { { "name", name },
+                  { "mesh", mesh_ids[bodies[i].geometry.get()] },
+                  { "translation", { p.x(), p.y(), p.z() } },
+                  { "rotation", { q.x(), q.y(), q.z(), q.w() } } });
+            gltf["scenes"][0]["nodes"].push_back(i);
+
+            const std::vector<uint32_t>& body_keyframes = keyframes[i];
+            if (body_keyframes.size() < 2) {
+                continue; // The body does not move
+            }
+
+            int input = times;
+            if (body_keyframes.size() != num_frames) {
+                input = layout.add(
+                    name + "Times", FLOAT, sizeof(float), "SCALAR",
+                    body_keyframes.size());
+                set_time_range(
+                    input, body_keyframes.front(), body_keyframes.back());
+            }
+            int translations = layout.add(
+                name + "Translations", FLOAT, sizeof(float), "VEC3",
+                body_keyframes.size());
+            int rotations = options.quantize_rotations
+                ? layout.add(
+                    name + "Rotations", SHORT, sizeof(int16_t), "VEC4",
+                    body_keyframes.size())
+                : layout.add(
+                    name + "Rotations", FLOAT, sizeof(float), "VEC4",
+                    body_keyframes.size());
+            if (options.quantize_rotations) {
+                layout.accessor(rotations)["normalized"] = true;
+            }
+
+            for (const auto& [output, path] :
+                 { std::make_pair(translations, "translation"),
+                   std::make_pair(rotations, "rotation") }) {
+                channels.push_back(
+                    { { "sampler", samplers.size() },
+                      { "target", { { "node", i }, { "path", path } } } });
+                samplers.push_back({ { "input", input },
+                                     { "output", output },
+                                     { "interpolation", "LINEAR" } });
+            }
+        }
+        gltf["scene"] = 0;
+        gltf["scenes"][0]["name"] = "RigidIPCSimulation";
+        if (!channels.empty()) {
+            gltf["animations"] = nlohmann::json::array(
+                { { { "name", "Simulation" },
+                    { "channels", channels },
+                    { "samplers", samplers } } });
+        }
+
+        const size_t byte_length = layout.byte_length();
+        if (byte_length > 0) {
+            gltf["buffers"] = nlohmann::json::array(
+                { nlohmann::json::object({ { "byteLength", byte_length } }) });
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // Stream the file
+
+        fs::path path(filename);
+        bool is_binary = path.extension() != ".gltf";
+        std::string json;
+        uint64_t file_length = 0;
+        if (is_binary) {
+            json = gltf.dump();
+            json.resize((json.size() + 3) / 4 * 4, ' ');
+            file_length = 12 + 8 + json.size()
+                + (byte_length > 0 ? 8 + byte_length : 0);
+            if (file_length > std::numeric_limits<uint32_t>::max()) {
+                // GLB lengths are 32-bit, so fall back to an external buffer
+                path.replace_extension(".gltf");
+                spdlog::warn(
+                    "The animation is too large for a binary glTF file; "
+                    "writing {} instead",
+                    path.string());
+                is_binary = false;
+            }
+        }
+
+        std::ofstream out;
+        if (is_binary) {
+            out.open(path.string(), std::ios::binary | std::ios::trunc);
+            const uint32_t header[5] = {
+                GLB_MAGIC, 2, uint32_t(file_length), uint32_t(json.size()),
+                GLB_JSON_CHUNK
+            };
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            out.write(json.data(), json.size());
+            if (byte_length > 0) {
+                const uint32_t chunk[2] = { uint32_t(byte_length),
+                                            GLB_BIN_CHUNK };
+                out.write(reinterpret_cast<const char*>(chunk), sizeof(chunk));
+            }
+        } else {
+            fs::path bin_path = path;
+            bin_path.replace_extension(".bin");
+            if (byte_length > 0) {
+                gltf["buffers"][0]["uri"] = bin_path.filename().string();
+            }
+            std::ofstream json_out(path.string(), std::ios::trunc);
+            json_out << gltf.dump(4);
+            if (!json_out) {
+                spdlog::error("Unable to write glTF file: {}", path.string());
+                return false;
+            }
+            out.open(bin_path.string(), std::ios::binary | std::ios::trunc);
+        }
+        if (!out) {
+            spdlog::error("Unable to write glTF file: {}", path.string());
+            return false;
+        }
+
+        // Write the buffer in the order of the layout
+        size_t bytes_written = 0;
+        const auto write = [&](const auto& values) {
+            write_values(out, values);
+            bytes_written += values.size() * sizeof(values[0]);
+        };
+        for (const RigidBodyGeometry* geometry : meshes) {
+            // Row-major vertices
+            std::vector<float> vertices(geometry->vertices.size());
+            Eigen::Map<
+                Eigen::Matrix<float, Eigen::Dynamic, 3, Eigen::RowMajor>>(
+                vertices.data(), geometry->num_vertices(), 3) =
+                geometry->vertices.cast<float>();
+            write(vertices);
+
+            const Eigen::MatrixXi& indices = geometry->num_faces() > 0
+                ? geometry->faces
+                : geometry->edges;
+            if (indices.size() > 0) {
+                std::vector<uint32_t> elements(indices.size());
+                Eigen::Map<Eigen::Matrix<
+                    uint32_t, Eigen::Dynamic, Eigen::Dynamic,
+                    Eigen::RowMajor>>(
+                    elements.data(), indices.rows(), indices.cols()) =
+                    indices.cast<uint32_t>();
+                write(elements);
             }
         }
+        if (times >= 0) {
+            std::vector<float> values(num_frames);
+            for (size_t j = 0; j < num_frames; j++) {
+                values[j] = float(j * timestep);
+            }
+            write(values);
+        }
+        const auto write_track = [&](const Track& track,
+                                     const std::vector<uint32_t>& frames) {
+            if (frames.size() != num_frames) {
+                std::vector<float> values;
+                for (uint32_t j : frames) {
+                    values.push_back(float(j * timestep));
+                }
+                write(values);
+            }
 
-        for (int j = 0; j < num_steps; j++) {
-            Eigen::Quaternion<double> quat = poses[j][i].construct_quaternion();
-            Eigen::Vector4d q(quat.x(), quat.y(), quat.z(), quat.w());
-            for (int d = 0; d < q.size(); d++) {
-                Float qd = q[d];
-                std::memcpy(&byte_data[byte_i], &qd, sizeof(Float));
-                byte_i += sizeof(Float);
+            std::vector<float> translations;
+            for (uint32_t j : frames) {
+                const Eigen::Vector3d& p = track.positions[j];
+                translations.insert(
+                    translations.end(),
+                    { float(p.x()), float(p.y()), float(p.z()) });
             }
+            write(translations);
+
+            if (options.quantize_rotations) {
+                std::vector<int16_t> rotations;
+                for (uint32_t j : frames) {
+                    const auto& q = track.rotations[j].coeffs(); // x, y, z, w
+                    for (int d = 0; d < 4; d++) {
+                        rotations.push_back(int16_t(std::round(
+                            std::clamp(q[d], -1.0, 1.0) * 32767.0)));
+                    }
+                }
+                write(rotations);
+            } else {
+                std::vector<float> rotations;
+                for (uint32_t j : frames) {
+                    const auto& q = track.rotations[j].coeffs(); // x, y, z, w
+                    rotations.insert(
+                        rotations.end(),
+                        { float(q[0]), float(q[1]), float(q[2]),
+                          float(q[3]) });
+                }
+                write(rotations);
+            }
+        };
+        for (size_t first = 0; first < num_bodies; first += group_size) {
+            tracks.resize(std::min(group_size, num_bodies - first));
+            // Only read up to the last keyframe of the group
+            uint32_t last_keyframe = 0;
+            for (size_t i = 0; i < tracks.size(); i++) {
+                last_keyframe =
+                    std::max(last_keyframe, keyframes[first + i].back());
+            }
+            if (last_keyframe == 0) {
+                continue; // No body of the group moves
+            }
+            read_tracks(pose_at, first, last_keyframe + 1, tracks);
+
+            for (size_t i = 0; i < tracks.size(); i++) {
+                if (keyframes[first + i].size() >= 2) {
+                    write_track(tracks[i], keyframes[first + i]);
+                }
+            }
+        }
+        assert(bytes_written == byte_length);
+
+        if (!out) {
+            spdlog::error("Unable to write glTF file: {}", path.string());
+            return false;
         }
+        return true;
     }
-    assert(byte_i == byte_data.size());
+} // namespace
 
-    model.buffers.emplace_back().data = byte_data;
-    return TinyGLTF().WriteGltfSceneToFile(
-        &model, filename,
-        /*embedImages=*/true, embed_buffers, prettyPrint, write_binary);
+bool write_gltf(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    const std::vector<PosesD>& poses,
+    double timestep,
+    const GLTFOptions& options)
+{
+    return write_animation(
+        filename, bodies, poses.size(), timestep, options,
+        [&](size_t frame, size_t body, Eigen::Vector3d& position,
+            Eigen::Vector3d& rotation) {
+            position = poses[frame][body].position;
+            rotation = poses[frame][body].rotation;
+        });
+}
+
+bool write_gltf(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    const TrajectoryReader& states,
+    const GLTFOptions& options)
+{
+    assert(states.num_bodies() == bodies.num_bodies());
+    // Read the poses directly from the records of the trajectory
+    return write_animation(
+        filename, bodies, states.num_frames(), states.timestep(), options,
+        [&](size_t frame, size_t body, Eigen::Vector3d& position,
+            Eigen::Vector3d& rotation) {
+            const double* record =
+                states.frame(frame) + body * states.record_size();
+            position = Eigen::Map<const Eigen::Vector3d>(record);
+            rotation = Eigen::Map<const Eigen::Vector3d>(record + 3);
+        });
 }
 
 } // namespace ipc::rigid
@@ -2,17 +2,54 @@
 
 #include <string>
 
+#include <io/trajectory.hpp>
 #include <physics/rigid_body_assembler.hpp>
 
 namespace ipc::rigid {
 
+/// @brief Options of the glTF animation export.
+struct GLTFOptions {
+    /// @brief Drop keyframes whose translation is within this distance of
+    /// the interpolation of the kept keyframes.
+    double translation_tolerance = 0;
+    /// @brief Drop keyframes whose rotation is within this angle (radians)
+    /// of the interpolation of the kept keyframes.
+    double rotation_tolerance = 0;
+    /// @brief Store the rotations as normalized int16 instead of float.
+    bool quantize_rotations = false;
+};
+
+/**
+ * @brief Write the animation of the bodies as a glTF file.
+ *
+ * Bodies sharing a geometry share a single mesh. Every body gets a
+ * translation and rotation track whose keyframes are reduced to the ones
+ * needed to reproduce the poses within the tolerances (bodies that do not
+ * move get no track). The poses are read, and the buffer data is streamed
+ * to the file, one group of bodies at a time, so the export never holds the
+ * whole animation in memory.
+ *
+ * @param filename  Output file: binary glTF (.glb) or glTF with an external
+ *                  buffer (.gltf and .bin). Binary files are limited to
+ *                  4 GiB, so larger animations are written to .gltf and
+ *                  .bin files instead (with a warning).
+ * @param bodies    Bodies (3D only) with their geometry.
+ * @param poses     Poses of the bodies in each frame.
+ * @param timestep  Time between frames.
+ * @param options   Keyframe reduction and quantization options.
+ */
 bool write_gltf(
     const std::string& filename,
     const RigidBodyAssembler& bodies,
     const std::vector<PosesD>& poses,
     double timestep,
-    bool embed_buffers = true,
-    bool write_binary = true,
-    bool prettyPrint = true);
+    const GLTFOptions& options = GLTFOptions());
+
+/// @brief Write the animation of the bodies stored in a trajectory.
+bool write_gltf(
+    const std::string& filename,
+    const RigidBodyAssembler& bodies,
+    const TrajectoryReader& states,
+    const GLTFOptions& options = GLTFOptions());
 
 } // namespace ipc::rigid
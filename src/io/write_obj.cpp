@@ -8,6 +8,7 @@
 // obtain one at http://mozilla.org/MPL/2.0/.
 #include "write_obj.hpp"
 
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <fstream>
@@ -15,7 +16,10 @@
 #include <iostream>
 #include <limits>
 
+#include <fmt/format.h>
 #include <ghc/fs_std.hpp> // filesystem
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
 
 #include <logger.hpp>
 #include <physics/rigid_body_problem.hpp>
@@ -48,46 +52,128 @@ bool write_obj(
     return true;
 }
 
-bool write_obj(
-    const std::string str, const SimulationProblem& problem, bool write_mtl)
+/// @brief Format a body as an object with vertex indices starting at
+/// start_vi.
+template <typename Vertices>
+static void format_body_obj(
+    fmt::memory_buffer& s,
+    size_t id,
+    const Vertices& V,
+    const Eigen::MatrixXi& E,
+    const Eigen::MatrixXi& F,
+    const std::vector<size_t>& codim_edges_to_edges,
+    size_t start_vi)
 {
-    std::ofstream s(str);
-    if (!s.is_open()) {
-        spdlog::error("IOError: write_obj() could not open {}", str);
-        return false;
+    auto out = std::back_inserter(s);
+    fmt::format_to(out, "o body{0:04d}\nusemtl body{0:04d}\n", id);
+    for (int vi = 0; vi < V.rows(); vi++) {
+        fmt::format_to(out, "v");
+        for (int j = 0; j < V.cols(); j++) {
+            fmt::format_to(out, " {}", V(vi, j));
+        }
+        fmt::format_to(out, "\n");
     }
-
-    auto p = fs::path(str);
-    std::string ps_name =
-        (p.parent_path() / ("points-" + p.filename().string())).string();
-    std::ofstream ps(ps_name);
-    if (!s.is_open()) {
-        spdlog::error("IOError: write_obj() could not open {}", ps_name);
-        return false;
+    for (int fi = 0; fi < F.rows(); fi++) {
+        fmt::format_to(out, "f");
+        for (int j = 0; j < F.cols(); j++) {
+            fmt::format_to(out, " {}", F(fi, j) + start_vi);
+        }
+        fmt::format_to(out, "\n");
     }
+    for (const size_t& ei : codim_edges_to_edges) {
+        fmt::format_to(
+            out, "l {:d} {:d}\n", E(ei, 0) + start_vi, E(ei, 1) + start_vi);
+    }
+}
 
-    s << "mtllib mat.mtl\n";
-    ps << "mtllib mat.mtl\n";
+/// @brief Format the bodies as objects (point clouds are formatted into a
+/// separate buffer).
+template <
+    typename Vertices,
+    typename Edges,
+    typename Faces,
+    typename CodimEdgesToEdges>
+static void format_bodies_obj(
+    fmt::memory_buffer& s,
+    fmt::memory_buffer& ps,
+    size_t num_bodies,
+    const Vertices& vertices,
+    const Edges& edges,
+    const Faces& faces,
+    const CodimEdgesToEdges& codim_edges_to_edges)
+{
+    fmt::format_to(std::back_inserter(s), "mtllib mat.mtl\n");
+    fmt::format_to(std::back_inserter(ps), "mtllib mat.mtl\n");
 
     size_t start_vi = 1;
-    for (int i = 0; i < problem.num_bodies(); i++) {
-        Eigen::MatrixXd V = problem.vertices(i);
-        const auto& F = problem.faces(i);
-        const auto& E = problem.edges(i);
+    for (size_t i = 0; i < num_bodies; i++) {
+        const auto& V = vertices(i);
+        const Eigen::MatrixXi& F = faces(i);
+        const Eigen::MatrixXi& E = edges(i);
         if (F.rows() == 0 && E.rows() == 0) {
-            ps << fmt::format("o body{0:04d}\nusemtl body{0:04d}\n", i);
-            ps << V.format(vertices_format);
+            format_body_obj(ps, i, V, E, F, {}, 1);
         } else {
-            s << fmt::format("o body{0:04d}\nusemtl body{0:04d}\n", i);
-            s << V.format(vertices_format)
-              << (F.array() + start_vi).format(faces_format);
-            for (const size_t& ei : problem.codim_edges_to_edges(i)) {
-                s << fmt::format(
-                    "l {:d} {:d}\n", E(ei, 0) + start_vi, E(ei, 1) + start_vi);
-            }
+            format_body_obj(
+                s, i, V, E, F, codim_edges_to_edges(i), start_vi);
             start_vi += V.rows();
         }
     }
+}
+
+/// @brief Write a formatted buffer to a file.
+static bool write_buffer(const std::string& str, const fmt::memory_buffer& s)
+{
+    std::ofstream file(str, std::ios::binary);
+    if (!file.is_open()) {
+        spdlog::error("IOError: write_obj() could not open {}", str);
+        return false;
+    }
+    file.write(s.data(), s.size());
+    return bool(file);
+}
+
+/// @brief Name of the file of the point clouds of an OBJ file.
+static std::string points_filename(const std::string& str)
+{
+    auto p = fs::path(str);
+    return (p.parent_path() / ("points-" + p.filename().string())).string();
+}
+
+/// @brief Write the bodies as objects (point clouds are written to a
+/// separate points-<filename> file).
+template <
+    typename Vertices,
+    typename Edges,
+    typename Faces,
+    typename CodimEdgesToEdges>
+static bool write_bodies_obj(
+    const std::string& str,
+    size_t num_bodies,
+    const Vertices& vertices,
+    const Edges& edges,
+    const Faces& faces,
+    const CodimEdgesToEdges& codim_edges_to_edges)
+{
+    fmt::memory_buffer s, ps;
+    format_bodies_obj(
+        s, ps, num_bodies, vertices, edges, faces, codim_edges_to_edges);
+    return write_buffer(str, s) && write_buffer(points_filename(str), ps);
+}
+
+bool write_obj(
+    const std::string str, const SimulationProblem& problem, bool write_mtl)
+{
+    bool success = write_bodies_obj(
+        str, problem.num_bodies(),
+        [&](size_t i) { return problem.vertices(i); },
+        [&](size_t i) -> const Eigen::MatrixXi& { return problem.edges(i); },
+        [&](size_t i) -> const Eigen::MatrixXi& { return problem.faces(i); },
+        [&](size_t i) -> const std::vector<size_t>& {
+            return problem.codim_edges_to_edges(i);
+        });
+    if (!success) {
+        return false;
+    }
 
     if (!write_mtl) {
         return true;
@@ -117,4 +203,121 @@ bool write_obj(
     return true;
 }
 
+bool write_obj(
+    const std::string str,
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses)
+{
+    assert(poses.size() == bodies.num_bodies());
+    return write_bodies_obj(
+        str, bodies.num_bodies(),
+        [&](size_t i) { return bodies[i].world_vertices(poses[i]); },
+        [&](size_t i) -> const Eigen::MatrixXi& { return bodies[i].edges(); },
+        [&](size_t i) -> const Eigen::MatrixXi& { return bodies[i].faces(); },
+        [&](size_t i) -> const std::vector<size_t>& {
+            return bodies[i].mesh_selector().codim_edges_to_edges();
+        });
+}
+
+/// @brief Format the world transforms of the bodies (one row-major 4×4
+/// matrix per line).
+static void format_transforms(fmt::memory_buffer& s, const PosesD& poses)
+{
+    auto out = std::back_inserter(s);
+    fmt::format_to(out, "# body m00 m01 m02 m03 m10 ... m33\n");
+    for (size_t i = 0; i < poses.size(); i++) {
+        Eigen::Matrix4d T = Eigen::Matrix4d::Identity();
+        const int dim = poses[i].dim();
+        T.topLeftCorner(dim, dim) = poses[i].construct_rotation_matrix();
+        T.col(3).head(dim) = poses[i].position;
+        fmt::format_to(out, "body{:04d}", i);
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                fmt::format_to(out, " {}", T(r, c));
+            }
+        }
+        fmt::format_to(out, "\n");
+    }
+}
+
+bool write_obj_sequence(
+    const std::string& dir_name,
+    const RigidBodyAssembler& bodies,
+    const TrajectoryReader& states,
+    bool per_body)
+{
+    assert(states.num_bodies() == bodies.num_bodies());
+
+    // Create the output directory if it does not exist
+    fs::path dir_path(dir_name);
+    std::error_code ec;
+    fs::create_directories(dir_path, ec);
+    if (ec) {
+        spdlog::error(
+            "IOError: write_obj_sequence() could not create {} ({})", dir_name,
+            ec.message());
+        return false;
+    }
+
+    std::atomic<bool> success(true);
+
+    if (per_body) {
+        // Write the bodies once in their body frame
+        tbb::parallel_for(size_t(0), bodies.num_bodies(), [&](size_t i) {
+            const RigidBody& body = bodies[i];
+            fmt::memory_buffer s;
+            fmt::format_to(std::back_inserter(s), "mtllib mat.mtl\n");
+            format_body_obj(
+                s, i, body.vertices(), body.edges(), body.faces(),
+                body.mesh_selector().codim_edges_to_edges(), 1);
+            if (!write_buffer(
+                    (dir_path / fmt::format("body{:04d}.obj", i)).string(),
+                    s)) {
+                success = false;
+            }
+        });
+    }
+
+    // Each thread formats one frame at a time in its own (reused) buffers
+    struct FrameBuffers {
+        fmt::memory_buffer s, ps;
+    };
+    tbb::enumerable_thread_specific<FrameBuffers> storage;
+
+    tbb::parallel_for(size_t(0), states.num_frames(), [&](size_t fi) {
+        FrameBuffers& buffers = storage.local();
+        buffers.s.clear();
+        buffers.ps.clear();
+
+        const PosesD poses = states.poses(fi);
+        std::string filename;
+        if (per_body) {
+            format_transforms(buffers.s, poses);
+            filename = (dir_path / fmt::format("{:05d}.txt", fi)).string();
+        } else {
+            format_bodies_obj(
+                buffers.s, buffers.ps, bodies.num_bodies(),
+                [&](size_t i) { return bodies[i].world_vertices(poses[i]); },
+                [&](size_t i) -> const Eigen::MatrixXi& {
+                    return bodies[i].edges();
+                },
+                [&](size_t i) -> const Eigen::MatrixXi& {
+                    return bodies[i].faces();
+                },
+                [&](size_t i) -> const std::vector<size_t>& {
+                    return bodies[i].mesh_selector().codim_edges_to_edges();
+                });
+            filename = (dir_path / fmt::format("{:05d}.obj", fi)).string();
+            if (!write_buffer(points_filename(filename), buffers.ps)) {
+                success = false;
+            }
+        }
+        if (!write_buffer(filename, buffers.s)) {
+            success = false;
+        }
+    });
+
+    return success;
+}
+
 } // namespace ipc::rigid
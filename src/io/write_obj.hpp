@@ -14,6 +14,8 @@
 
 #include <Eigen/Core>
 
+#include <io/trajectory.hpp>
+#include <physics/rigid_body_assembler.hpp>
 #include <physics/simulation_problem.hpp>
 
 namespace ipc::rigid {
@@ -30,4 +32,31 @@ bool write_obj(
     const SimulationProblem& problem,
     bool write_mtl);
 
+/// @brief Write the bodies in the given poses.
+bool write_obj(
+    const std::string str,
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses);
+
+/**
+ * @brief Write a trajectory as a sequence of OBJ files (00000.obj, …).
+ *
+ * The vertices are computed from the poses stored in the trajectory, and
+ * the frames are formatted and written in parallel with one frame in
+ * memory per thread.
+ *
+ * @param dir_name  Output directory (created if it does not exist).
+ * @param bodies    Bodies of the trajectory.
+ * @param states    Trajectory of the bodies.
+ * @param per_body  Instead of the world vertices of every frame, write each
+ *                  body once in its body frame (body0000.obj, …) and the
+ *                  world transforms of the bodies in each frame as
+ *                  row-major 4×4 matrices (00000.txt, …).
+ */
+bool write_obj_sequence(
+    const std::string& dir_name,
+    const RigidBodyAssembler& bodies,
+    const TrajectoryReader& states,
+    bool per_body = false);
+
 } // namespace ipc::rigid
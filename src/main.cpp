@@ -55,6 +55,11 @@ int main(int argc, char* argv[])
         "--chkpt,--checkpoint-frequency", checkpoint_freq,
         "number of time-steps between checkpoints (ngui only)");
 
+    std::string restart_path = "";
+    app.add_option(
+        "--restart", restart_path,
+        "checkpoint of the scene to restart from (ngui only)");
+
     spdlog::level::level_enum loglevel = spdlog::level::info;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -119,6 +124,10 @@ int main(int argc, char* argv[])
             return 1;
         }
 
+        if (!restart_path.empty() && !sim.load_checkpoint(restart_path)) {
+            return 1;
+        }
+
         if (num_steps > 0) {
             sim.m_max_simulation_steps = num_steps;
         }
@@ -0,0 +1,144 @@
+#include "body_block_hessian.hpp"
+
+#include <tbb/parallel_for.h>
+
+namespace ipc::rigid {
+
+void BodyBlockHessian::resize(size_t num_bodies, int ndof)
+{
+    m_ndof = ndof;
+    m_diagonal_blocks.assign(num_bodies, MatrixMax6d::Zero(ndof, ndof));
+    m_pair_blocks.clear();
+    update_incident_blocks();
+}
+
+void BodyBlockHessian::add_block_diagonal(
+    const Eigen::SparseMatrix<double>& hess, double scale)
+{
+    if (hess.nonZeros() == 0) {
+        return;
+    }
+    assert(hess.rows() == size() && hess.cols() == size());
+    for (int k = 0; k < hess.outerSize(); ++k) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(hess, k); it; ++it) {
+            const long bi = it.row() / m_ndof, bj = it.col() / m_ndof;
+            if (bi != bj) {
+                assert(it.value() == 0);
+                continue;
+            }
+            m_diagonal_blocks[bi](it.row() % m_ndof, it.col() % m_ndof) +=
+                scale * it.value();
+        }
+    }
+}
+
+void BodyBlockHessian::add_pair_blocks(
+    const std::vector<BodyPairHessianBlock>& blocks, double scale)
+{
+    m_pair_blocks.reserve(m_pair_blocks.size() + blocks.size());
+    for (const BodyPairHessianBlock& block : blocks) {
+        assert(block.hessian.rows() == 2 * m_ndof);
+        m_pair_blocks.emplace_back(block.body_ids, scale * block.hessian);
+    }
+    update_incident_blocks();
+}
+
+void BodyBlockHessian::update_incident_blocks()
+{
+    // Counting sort of the block sides by body
+    m_incident_offsets.assign(num_bodies() + 1, 0);
+    for (const BodyPairHessianBlock& block : m_pair_blocks) {
+        for (int i = 0; i < 2; i++) {
+            m_incident_offsets[block.body_ids[i] + 1]++;
+        }
+    }
+    for (size_t b = 0; b < num_bodies(); b++) {
+        m_incident_offsets[b + 1] += m_incident_offsets[b];
+    }
+
+    m_incident_blocks.resize(m_incident_offsets.back());
+    std::vector<size_t> next(
+        m_incident_offsets.begin(), m_incident_offsets.end() - 1);
+    for (size_t bi = 0; bi < m_pair_blocks.size(); bi++) {
+        for (int i = 0; i < 2; i++) {
+            m_incident_blocks[next[m_pair_blocks[bi].body_ids[i]]++] =
+                std::make_pair(bi, i);
+        }
+    }
+}
+
+Eigen::VectorXd BodyBlockHessian::operator*(const Eigen::VectorXd& x) const
+{
+    assert(x.size() == size());
+    const int& ndof = m_ndof;
+
+    // Gather the rows of each body instead of scattering the pair blocks, so
+    // no two threads write the same entries.
+    Eigen::VectorXd y(x.size());
+    tbb::parallel_for(size_t(0), num_bodies(), [&](size_t b) {
+        auto y_b = y.segment(b * ndof, ndof);
+        y_b = m_diagonal_blocks[b] * x.segment(b * ndof, ndof);
+        for (size_t k = m_incident_offsets[b]; k < m_incident_offsets[b + 1];
+             k++) {
+            const BodyPairHessianBlock& block =
+                m_pair_blocks[m_incident_blocks[k].first];
+            const int i = m_incident_blocks[k].second;
+            for (int j = 0; j < 2; j++) {
+                y_b += block.hessian.block(i * ndof, j * ndof, ndof, ndof)
+                    * x.segment(block.body_ids[j] * ndof, ndof);
+            }
+        }
+    });
+
+    return y;
+}
+
+std::vector<MatrixMax6d> BodyBlockHessian::diagonal_blocks() const
+{
+    std::vector<MatrixMax6d> blocks = m_diagonal_blocks;
+    for (const BodyPairHessianBlock& block : m_pair_blocks) {
+        for (int i = 0; i < 2; i++) {
+            blocks[block.body_ids[i]] += block.hessian.block(
+                i * m_ndof, i * m_ndof, m_ndof, m_ndof);
+        }
+    }
+    return blocks;
+}
+
+Eigen::SparseMatrix<double> BodyBlockHessian::assemble() const
+{
+    const int& ndof = m_ndof;
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(
+        (num_bodies() + 4 * m_pair_blocks.size()) * ndof * ndof);
+
+    for (size_t b = 0; b < num_bodies(); b++) {
+        for (int r = 0; r < ndof; r++) {
+            for (int c = 0; c < ndof; c++) {
+                triplets.emplace_back(
+                    b * ndof + r, b * ndof + c, m_diagonal_blocks[b](r, c));
+            }
+        }
+    }
+
+    for (const BodyPairHessianBlock& block : m_pair_blocks) {
+        for (int bi = 0; bi < 2; bi++) {
+            for (int bj = 0; bj < 2; bj++) {
+                for (int r = 0; r < ndof; r++) {
+                    for (int c = 0; c < ndof; c++) {
+                        triplets.emplace_back(
+                            block.body_ids[bi] * ndof + r,
+                            block.body_ids[bj] * ndof + c,
+                            block.hessian(bi * ndof + r, bj * ndof + c));
+                    }
+                }
+            }
+        }
+    }
+
+    Eigen::SparseMatrix<double> hess(size(), size());
+    hess.setFromTriplets(triplets.begin(), triplets.end());
+    return hess;
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include <utils/eigen_ext.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Local Hessian of a potential coupling the DoF of two bodies.
+struct BodyPairHessianBlock {
+    BodyPairHessianBlock() = default;
+    BodyPairHessianBlock(
+        const std::array<long, 2>& body_ids, const MatrixMax12d& hessian)
+        : body_ids(body_ids)
+        , hessian(hessian)
+    {
+    }
+
+    /// @brief Ids of the two bodies (the local DoF are ordered the same).
+    std::array<long, 2> body_ids;
+    /// @brief (2 ndof × 2 ndof) Hessian with respect to the bodies' DoF.
+    MatrixMax12d hessian;
+};
+
+/// @brief Unassembled Hessian of a rigid body objective.
+///
+/// The Hessian is stored as one dense (ndof × ndof) block per body plus one
+/// dense (2 ndof × 2 ndof) block per body pair potential, so its memory is
+/// linear in the number of bodies and contacts. It is only used through
+/// products with vectors (e.g., in a matrix-free Newton-CG solver).
+class BodyBlockHessian {
+public:
+    BodyBlockHessian() = default;
+    BodyBlockHessian(size_t num_bodies, int ndof) { resize(num_bodies, ndof); }
+
+    /// @brief Clear the Hessian and set its dimensions.
+    void resize(size_t num_bodies, int ndof);
+
+    size_t num_bodies() const { return m_diagonal_blocks.size(); }
+    int ndof() const { return m_ndof; }
+    /// @brief Number of rows (and columns) of the Hessian.
+    int size() const { return int(num_bodies()) * m_ndof; }
+    size_t num_pair_blocks() const { return m_pair_blocks.size(); }
+
+    /// @brief Add the (ndof × ndof) diagonal blocks of a block diagonal matrix.
+    void add_block_diagonal(
+        const Eigen::SparseMatrix<double>& hess, double scale = 1);
+
+    /// @brief Add body pair blocks scaled by a constant.
+    void add_pair_blocks(
+        const std::vector<BodyPairHessianBlock>& blocks, double scale = 1);
+
+    /// @brief Compute the product H x.
+    /// @note Each body's rows are summed by a single thread in a fixed order,
+    ///       so the product is deterministic.
+    Eigen::VectorXd operator*(const Eigen::VectorXd& x) const;
+
+    /// @brief Get the (ndof × ndof) diagonal blocks of the assembled Hessian.
+    std::vector<MatrixMax6d> diagonal_blocks() const;
+
+    /// @brief Assemble the Hessian into a sparse matrix.
+    Eigen::SparseMatrix<double> assemble() const;
+
+protected:
+    /// @brief Rebuild the lists of pair blocks incident to each body.
+    void update_incident_blocks();
+
+    int m_ndof = 0;
+    std::vector<MatrixMax6d> m_diagonal_blocks;
+    std::vector<BodyPairHessianBlock> m_pair_blocks;
+
+    /// @brief Pair blocks incident to each body as (block id, side) pairs
+    /// sorted by block id. The entries of body b are in the range
+    /// [m_incident_offsets[b], m_incident_offsets[b + 1]).
+    std::vector<std::pair<size_t, int>> m_incident_blocks;
+    std::vector<size_t> m_incident_offsets;
+};
+
+} // namespace ipc::rigid
@@ -1,9 +1,18 @@
 #include "distance_barrier_constraint.hpp"
 
+#include <algorithm>
 #include <mutex>
+#include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
 
 #include <igl/slice_mask.h>
+#include <ipc/distance/distance_type.hpp>
+#include <ipc/distance/edge_edge.hpp>
+#include <ipc/distance/edge_edge_mollifier.hpp>
+#include <ipc/distance/point_edge.hpp>
+#include <ipc/distance/point_triangle.hpp>
 #include <ipc/ipc.hpp>
 
 #include <ccd/rigid/broad_phase.hpp>
@@ -27,7 +36,12 @@ DistanceBarrierConstraint::DistanceBarrierConstraint(const std::string& name)
     , initial_barrier_activation_distance(1e-3)
     , barrier_type(BarrierType::IPC)
     , minimum_separation_distance(0.0)
+    , candidate_skin(0.0)
+    , sort_constraints(false)
     , m_barrier_activation_distance(0.0)
+    , m_constraint_cache_capacity(4)
+    , m_constraint_cache_clock(0)
+    , m_skin_inflation_radius(-1)
 {
 }
 
@@ -38,6 +52,8 @@ void DistanceBarrierConstraint::settings(const nlohmann::json& json)
         json["initial_barrier_activation_distance"];
     minimum_separation_distance = json["minimum_separation_distance"];
     barrier_type = json["barrier_type"];
+    candidate_skin = json["candidate_skin"];
+    sort_constraints = json["sort_constraints"];
 }
 
 nlohmann::json DistanceBarrierConstraint::settings() const
@@ -47,12 +63,15 @@ nlohmann::json DistanceBarrierConstraint::settings() const
         initial_barrier_activation_distance;
     json["minimum_separation_distance"] = minimum_separation_distance;
     json["barrier_type"] = barrier_type;
+    json["candidate_skin"] = candidate_skin;
+    json["sort_constraints"] = sort_constraints;
     return json;
 }
 
 void DistanceBarrierConstraint::initialize()
 {
     m_barrier_activation_distance = initial_barrier_activation_distance;
+    clear_cache();
     CollisionConstraint::initialize();
 }
 
@@ -264,58 +283,439 @@ double DistanceBarrierConstraint::compute_earliest_toi_narrow_phase(
                            : std::numeric_limits<double>::infinity();
 }
 
-void DistanceBarrierConstraint::construct_constraint_set(
-    const RigidBodyAssembler& bodies,
-    const PosesD& poses,
-    Constraints& constraint_set) const
-{
-    static PosesD cached_poses;
-    static Constraints cached_constraint_set;
+namespace {
+    /// @brief Hash the pose DOFs together with the distances the constraint
+    /// set depends on.
+    size_t hash_poses(const PosesD& poses, double dhat, double dmin)
+    {
+        size_t seed = 0;
+        const auto hash_combine = [&seed](double value) {
+            seed ^= std::hash<double>()(value) + 0x9e3779b9 + (seed << 6)
+                + (seed >> 2);
+        };
+        hash_combine(dhat);
+        hash_combine(dmin);
+        for (const PoseD& pose : poses) {
+            for (int i = 0; i < pose.position.size(); i++) {
+                hash_combine(pose.position(i));
+            }
+            for (int i = 0; i < pose.rotation.size(); i++) {
+                hash_combine(pose.rotation(i));
+            }
+        }
+        return seed;
+    }
+} // namespace
 
+std::shared_ptr<const Constraints>
+DistanceBarrierConstraint::construct_constraint_set(
+    const RigidBodyAssembler& bodies, const PosesD& poses) const
+{
     if (bodies.num_bodies() <= 1) {
-        return;
+        return std::make_shared<const Constraints>();
     }
+    return cached_constraint_set(bodies, poses)->constraints;
+}
 
-    if (poses == cached_poses) {
-        constraint_set = cached_constraint_set;
-        return;
+std::shared_ptr<const DistanceBarrierConstraint::ConstraintCacheEntry>
+DistanceBarrierConstraint::cached_constraint_set(
+    const RigidBodyAssembler& bodies, const PosesD& poses) const
+{
+    const double& dhat = m_barrier_activation_distance;
+    const double& dmin = minimum_separation_distance;
+    const size_t key = hash_poses(poses, dhat, dmin);
+
+    const auto is_hit = [&](const ConstraintCacheEntry& entry) {
+        return entry.key == key && entry.dhat == dhat && entry.dmin == dmin
+            && entry.poses == poses;
+    };
+
+    {
+        std::shared_lock lock(m_constraint_cache_mutex);
+        for (const auto& entry : m_constraint_cache) {
+            if (is_hit(*entry)) {
+                entry->last_used = ++m_constraint_cache_clock;
+                return entry;
+            }
+        }
     }
 
     PROFILE_POINT("DistanceBarrierConstraint::construct_constraint_set");
     PROFILE_START();
 
+    Eigen::MatrixXd V = bodies.world_vertices(poses);
+    std::shared_ptr<const Candidates> candidates =
+        skin_candidates(bodies, poses, V);
+    // Without a skin the candidates are detected from scratch every time, so
+    // there is no previous active set to update.
+    std::shared_ptr<const Constraints> constraint_set = skin() > 0
+        ? update_active_set(bodies, candidates, V)
+        : build_constraint_set(bodies, *candidates, V);
+
+    PROFILE_END();
+
+    auto entry = std::make_shared<ConstraintCacheEntry>();
+    entry->key = key;
+    entry->dhat = dhat;
+    entry->dmin = dmin;
+    entry->poses = poses;
+    entry->V = std::move(V);
+    entry->constraints = constraint_set;
+    entry->last_used = ++m_constraint_cache_clock;
+
+    std::unique_lock lock(m_constraint_cache_mutex);
+    if (m_constraint_cache.size() >= m_constraint_cache_capacity) {
+        // Evict the least recently used entry
+        auto lru = std::min_element(
+            m_constraint_cache.begin(), m_constraint_cache.end(),
+            [](const auto& a, const auto& b) {
+                return a->last_used < b->last_used;
+            });
+        *lru = entry;
+    } else {
+        m_constraint_cache.push_back(entry);
+    }
+
+    return entry;
+}
+
+std::shared_ptr<const Constraints>
+DistanceBarrierConstraint::build_constraint_set(
+    const RigidBodyAssembler& bodies,
+    const Candidates& candidates,
+    const Eigen::MatrixXd& V) const
+{
+    auto constraint_set = std::make_shared<Constraints>();
+    ipc::construct_constraint_set(
+        candidates, /*V_rest=*/V, V, bodies.m_edges, bodies.m_faces,
+        /*dhat=*/m_barrier_activation_distance, *constraint_set,
+        bodies.m_faces_to_edges, /*dmin=*/minimum_separation_distance);
+
+    if (sort_constraints) {
+        sort_constraint_set(bodies, *constraint_set);
+    }
+
+    return constraint_set;
+}
+
+void DistanceBarrierConstraint::sort_constraint_set(
+    const RigidBodyAssembler& bodies, Constraints& constraint_set) const
+{
+    // The body pairs are ordered the same as the body_ids() of the rigid body
+    // constraints (see problems/rigid_body_collision_constraint.hpp).
+    typedef std::array<long, 4> SortKey;
+    const auto sort_by = [](auto& constraints, const auto& key) {
+        tbb::parallel_sort(
+            constraints.begin(), constraints.end(),
+            [&key](const auto& a, const auto& b) { return key(a) < key(b); });
+    };
+
+    sort_by(
+        constraint_set.vv_constraints, [&](const VertexVertexConstraint& c) {
+            return SortKey { { bodies.vertex_id_to_body_id(c.vertex0_index),
+                               bodies.vertex_id_to_body_id(c.vertex1_index),
+                               c.vertex0_index, c.vertex1_index } };
+        });
+    sort_by(constraint_set.ev_constraints, [&](const EdgeVertexConstraint& c) {
+        return SortKey { { bodies.vertex_id_to_body_id(c.vertex_index),
+                           bodies.edge_id_to_body_id(c.edge_index),
+                           c.edge_index, c.vertex_index } };
+    });
+    sort_by(constraint_set.ee_constraints, [&](const EdgeEdgeConstraint& c) {
+        return SortKey { { bodies.edge_id_to_body_id(c.edge0_index),
+                           bodies.edge_id_to_body_id(c.edge1_index),
+                           c.edge0_index, c.edge1_index } };
+    });
+    sort_by(constraint_set.fv_constraints, [&](const FaceVertexConstraint& c) {
+        return SortKey { { bodies.vertex_id_to_body_id(c.vertex_index),
+                           bodies.face_id_to_body_id(c.face_index),
+                           c.face_index, c.vertex_index } };
+    });
+}
+
+void DistanceBarrierConstraint::clear_cache() const
+{
+    {
+        std::unique_lock lock(m_constraint_cache_mutex);
+        m_constraint_cache.clear();
+    }
+    std::scoped_lock lock(m_skin_mutex);
+    m_skin_candidates = nullptr;
+    m_active_set_reference = nullptr;
+}
+
+void DistanceBarrierConstraint::set_constraint_cache_capacity(size_t capacity)
+{
+    std::unique_lock lock(m_constraint_cache_mutex);
+    m_constraint_cache_capacity = std::max(capacity, size_t(1));
+    // Evict the least recently used entries that no longer fit
+    while (m_constraint_cache.size() > m_constraint_cache_capacity) {
+        m_constraint_cache.erase(std::min_element(
+            m_constraint_cache.begin(), m_constraint_cache.end(),
+            [](const auto& a, const auto& b) {
+                return a->last_used < b->last_used;
+            }));
+    }
+}
+
+std::shared_ptr<const Candidates> DistanceBarrierConstraint::skin_candidates(
+    const RigidBodyAssembler& bodies,
+    const PosesD& poses,
+    const Eigen::MatrixXd& V) const
+{
     const double& dhat = m_barrier_activation_distance;
     const double& dmin = minimum_separation_distance;
-    const double inflation_radius = (dhat + dmin) / 2.0;
+    const double skin = this->skin();
+    const double inflation_radius = (dhat + dmin + skin) / 2.0;
+
+    if (skin > 0) {
+        // Any pair closer than dhat + dmin now was closer than
+        // dhat + dmin + skin when the candidates were detected, as long as no
+        // vertex has moved more than skin / 2 since.
+        std::scoped_lock lock(m_skin_mutex);
+        if (m_skin_candidates != nullptr
+            && m_skin_inflation_radius == inflation_radius
+            && m_skin_vertices.rows() == V.rows()
+            && m_skin_vertices.cols() == V.cols()
+            && (V - m_skin_vertices).rowwise().squaredNorm().maxCoeff()
+                <= skin * skin / 4) {
+            return m_skin_candidates;
+        }
+    }
 
-    Candidates candidates;
+    auto candidates = std::make_shared<Candidates>();
     detect_collision_candidates_rigid(
-        bodies, poses, dim_to_collision_type(bodies.dim()), candidates,
+        bodies, poses, dim_to_collision_type(bodies.dim()), *candidates,
         detection_method, inflation_radius);
 
-    Eigen::MatrixXd V = bodies.world_vertices(poses);
-    ipc::construct_constraint_set(
-        candidates, /*V_rest=*/V, V, bodies.m_edges, bodies.m_faces,
-        /*dhat=*/dhat, constraint_set, bodies.m_faces_to_edges,
-        /*dmin=*/dmin);
+    if (skin > 0) {
+        std::scoped_lock lock(m_skin_mutex);
+        m_skin_candidates = candidates;
+        m_skin_vertices = V;
+        m_skin_inflation_radius = inflation_radius;
+    }
 
-    PROFILE_END();
+    return candidates;
+}
+
+double DistanceBarrierConstraint::skin() const
+{
+    return candidate_skin < 0 ? m_barrier_activation_distance : candidate_skin;
+}
+
+std::shared_ptr<const Constraints> DistanceBarrierConstraint::update_active_set(
+    const RigidBodyAssembler& bodies,
+    const std::shared_ptr<const Candidates>& candidates,
+    const Eigen::MatrixXd& V) const
+{
+    const Eigen::MatrixXi& E = bodies.m_edges;
+    const Eigen::MatrixXi& F = bodies.m_faces;
+    const double& dhat = m_barrier_activation_distance;
+    const double& dmin = minimum_separation_distance;
+    // Same test as ipc::construct_constraint_set
+    const double active_distance_sqr = (dhat + dmin) * (dhat + dmin);
+    // Pad the activation distance to be robust to rounding in the bounds.
+    const double near_distance = (dhat + dmin) * (1 + 1e-8);
+
+    std::shared_ptr<const ActiveSetReference> reference;
+    {
+        std::scoped_lock lock(m_skin_mutex);
+        reference = m_active_set_reference;
+    }
+
+    Eigen::VectorXd displacements;
+    if (reference != nullptr && reference->candidates == candidates
+        && reference->V.rows() == V.rows()
+        && reference->V.cols() == V.cols()) {
+        displacements = (V - reference->V).rowwise().norm();
+    } else {
+        reference = nullptr; // Evaluate every candidate
+    }
+
+    auto new_reference = std::make_shared<ActiveSetReference>();
+    new_reference->candidates = candidates;
+    new_reference->V = V;
+    new_reference->ev_distances.resize(candidates->ev_candidates.size());
+    new_reference->ee_distances.resize(candidates->ee_candidates.size());
+    new_reference->fv_distances.resize(candidates->fv_candidates.size());
+    new_reference->dhat = dhat;
+    new_reference->dmin = dmin;
+
+    // A candidate can only be active if its distance at the reference minus
+    // how far each of its primitives moved is below the activation distance.
+    // The other candidates keep this lower bound as their distance at V.
+    const auto max_displacement = [&](const auto&... vi) {
+        return std::max({ displacements(vi)... });
+    };
+    // Constraint type of each near candidate (×2, plus one if it is active)
+    // or -1 for the other candidates
+    std::vector<long> states(candidates->size(), -1);
+    const auto set_state = [&](size_t i, double& distance, int type,
+                               double distance_sqr) {
+        distance = sqrt(distance_sqr);
+        if (distance <= near_distance) {
+            states[i] = 2 * type + (distance_sqr < active_distance_sqr);
+        }
+    };
+    const size_t num_ev = candidates->ev_candidates.size();
+    const size_t num_ee = candidates->ee_candidates.size();
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, candidates->size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                if (i < num_ev) {
+                    const auto& c = candidates->ev_candidates[i];
+                    const long e0i = E(c.edge_index, 0);
+                    const long e1i = E(c.edge_index, 1);
+                    double& distance = new_reference->ev_distances(i);
+                    if (reference != nullptr) {
+                        distance = reference->ev_distances(i)
+                            - max_displacement(c.vertex_index)
+                            - max_displacement(e0i, e1i);
+                        if (distance > near_distance) {
+                            continue;
+                        }
+                    }
+                    const auto p = V.row(c.vertex_index).transpose();
+                    const auto e0 = V.row(e0i).transpose();
+                    const auto e1 = V.row(e1i).transpose();
+                    const PointEdgeDistanceType type =
+                        point_edge_distance_type(p, e0, e1);
+                    set_state(
+                        i, distance, int(type),
+                        point_edge_distance(p, e0, e1, type));
+                } else if (i - num_ev < num_ee) {
+                    const auto& c = candidates->ee_candidates[i - num_ev];
+                    const long ea0i = E(c.edge0_index, 0);
+                    const long ea1i = E(c.edge0_index, 1);
+                    const long eb0i = E(c.edge1_index, 0);
+                    const long eb1i = E(c.edge1_index, 1);
+                    double& distance = new_reference->ee_distances(i - num_ev);
+                    if (reference != nullptr) {
+                        distance = reference->ee_distances(i - num_ev)
+                            - max_displacement(ea0i, ea1i)
+                            - max_displacement(eb0i, eb1i);
+                        if (distance > near_distance) {
+                            continue;
+                        }
+                    }
+                    const auto ea0 = V.row(ea0i).transpose();
+                    const auto ea1 = V.row(ea1i).transpose();
+                    const auto eb0 = V.row(eb0i).transpose();
+                    const auto eb1 = V.row(eb1i).transpose();
+                    const EdgeEdgeDistanceType type =
+                        edge_edge_distance_type(ea0, ea1, eb0, eb1);
+                    // ipc::construct_constraint_set keeps nearly parallel
+                    // edges as mollified edge-edge constraints whatever
+                    // their closest features, so this is part of the type.
+                    const bool is_mollified =
+                        edge_edge_cross_squarednorm(ea0, ea1, eb0, eb1)
+                        < edge_edge_mollifier_threshold(ea0, ea1, eb0, eb1);
+                    set_state(
+                        i, distance, 2 * int(type) + is_mollified,
+                        edge_edge_distance(ea0, ea1, eb0, eb1, type));
+                } else {
+                    const size_t j = i - num_ev - num_ee;
+                    const auto& c = candidates->fv_candidates[j];
+                    const long f0i = F(c.face_index, 0);
+                    const long f1i = F(c.face_index, 1);
+                    const long f2i = F(c.face_index, 2);
+                    double& distance = new_reference->fv_distances(j);
+                    if (reference != nullptr) {
+                        distance = reference->fv_distances(j)
+                            - max_displacement(c.vertex_index)
+                            - max_displacement(f0i, f1i, f2i);
+                        if (distance > near_distance) {
+                            continue;
+                        }
+                    }
+                    const auto p = V.row(c.vertex_index).transpose();
+                    const auto f0 = V.row(f0i).transpose();
+                    const auto f1 = V.row(f1i).transpose();
+                    const auto f2 = V.row(f2i).transpose();
+                    const PointTriangleDistanceType type =
+                        point_triangle_distance_type(p, f0, f1, f2);
+                    set_state(
+                        i, distance, int(type),
+                        point_triangle_distance(p, f0, f1, f2, type));
+                }
+            }
+        });
 
-    cached_poses = poses;
-    cached_constraint_set = constraint_set;
+    Candidates near;
+    for (size_t i = 0; i < states.size(); i++) {
+        if (states[i] < 0) {
+            continue;
+        }
+        new_reference->active.push_back(i);
+        new_reference->active.push_back(states[i]);
+        if (i < num_ev) {
+            near.ev_candidates.push_back(candidates->ev_candidates[i]);
+        } else if (i - num_ev < num_ee) {
+            near.ee_candidates.push_back(candidates->ee_candidates[i - num_ev]);
+        } else {
+            near.fv_candidates.push_back(
+                candidates->fv_candidates[i - num_ev - num_ee]);
+        }
+    }
+
+    if (reference != nullptr && reference->dhat == dhat
+        && reference->dmin == dmin
+        && reference->active == new_reference->active) {
+        // No candidate crossed d̂, changed its closest features, or crossed
+        // the mollifier threshold, so the constraints are the same up to the
+        // mollifier thresholds (computed at V_rest = V).
+        new_reference->constraints = reference->constraints;
+        if (!reference->constraints->ee_constraints.empty()) {
+            auto constraint_set =
+                std::make_shared<Constraints>(*reference->constraints);
+            for (EdgeEdgeConstraint& c : constraint_set->ee_constraints) {
+                c.eps_x = edge_edge_mollifier_threshold(
+                    V.row(E(c.edge0_index, 0)), V.row(E(c.edge0_index, 1)),
+                    V.row(E(c.edge1_index, 0)), V.row(E(c.edge1_index, 1)));
+            }
+            new_reference->constraints = constraint_set;
+        }
+    } else {
+        new_reference->constraints = build_constraint_set(bodies, near, V);
+    }
+
+    std::scoped_lock lock(m_skin_mutex);
+    m_active_set_reference = new_reference;
+    return new_reference->constraints;
 }
 
 double DistanceBarrierConstraint::compute_minimum_distance(
     const RigidBodyAssembler& bodies, const PosesD& poses) const
 {
+    if (bodies.num_bodies() <= 1) {
+        return std::numeric_limits<double>::infinity();
+    }
+
     PROFILE_POINT("DistanceBarrierConstraint::compute_minimum_distance");
     PROFILE_START();
 
-    Constraints constraint_set;
-    construct_constraint_set(bodies, poses, constraint_set);
-    Eigen::MatrixXd V = bodies.world_vertices(poses);
-    double minimum_distance = sqrt(ipc::compute_minimum_distance(
-        V, bodies.m_edges, bodies.m_faces, constraint_set));
+    // Reuse the world vertices the (cached) constraint set was built from
+    std::shared_ptr<const ConstraintCacheEntry> entry =
+        cached_constraint_set(bodies, poses);
+    const Constraints& constraint_set = *entry->constraints;
+    const Eigen::MatrixXd& V = entry->V;
+
+    // The minimum is exact in floating point, so the result does not depend
+    // on how the range is split between threads.
+    double minimum_distance = sqrt(tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(size_t(0), constraint_set.size()),
+        std::numeric_limits<double>::infinity(),
+        [&](const tbb::blocked_range<size_t>& r, double local_min) {
+            for (size_t ci = r.begin(); ci < r.end(); ci++) {
+                local_min = std::min(
+                    local_min,
+                    constraint_set[ci].compute_distance(
+                        V, bodies.m_edges, bodies.m_faces));
+            }
+            return local_min;
+        },
+        [](double a, double b) { return std::min(a, b); }));
 
     PROFILE_END();
 
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
 #include <Eigen/Core>
 
 #include <ipc/collision_constraint.hpp>
@@ -48,10 +53,19 @@ public:
         const PosesD& poses,
         Eigen::VectorXd& barriers);
 
-    void construct_constraint_set(
-        const RigidBodyAssembler& bodies,
-        const PosesD& poses,
-        Constraints& constraint_set) const;
+    /// @brief Construct the set of active constraints at the given poses.
+    ///
+    /// Recently constructed sets are cached (keyed by a hash of the poses), so
+    /// repeated queries at the same poses share the same set. This is safe to
+    /// call from multiple threads.
+    std::shared_ptr<const Constraints> construct_constraint_set(
+        const RigidBodyAssembler& bodies, const PosesD& poses) const;
+
+    /// @brief Drop all cached constraint sets and candidates.
+    void clear_cache() const;
+
+    /// @brief Set the number of constraint sets to keep (at least one).
+    void set_constraint_cache_capacity(size_t capacity);
 
     template <typename T>
     T distance_barrier(const T& distance, const double dhat) const;
@@ -83,7 +97,34 @@ public:
 
     double minimum_separation_distance;
 
+    /// @brief Extra distance (Verlet skin) added to the broad-phase
+    /// inflation radius. Candidates are reused until a vertex moves more than
+    /// half of the skin. Zero disables the reuse and a negative value uses
+    /// d̂ as the skin.
+    ///
+    /// While candidates are reused, the active set is also maintained
+    /// incrementally: only candidates whose distance could have dropped below
+    /// d̂ (given how far their vertices moved) are re-evaluated, and the
+    /// previous constraint set is reused if none of them changed.
+    double candidate_skin;
+
+    /// @brief Sort the constraints by (body pair, primitive index), so
+    /// constraints acting on the same pair of bodies are contiguous.
+    bool sort_constraints;
+
 protected:
+    /// @brief A cached constraint set and the poses it was constructed at.
+    struct ConstraintCacheEntry {
+        size_t key;
+        double dhat;
+        double dmin;
+        PosesD poses;
+        /// @brief World vertices at the poses.
+        Eigen::MatrixXd V;
+        std::shared_ptr<const Constraints> constraints;
+        std::atomic<size_t> last_used;
+    };
+
     bool has_active_collisions_narrow_phase(
         const RigidBodyAssembler& bodies,
         const PosesD& poses_t0,
@@ -96,8 +137,75 @@ protected:
         const PosesD& poses_t1,
         const Candidates& candidates) const;
 
+    /// @brief Get the broad-phase candidates for the world vertices V.
+    std::shared_ptr<const Candidates> skin_candidates(
+        const RigidBodyAssembler& bodies,
+        const PosesD& poses,
+        const Eigen::MatrixXd& V) const;
+
+    /// @brief Get the cache entry for the poses, constructing it on a miss.
+    std::shared_ptr<const ConstraintCacheEntry> cached_constraint_set(
+        const RigidBodyAssembler& bodies, const PosesD& poses) const;
+
+    /// @brief Sort each constraint type by (body pair, primitive index).
+    void sort_constraint_set(
+        const RigidBodyAssembler& bodies, Constraints& constraint_set) const;
+
+    /// @brief Skin added to the broad-phase inflation radius.
+    double skin() const;
+
+    /// @brief Construct the constraint set of candidates at V.
+    std::shared_ptr<const Constraints> build_constraint_set(
+        const RigidBodyAssembler& bodies,
+        const Candidates& candidates,
+        const Eigen::MatrixXd& V) const;
+
+    /// @brief Update the constraint set of reused skin candidates at V.
+    std::shared_ptr<const Constraints> update_active_set(
+        const RigidBodyAssembler& bodies,
+        const std::shared_ptr<const Candidates>& candidates,
+        const Eigen::MatrixXd& V) const;
+
     /// @brief Max distance, d̂, at which the barrier forces are activate.
     double m_barrier_activation_distance;
+
+    /// @brief Least recently used cache of constraint sets.
+    mutable std::vector<std::shared_ptr<ConstraintCacheEntry>>
+        m_constraint_cache;
+    /// @brief Maximum number of constraint sets to keep (guarded by
+    /// m_constraint_cache_mutex).
+    size_t m_constraint_cache_capacity;
+    /// @brief Counter used to order the cache entries by last use.
+    mutable std::atomic<size_t> m_constraint_cache_clock;
+    mutable std::shared_mutex m_constraint_cache_mutex;
+
+    /// @brief Candidates detected with the skin inflated radius.
+    mutable std::shared_ptr<const Candidates> m_skin_candidates;
+    /// @brief World vertices the skin candidates were detected at.
+    mutable Eigen::MatrixXd m_skin_vertices;
+    /// @brief Inflation radius used for the skin candidates (<0 if invalid).
+    mutable double m_skin_inflation_radius;
+    mutable std::mutex m_skin_mutex;
+
+    /// @brief Active set of the skin candidates at the last update.
+    struct ActiveSetReference {
+        std::shared_ptr<const Candidates> candidates;
+        Eigen::MatrixXd V;
+        /// @brief Lower bounds of the candidate distances at V (exact for
+        /// the candidates evaluated at V).
+        Eigen::VectorXd ev_distances;
+        Eigen::VectorXd ee_distances;
+        Eigen::VectorXd fv_distances;
+        double dhat;
+        double dmin;
+        /// @brief Indices and constraint types (distance type, mollifier
+        /// state, and activity) of the near candidates.
+        std::vector<long> active;
+        std::shared_ptr<const Constraints> constraints;
+    };
+    /// @brief Reference used to filter the skin candidates (guarded by
+    /// m_skin_mutex).
+    mutable std::shared_ptr<const ActiveSetReference> m_active_set_reference;
 };
 
 } // namespace ipc::rigid
@@ -0,0 +1,71 @@
+#include "dof_reduction.hpp"
+
+namespace ipc::rigid {
+
+DofReduction::DofReduction(const Eigen::VectorXi& free_dof, int num_dof)
+    : m_free_dof(free_dof)
+{
+    m_full_to_free.setConstant(num_dof, -1);
+    for (int i = 0; i < free_dof.size(); i++) {
+        assert(i == 0 || free_dof(i - 1) < free_dof(i));
+        m_full_to_free(free_dof(i)) = i;
+    }
+}
+
+void DofReduction::reduce(
+    const Eigen::VectorXd& x, Eigen::VectorXd& x_free) const
+{
+    assert(x.size() == num_dof());
+    if (is_identity()) {
+        x_free = x;
+        return;
+    }
+    x_free.resize(num_free_dof());
+    for (int i = 0; i < num_free_dof(); i++) {
+        x_free(i) = x(m_free_dof(i));
+    }
+}
+
+void DofReduction::reduce(
+    Eigen::SparseMatrix<double>& A, Eigen::SparseMatrix<double>& A_free) const
+{
+    assert(A.rows() == num_dof() && A.cols() == num_dof());
+    if (is_identity()) {
+        A_free.swap(A);
+        return;
+    }
+
+    // The free DoF are sorted, so the reduced entries stay sorted and can be
+    // inserted in order.
+    A_free.resize(num_free_dof(), num_free_dof());
+    A_free.reserve(A.nonZeros());
+    for (int j = 0; j < A.outerSize(); j++) {
+        const int j_free = m_full_to_free(j);
+        if (j_free < 0) {
+            continue;
+        }
+        A_free.startVec(j_free);
+        for (Eigen::SparseMatrix<double>::InnerIterator it(A, j); it; ++it) {
+            const int i_free = m_full_to_free(it.row());
+            if (i_free >= 0) {
+                A_free.insertBack(i_free, j_free) = it.value();
+            }
+        }
+    }
+    A_free.finalize();
+}
+
+void DofReduction::expand(
+    const Eigen::VectorXd& x_free, Eigen::VectorXd& x) const
+{
+    assert(x_free.size() == num_free_dof() && x.size() == num_dof());
+    if (is_identity()) {
+        x = x_free;
+        return;
+    }
+    for (int i = 0; i < num_free_dof(); i++) {
+        x(m_free_dof(i)) = x_free(i);
+    }
+}
+
+} // namespace ipc::rigid
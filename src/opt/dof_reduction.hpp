@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+namespace ipc::rigid {
+
+/// @brief Map between all DoF of a problem and its free (unfixed) DoF.
+///
+/// The map is built once from the (sorted) free DoF and used to reduce
+/// vectors and matrices without igl::slice's selection matrix products.
+/// When every DoF is free, reductions are swaps or plain copies.
+class DofReduction {
+public:
+    DofReduction() = default;
+    DofReduction(const Eigen::VectorXi& free_dof, int num_dof);
+
+    int num_dof() const { return int(m_full_to_free.size()); }
+    int num_free_dof() const { return int(m_free_dof.size()); }
+    const Eigen::VectorXi& free_dof() const { return m_free_dof; }
+    /// @brief Are all DoF free?
+    bool is_identity() const { return num_free_dof() == num_dof(); }
+
+    /// @brief Extract the free entries of a full vector.
+    void reduce(const Eigen::VectorXd& x, Eigen::VectorXd& x_free) const;
+
+    /// @brief Extract the free rows and columns of a full matrix.
+    /// @note A is left in an unspecified (but valid) state.
+    void reduce(
+        Eigen::SparseMatrix<double>& A,
+        Eigen::SparseMatrix<double>& A_free) const;
+
+    /// @brief Write the free entries into a full vector (fixed entries are
+    /// left unchanged).
+    void expand(const Eigen::VectorXd& x_free, Eigen::VectorXd& x) const;
+
+protected:
+    /// @brief Sorted indices of the free DoF.
+    Eigen::VectorXi m_free_dof;
+    /// @brief Index of each DoF in the free DoF (-1 if fixed).
+    Eigen::VectorXi m_full_to_free;
+};
+
+} // namespace ipc::rigid
@@ -5,7 +5,9 @@
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
+#include <opt/body_block_hessian.hpp>
 #include <utils/eigen_ext.hpp>
+#include <utils/not_implemented_error.hpp>
 
 namespace ipc::rigid {
 
@@ -21,6 +23,17 @@ public:
         bool compute_grad = true,
         bool compute_hess = true) = 0;
 
+    /// Compute the objective function f(x) and its gradient with the Hessian
+    /// left unassembled as dense blocks of body DoF.
+    virtual double compute_objective_blocks(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BodyBlockHessian& hess)
+    {
+        throw NotImplementedError(
+            "compute_objective_blocks not implemented for this problem!");
+    }
+
     // --------------------------------------------------------------------
     // Convience functions
     // --------------------------------------------------------------------
@@ -43,6 +56,13 @@ public:
             /*compute_grad=*/true, /*compute_hess=*/false);
     }
 
+    /// Hash identifying the set of active constraints at x. Solvers reusing
+    /// a Hessian refresh it when this changes.
+    virtual size_t active_set_hash(const Eigen::VectorXd& x) const
+    {
+        return 0;
+    }
+
     virtual void update_augmented_lagrangian(const Eigen::VectorXd& x) {}
     virtual bool
     are_equality_constraints_satisfied(const Eigen::VectorXd& x) const
@@ -68,6 +88,14 @@ public:
         return free_dof;
     }
 
+    /// Can compute_objective(x) and has_collisions() run concurrently on
+    /// multiple threads (e.g., in a batched line search)?
+    virtual bool is_thread_safe() const { return false; }
+
+    /// Number of objectives a solver may evaluate concurrently, so cached
+    /// evaluations can be sized for them.
+    virtual void set_num_concurrent_evaluations(int num_evaluations) {}
+
     /// Determine if there is a collision between two configurations
     virtual bool
     has_collisions(const Eigen::VectorXd& xi, const Eigen::VectorXd& xj) = 0;
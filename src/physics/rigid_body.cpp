@@ -14,37 +14,8 @@
 
 namespace ipc::rigid {
 
-void center_vertices(
-    Eigen::MatrixXd& vertices,
-    const Eigen::MatrixXi& edges,
-    const Eigen::MatrixXi& faces,
-    PoseD& pose)
-{
-    int dim = vertices.cols();
-
-    vertices.rowwise() += pose.position.transpose();
-
-    // compute the center of mass several times to get more accurate
-    pose.position.setZero(dim);
-    for (int i = 0; i < 10; i++) {
-        double mass;
-        VectorMax3d com;
-        MatrixMax3d inertia;
-        compute_mass_properties(
-            vertices, dim == 2 || faces.size() == 0 ? edges : faces, mass, com,
-            inertia);
-        vertices.rowwise() -= com.transpose();
-        pose.position += com;
-        if (com.squaredNorm() < 1e-8) {
-            break;
-        }
-    }
-}
-
 RigidBody::RigidBody(
-    const Eigen::MatrixXd& vertices,
-    const Eigen::MatrixXi& edges,
-    const Eigen::MatrixXi& faces,
+    std::shared_ptr<const RigidBodyGeometry> geometry,
     const PoseD& pose,
     const PoseD& velocity,
     const PoseD& force,
@@ -57,23 +28,26 @@ RigidBody::RigidBody(
     const std::deque<PoseD>& kinematic_poses)
     : group_id(group_id)
     , type(type)
-    , vertices(vertices)
-    , edges(edges)
-    , faces(faces)
+    , geometry(geometry)
     , is_dof_fixed(is_dof_fixed)
     , is_oriented(oriented)
-    , mesh_selector(vertices.rows(), edges, faces)
     , pose(pose)
     , velocity(velocity)
     , force(force)
     , kinematic_max_time(kinematic_max_time)
     , kinematic_poses(kinematic_poses)
 {
+    assert(geometry != nullptr);
     assert(dim() == pose.dim());
     assert(dim() == velocity.dim());
     assert(dim() == force.dim());
-    assert(edges.size() == 0 || edges.cols() == 2);
-    assert(faces.size() == 0 || faces.cols() == 3);
+    // Static bodies ignore their mass properties, so any geometry will do
+    assert(
+        type == RigidBodyType::STATIC
+        || geometry->is_aligned_to_principal_axes
+            == (dim() == 3
+                && RigidBodyGeometry::align_to_principal_axes(
+                    dim(), is_dof_fixed)));
 
     if (type == RigidBodyType::STATIC) {
         this->is_dof_fixed.setOnes(this->is_dof_fixed.size());
@@ -81,60 +55,31 @@ RigidBody::RigidBody(
         this->type = RigidBodyType::STATIC;
     }
 
-    center_vertices(this->vertices, edges, faces, this->pose);
-    VectorMax3d center_of_mass;
-    MatrixMax3d I;
-    compute_mass_properties(
-        this->vertices,
-        dim() == 2 || faces.size() == 0 ? edges : faces, //
-        mass, center_of_mass, I);
-    // assert(center_of_mass.squaredNorm() < 1e-8);
+    // The geometry is centered at its center of mass
+    this->pose.position += geometry->center_of_mass;
 
     // Mass above is actually volume in m³ and density is Kg/m³
-    mass *= density;
+    mass = density * geometry->volume;
+    R0 = geometry->R0;
     if (dim() == 3) {
-        // Got this from Chrono: https://bit.ly/2RpbTl1
-        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es;
-        double threshold = I.lpNorm<Eigen::Infinity>() * 1e-16;
-        I = (threshold < I.array().abs()).select(I, 0.0);
-        es.compute(I);
-        if (es.info() != Eigen::Success) {
-            spdlog::error("Eigen decompostion of the inertia tensor failed!");
-        }
-        moment_of_inertia = density * es.eigenvalues();
-        if ((moment_of_inertia.array() < 0).any()) {
-            spdlog::warn(
-                "Negative moment of inertia ({}), inverting.",
-                fmt_eigen(moment_of_inertia));
-            // Avoid negative epsilon inertias
-            moment_of_inertia =
-                (moment_of_inertia.array() < 0)
-                    .select(-moment_of_inertia, moment_of_inertia);
-        }
-        R0 = es.eigenvectors();
-        // Ensure that we have an orientation preserving transform
-        if (R0.determinant() < 0.0) {
-            R0.col(0) *= -1.0;
-        }
-        assert(R0.isUnitary(1e-9));
-        assert(fabs(R0.determinant() - 1.0) <= 1.0e-9);
         int num_rot_dof_fixed =
             is_dof_fixed.tail(PoseD::dim_to_rot_ndof(dim())).count();
         if (num_rot_dof_fixed == 2) {
             // Convert moment of inertia to world coordinates
             // https://physics.stackexchange.com/a/268812
+            const MatrixMax3d& I = geometry->inertia;
             moment_of_inertia = -I.diagonal().array() + I.diagonal().sum();
-            R0.setIdentity();
-        } else if (num_rot_dof_fixed == 1) {
-            spdlog::warn("Rigid body dynamics with two rotational DoF has "
-                         "not been tested thoroughly.");
+        } else {
+            moment_of_inertia = density * geometry->moment_of_inertia;
+            if (num_rot_dof_fixed == 1) {
+                spdlog::warn("Rigid body dynamics with two rotational DoF has "
+                             "not been tested thoroughly.");
+            }
         }
         // R = RᵢR₀
         Eigen::AngleAxisd r = Eigen::AngleAxisd(
             Eigen::Matrix3d(this->pose.construct_rotation_matrix() * R0));
         this->pose.rotation = r.angle() * r.axis();
-        // v = Rv₀ + p = RᵢR₀v₀ + p = RᵢR₀R₀ᵀv₀ + p
-        this->vertices = this->vertices * R0; // R₀ᵀ * V₀ᵀ = V₀ * R₀
         // ω = R₀ᵀω₀ (ω₀ expressed in body coordinates)
         this->velocity.rotation = R0.transpose() * this->velocity.rotation;
         Eigen::Matrix3d Q_t0 = this->pose.construct_rotation_matrix();
@@ -143,8 +88,7 @@ RigidBody::RigidBody(
         // NOTE: this transformation will be done later
         // this->force.rotation = R0.transpose() * this->force.rotation;
     } else {
-        moment_of_inertia = density * I.diagonal();
-        R0 = Eigen::Matrix<double, 1, 1>::Identity();
+        moment_of_inertia = density * geometry->moment_of_inertia;
     }
 
     // Zero out the velocity and forces of fixed dof
@@ -164,68 +108,19 @@ RigidBody::RigidBody(
     mass_matrix.diagonal().head(pos_ndof()).setConstant(mass);
     mass_matrix.diagonal().tail(rot_ndof()) = moment_of_inertia;
 
-    r_max = this->vertices.rowwise().norm().maxCoeff();
-
-    average_edge_length = 0;
-    for (long i = 0; i < edges.rows(); i++) {
-        average_edge_length +=
-            (this->vertices.row(edges(i, 0)) - this->vertices.row(edges(i, 1)))
-                .norm();
-    }
-    if (edges.rows() > 0) {
-        average_edge_length /= edges.rows();
-    }
-    assert(std::isfinite(average_edge_length));
-
-    init_bvh();
+    r_max = geometry->r_max;
+    average_edge_length = geometry->average_edge_length;
 }
 
-void RigidBody::init_bvh()
+void RigidBody::vertices(const Eigen::MatrixXd& vertices)
 {
-    PROFILE_POINT("RigidBody::init_bvh");
-    PROFILE_START();
-
-    // heterogenous bounding boxes
-    std::vector<std::array<Eigen::Vector3d, 2>> aabbs(
-        num_codim_vertices() + num_codim_edges() + num_faces());
-
-    for (size_t i = 0; i < num_codim_vertices(); i++) {
-        size_t vi = mesh_selector.codim_vertices_to_vertices(i);
-        if (dim() == 2) {
-            aabbs[i][0][2] = 0;
-            aabbs[i][1][2] = 0;
-        }
-        aabbs[i][0].head(dim()) = vertices.row(i);
-        aabbs[i][1].head(dim()) = vertices.row(i);
-    }
-
-    size_t start_i = num_codim_vertices();
-    for (size_t i = 0; i < num_codim_edges(); i++) {
-        size_t ei = mesh_selector.codim_edges_to_edges(i);
-        const auto& e0 = vertices.row(edges(ei, 0));
-        const auto& e1 = vertices.row(edges(ei, 1));
-
-        if (dim() == 2) {
-            aabbs[start_i + i][0][2] = 0;
-            aabbs[start_i + i][1][2] = 0;
-        }
-        aabbs[start_i + i][0].head(dim()) = e0.cwiseMin(e1);
-        aabbs[start_i + i][1].head(dim()) = e0.cwiseMax(e1);
-    }
-
-    start_i += num_codim_edges();
-    for (size_t i = 0; i < num_faces(); i++) {
-        assert(dim() == 3);
-        const auto& f0 = vertices.row(faces(i, 0));
-        const auto& f1 = vertices.row(faces(i, 1));
-        const auto& f2 = vertices.row(faces(i, 2));
-        aabbs[start_i + i][0] = f0.cwiseMin(f1).cwiseMin(f2);
-        aabbs[start_i + i][1] = f0.cwiseMax(f1).cwiseMax(f2);
-    }
-
-    bvh.init(aabbs);
-
-    PROFILE_END();
+    assert(vertices.rows() == num_vertices() && vertices.cols() == dim());
+    // Other instances keep using the shared geometry
+    std::shared_ptr<RigidBodyGeometry> copy =
+        std::make_shared<RigidBodyGeometry>(*geometry);
+    copy->vertices = vertices;
+    copy->init_bvh();
+    geometry = copy;
 }
 
 Eigen::MatrixXd RigidBody::world_velocities() const
@@ -235,10 +130,10 @@ Eigen::MatrixXd RigidBody::world_velocities() const
     if (dim() == 2) {
         MatrixMax3d Q_dt =
             pose.construct_rotation_matrix() * Hat(velocity.rotation);
-        return (vertices * Q_dt.transpose()).rowwise()
+        return (vertices() * Q_dt.transpose()).rowwise()
             + velocity.position.transpose();
     }
-    return (vertices * Qdot.transpose()).rowwise()
+    return (vertices() * Qdot.transpose()).rowwise()
         + velocity.position.transpose();
 }
 
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <deque>
+#include <memory>
 
 #include <Eigen/Core>
 #include <nlohmann/json.hpp>
 
 #include <physics/pose.hpp>
+#include <physics/rigid_body_geometry.hpp>
 #include <utils/eigen_ext.hpp>
 
 #include <BVH.hpp>
@@ -42,6 +44,46 @@ public:
         const bool oriented,
         const int group_id,
         const RigidBodyType type = RigidBodyType::DYNAMIC,
+        const double kinematic_max_time =
+            std::numeric_limits<double>::infinity(),
+        const std::deque<PoseD>& kinematic_poses = std::deque<PoseD>())
+        : RigidBody(
+              std::make_shared<const RigidBodyGeometry>(
+                  vertices,
+                  edges,
+                  faces,
+                  RigidBodyGeometry::align_to_principal_axes(
+                      vertices.cols(), is_dof_fixed)),
+              pose,
+              velocity,
+              force,
+              density,
+              is_dof_fixed,
+              oriented,
+              group_id,
+              type,
+              kinematic_max_time,
+              kinematic_poses)
+    {
+    }
+
+    /**
+     * @brief Create rigid body instance of a shared geometry.
+     *
+     * @param geometry  Geometry in body space (must be aligned to the
+     *                  principal axes unless two rotational DoF are fixed)
+     * @param pose      Pose of the input frame of the geometry
+     */
+    RigidBody(
+        std::shared_ptr<const RigidBodyGeometry> geometry,
+        const PoseD& pose,
+        const PoseD& velocity,
+        const PoseD& force,
+        const double density,
+        const VectorMax6b& is_dof_fixed,
+        const bool oriented,
+        const int group_id,
+        const RigidBodyType type = RigidBodyType::DYNAMIC,
         const double kinematic_max_time =
             std::numeric_limits<double>::infinity(),
         const std::deque<PoseD>& kinematic_poses = std::deque<PoseD>());
@@ -150,20 +192,17 @@ public:
 
     double edge_length(int edge_id) const
     {
-        return (vertices.row(edges(edge_id, 1))
-                - vertices.row(edges(edge_id, 0)))
+        return (vertices().row(edges()(edge_id, 1))
+                - vertices().row(edges()(edge_id, 0)))
             .norm();
     }
 
-    long num_vertices() const { return vertices.rows(); }
-    long num_edges() const { return edges.rows(); }
-    long num_faces() const { return faces.rows(); }
-    long num_codim_vertices() const
-    {
-        return mesh_selector.num_codim_vertices();
-    }
-    long num_codim_edges() const { return mesh_selector.num_codim_edges(); }
-    int dim() const { return vertices.cols(); }
+    long num_vertices() const { return geometry->num_vertices(); }
+    long num_edges() const { return geometry->num_edges(); }
+    long num_faces() const { return geometry->num_faces(); }
+    long num_codim_vertices() const { return geometry->num_codim_vertices(); }
+    long num_codim_edges() const { return geometry->num_codim_edges(); }
+    int dim() const { return geometry->dim(); }
     int ndof() const { return pose.ndof(); }
     int pos_ndof() const { return pose.pos_ndof(); }
     int rot_ndof() const { return pose.rot_ndof(); }
@@ -207,9 +246,23 @@ public:
     // --------------------------------------------------------------------
     // Geometry
     // --------------------------------------------------------------------
-    Eigen::MatrixXd vertices; ///< Vertices positions in body space
-    Eigen::MatrixXi edges;    ///< Vertices connectivity
-    Eigen::MatrixXi faces;    ///< Vertices connectivity
+    /// @brief Geometry shared by all instances of the same mesh
+    std::shared_ptr<const RigidBodyGeometry> geometry;
+
+    /// @brief Vertices positions in body space
+    const Eigen::MatrixXd& vertices() const { return geometry->vertices; }
+    /// @brief Replace the vertices in body space (copying the geometry).
+    void vertices(const Eigen::MatrixXd& vertices);
+    /// @brief Vertices connectivity
+    const Eigen::MatrixXi& edges() const { return geometry->edges; }
+    /// @brief Vertices connectivity
+    const Eigen::MatrixXi& faces() const { return geometry->faces; }
+    /// @brief Local space BVH initalized at construction
+    const BVH::BVH& bvh() const { return geometry->bvh; }
+    const MeshSelector& mesh_selector() const
+    {
+        return geometry->mesh_selector;
+    }
 
     double average_edge_length; ///< Average edge length
 
@@ -230,10 +283,6 @@ public:
     /// @brief Use edge orientation for normal in 2D restitution
     bool is_oriented;
 
-    /// @brief Local space BVH initalized at construction
-    BVH::BVH bvh;
-    MeshSelector mesh_selector;
-
     // --------------------------------------------------------------------
     // State
     // --------------------------------------------------------------------
@@ -259,9 +308,6 @@ public:
     // --------------------------------------------------------------------
     double kinematic_max_time;
     std::deque<PoseD> kinematic_poses;
-
-protected:
-    void init_bvh();
 };
 
 } // namespace ipc::rigid
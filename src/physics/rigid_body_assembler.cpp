@@ -30,8 +30,8 @@ void RigidBodyAssembler::init(const std::vector<RigidBody>& rigid_bodies)
     for (size_t i = 0; i < num_bodies; ++i) {
         auto& rb = rigid_bodies[i];
         m_body_vertex_id[i + 1] = m_body_vertex_id[i] + rb.num_vertices();
-        m_body_face_id[i + 1] = m_body_face_id[i] + rb.faces.rows();
-        m_body_edge_id[i + 1] = m_body_edge_id[i] + rb.edges.rows();
+        m_body_face_id[i + 1] = m_body_face_id[i] + rb.faces().rows();
+        m_body_edge_id[i + 1] = m_body_edge_id[i] + rb.edges().rows();
     }
 
     // global edges and faces
@@ -41,17 +41,17 @@ void RigidBodyAssembler::init(const std::vector<RigidBody>& rigid_bodies)
     m_codim_edges_to_edges.clear();
     for (size_t i = 0; i < num_bodies; ++i) {
         auto& rb = rigid_bodies[i];
-        if (rb.edges.size() != 0) {
-            m_edges.block(m_body_edge_id[i], 0, rb.edges.rows(), 2) =
-                rb.edges.array() + m_body_vertex_id[i];
+        if (rb.edges().size() != 0) {
+            m_edges.block(m_body_edge_id[i], 0, rb.edges().rows(), 2) =
+                rb.edges().array() + m_body_vertex_id[i];
         }
-        if (rb.faces.size() != 0) {
-            m_faces.block(m_body_face_id[i], 0, rb.faces.rows(), 3) =
-                rb.faces.array() + m_body_vertex_id[i];
-            m_faces_to_edges.block(m_body_face_id[i], 0, rb.faces.rows(), 3) =
-                rb.mesh_selector.face_to_edges().array() + m_body_edge_id[i];
+        if (rb.faces().size() != 0) {
+            m_faces.block(m_body_face_id[i], 0, rb.faces().rows(), 3) =
+                rb.faces().array() + m_body_vertex_id[i];
+            m_faces_to_edges.block(m_body_face_id[i], 0, rb.faces().rows(), 3) =
+                rb.mesh_selector().face_to_edges().array() + m_body_edge_id[i];
         }
-        for (const auto& ei : rb.mesh_selector.codim_edges_to_edges()) {
+        for (const auto& ei : rb.mesh_selector().codim_edges_to_edges()) {
             m_codim_edges_to_edges.push_back(ei + m_body_edge_id[i]);
         }
     }
@@ -95,7 +95,7 @@ void RigidBodyAssembler::init(const std::vector<RigidBody>& rigid_bodies)
 
     average_edge_length = 0;
     for (const auto& body : rigid_bodies) {
-        average_edge_length += body.edges.rows() * body.average_edge_length;
+        average_edge_length += body.edges().rows() * body.average_edge_length;
     }
     average_edge_length /= m_edges.rows();
     assert(std::isfinite(average_edge_length));
@@ -0,0 +1,207 @@
+#include "rigid_body_geometry.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <io/checkpoint.hpp>
+#include <logger.hpp>
+#include <physics/mass.hpp>
+#include <physics/pose.hpp>
+#include <profiler.hpp>
+
+namespace ipc::rigid {
+
+void center_vertices(
+    Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces,
+    VectorMax3d& center_of_mass)
+{
+    int dim = vertices.cols();
+
+    // compute the center of mass several times to get more accurate
+    center_of_mass.setZero(dim);
+    for (int i = 0; i < 10; i++) {
+        double mass;
+        VectorMax3d com;
+        MatrixMax3d inertia;
+        compute_mass_properties(
+            vertices, dim == 2 || faces.size() == 0 ? edges : faces, mass, com,
+            inertia);
+        vertices.rowwise() -= com.transpose();
+        center_of_mass += com;
+        if (com.squaredNorm() < 1e-8) {
+            break;
+        }
+    }
+}
+
+RigidBodyGeometry::RigidBodyGeometry(
+    const Eigen::MatrixXd& vertices,
+    const Eigen::MatrixXi& edges,
+    const Eigen::MatrixXi& faces,
+    bool align_to_principal_axes)
+    : vertices(vertices)
+    , edges(edges)
+    , faces(faces)
+    , mesh_selector(vertices.rows(), edges, faces)
+    , is_aligned_to_principal_axes(
+          vertices.cols() == 3 && align_to_principal_axes)
+{
+    assert(edges.size() == 0 || edges.cols() == 2);
+    assert(faces.size() == 0 || faces.cols() == 3);
+
+    center_vertices(this->vertices, edges, faces, center_of_mass);
+    VectorMax3d residual_center_of_mass;
+    compute_mass_properties(
+        this->vertices,
+        dim() == 2 || faces.size() == 0 ? edges : faces, //
+        volume, residual_center_of_mass, inertia);
+
+    if (dim() == 3) {
+        // Got this from Chrono: https://bit.ly/2RpbTl1
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es;
+        double threshold = inertia.lpNorm<Eigen::Infinity>() * 1e-16;
+        inertia = (threshold < inertia.array().abs()).select(inertia, 0.0);
+        es.compute(inertia);
+        if (es.info() != Eigen::Success) {
+            spdlog::error("Eigen decompostion of the inertia tensor failed!");
+        }
+        moment_of_inertia = es.eigenvalues();
+        if ((moment_of_inertia.array() < 0).any()) {
+            spdlog::warn(
+                "Negative moment of inertia ({}), inverting.",
+                fmt_eigen(moment_of_inertia));
+            // Avoid negative epsilon inertias
+            moment_of_inertia =
+                (moment_of_inertia.array() < 0)
+                    .select(-moment_of_inertia, moment_of_inertia);
+        }
+        R0 = es.eigenvectors();
+        // Ensure that we have an orientation preserving transform
+        if (R0.determinant() < 0.0) {
+            R0.col(0) *= -1.0;
+        }
+        assert(R0.isUnitary(1e-9));
+        assert(fabs(R0.determinant() - 1.0) <= 1.0e-9);
+        if (is_aligned_to_principal_axes) {
+            // v = Rv₀ + p = RᵢR₀v₀ + p = RᵢR₀R₀ᵀv₀ + p
+            this->vertices = this->vertices * R0; // R₀ᵀ * V₀ᵀ = V₀ * R₀
+        } else {
+            R0.setIdentity();
+        }
+    } else {
+        moment_of_inertia = inertia.diagonal();
+        R0 = Eigen::Matrix<double, 1, 1>::Identity();
+    }
+
+    r_max = this->vertices.rowwise().norm().maxCoeff();
+
+    average_edge_length = 0;
+    for (long i = 0; i < edges.rows(); i++) {
+        average_edge_length +=
+            (this->vertices.row(edges(i, 0)) - this->vertices.row(edges(i, 1)))
+                .norm();
+    }
+    if (edges.rows() > 0) {
+        average_edge_length /= edges.rows();
+    }
+    assert(std::isfinite(average_edge_length));
+
+    init_bvh();
+}
+
+bool RigidBodyGeometry::align_to_principal_axes(
+    int dim, const VectorMax6b& is_dof_fixed)
+{
+    return dim != 3
+        || is_dof_fixed.tail(PoseD::dim_to_rot_ndof(dim)).count() != 2;
+}
+
+void RigidBodyGeometry::write(CheckpointBuffer& buffer) const
+{
+    buffer.write_matrix(vertices);
+    buffer.write_matrix(edges);
+    buffer.write_matrix(faces);
+    mesh_selector.write(buffer);
+    buffer.write_value(average_edge_length);
+    buffer.write_value(r_max);
+    buffer.write_matrix(center_of_mass);
+    buffer.write_value(volume);
+    buffer.write_matrix(inertia);
+    buffer.write_matrix(moment_of_inertia);
+    buffer.write_matrix(R0);
+    buffer.write_value(is_aligned_to_principal_axes);
+}
+
+std::shared_ptr<RigidBodyGeometry>
+RigidBodyGeometry::read(CheckpointBuffer& buffer)
+{
+    std::shared_ptr<RigidBodyGeometry> geometry(new RigidBodyGeometry());
+    buffer.read_matrix(geometry->vertices);
+    buffer.read_matrix(geometry->edges);
+    buffer.read_matrix(geometry->faces);
+    geometry->mesh_selector.read(buffer);
+    geometry->average_edge_length = buffer.read_value<double>();
+    geometry->r_max = buffer.read_value<double>();
+    buffer.read_matrix(geometry->center_of_mass);
+    geometry->volume = buffer.read_value<double>();
+    buffer.read_matrix(geometry->inertia);
+    buffer.read_matrix(geometry->moment_of_inertia);
+    buffer.read_matrix(geometry->R0);
+    geometry->is_aligned_to_principal_axes = buffer.read_value<bool>();
+    if (!buffer.good()) {
+        return nullptr;
+    }
+    geometry->init_bvh();
+    return geometry;
+}
+
+void RigidBodyGeometry::init_bvh()
+{
+    PROFILE_POINT("RigidBodyGeometry::init_bvh");
+    PROFILE_START();
+
+    // heterogenous bounding boxes
+    std::vector<std::array<Eigen::Vector3d, 2>> aabbs(
+        num_codim_vertices() + num_codim_edges() + num_faces());
+
+    for (size_t i = 0; i < num_codim_vertices(); i++) {
+        size_t vi = mesh_selector.codim_vertices_to_vertices(i);
+        if (dim() == 2) {
+            aabbs[i][0][2] = 0;
+            aabbs[i][1][2] = 0;
+        }
+        aabbs[i][0].head(dim()) = vertices.row(i);
+        aabbs[i][1].head(dim()) = vertices.row(i);
+    }
+
+    size_t start_i = num_codim_vertices();
+    for (size_t i = 0; i < num_codim_edges(); i++) {
+        size_t ei = mesh_selector.codim_edges_to_edges(i);
+        const auto& e0 = vertices.row(edges(ei, 0));
+        const auto& e1 = vertices.row(edges(ei, 1));
+
+        if (dim() == 2) {
+            aabbs[start_i + i][0][2] = 0;
+            aabbs[start_i + i][1][2] = 0;
+        }
+        aabbs[start_i + i][0].head(dim()) = e0.cwiseMin(e1);
+        aabbs[start_i + i][1].head(dim()) = e0.cwiseMax(e1);
+    }
+
+    start_i += num_codim_edges();
+    for (size_t i = 0; i < num_faces(); i++) {
+        assert(dim() == 3);
+        const auto& f0 = vertices.row(faces(i, 0));
+        const auto& f1 = vertices.row(faces(i, 1));
+        const auto& f2 = vertices.row(faces(i, 2));
+        aabbs[start_i + i][0] = f0.cwiseMin(f1).cwiseMin(f2);
+        aabbs[start_i + i][1] = f0.cwiseMax(f1).cwiseMax(f2);
+    }
+
+    bvh.init(aabbs);
+
+    PROFILE_END();
+}
+
+} // namespace ipc::rigid
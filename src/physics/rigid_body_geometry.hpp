@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+
+#include <Eigen/Core>
+
+#include <utils/eigen_ext.hpp>
+
+#include <BVH.hpp>
+#include <utils/mesh_selector.hpp>
+
+namespace ipc::rigid {
+
+class CheckpointBuffer;
+
+/**
+ * @brief Immutable body-space geometry and unit-density mass properties of
+ * a rigid body.
+ *
+ * The mesh is centered at its center of mass and (in 3D) rotated to its
+ * principal axes. Bodies created from the same mesh, scale, and transform
+ * share a single instance through a std::shared_ptr<const
+ * RigidBodyGeometry>, so memory and setup time scale with the number of
+ * unique meshes rather than the number of bodies.
+ */
+class RigidBodyGeometry {
+public:
+    /**
+     * @brief Center and align a mesh and build its acceleration structures.
+     *
+     * @param vertices  Vertices in the input frame
+     * @param edges     Vertices pairs of the edges
+     * @param faces     Vertices triplets of the faces
+     * @param align_to_principal_axes  Rotate the vertices to the principal
+     *                                 axes of inertia (3D only)
+     */
+    RigidBodyGeometry(
+        const Eigen::MatrixXd& vertices,
+        const Eigen::MatrixXi& edges,
+        const Eigen::MatrixXi& faces,
+        bool align_to_principal_axes = true);
+
+    /// @brief Should the geometry of a body with these fixed DoF be aligned
+    /// to its principal axes?
+    /// @note Bodies with two fixed rotational DoF keep the input frame.
+    static bool
+    align_to_principal_axes(int dim, const VectorMax6b& is_dof_fixed);
+
+    int dim() const { return vertices.cols(); }
+    long num_vertices() const { return vertices.rows(); }
+    long num_edges() const { return edges.rows(); }
+    long num_faces() const { return faces.rows(); }
+    long num_codim_vertices() const
+    {
+        return mesh_selector.num_codim_vertices();
+    }
+    long num_codim_edges() const { return mesh_selector.num_codim_edges(); }
+
+    /// @brief Rebuild the BVH from the current vertices.
+    void init_bvh();
+
+    /// @brief Write the geometry (without its BVH) to a binary buffer.
+    void write(CheckpointBuffer& buffer) const;
+    /// @brief Read a geometry written with write() and rebuild its BVH.
+    /// @return The geometry or nullptr if the buffer is invalid.
+    static std::shared_ptr<RigidBodyGeometry> read(CheckpointBuffer& buffer);
+
+    // --------------------------------------------------------------------
+    // Geometry
+    // --------------------------------------------------------------------
+    Eigen::MatrixXd vertices; ///< Vertices positions in body space
+    Eigen::MatrixXi edges;    ///< Vertices connectivity
+    Eigen::MatrixXi faces;    ///< Vertices connectivity
+
+    /// @brief Local space BVH of the codimensional vertices, codimensional
+    /// edges, and faces
+    BVH::BVH bvh;
+    MeshSelector mesh_selector;
+
+    double average_edge_length; ///< Average edge length
+    /// @brief maximum distance from CM to a vertex
+    double r_max;
+
+    // --------------------------------------------------------------------
+    // Mass properties (unit density)
+    // --------------------------------------------------------------------
+    /// @brief Center of mass in the input frame
+    VectorMax3d center_of_mass;
+    /// @brief Volume (area in 2D) of the body
+    double volume;
+    /// @brief Inertia tensor about the center of mass in the input frame
+    MatrixMax3d inertia;
+    /// @brief Moment of inertia about the principal axes
+    VectorMax3d moment_of_inertia;
+    /// @brief Rotation from the principal axes to the input orientation
+    MatrixMax3d R0;
+    /// @brief Are the vertices expressed in the principal axes?
+    bool is_aligned_to_principal_axes;
+
+protected:
+    RigidBodyGeometry() = default;
+};
+
+} // namespace ipc::rigid
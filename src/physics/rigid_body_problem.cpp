@@ -106,31 +106,48 @@ void RigidBodyProblem::init(const std::vector<RigidBody>& rbs)
 
 nlohmann::json RigidBodyProblem::state() const
 {
-    nlohmann::json json;
-    std::vector<nlohmann::json> rbs;
-    Eigen::VectorXd p =
-        Eigen::VectorXd::Zero(PoseD::dim_to_pos_ndof(dim())); // Linear momentum
-    Eigen::VectorXd L = Eigen::VectorXd::Zero(
-        PoseD::dim_to_rot_ndof(dim())); // Angular momentum
-    double T = 0.0;                     // Kinetic energy
-    double G = 0.0;                     // Potential energy
-
-    for (auto& rb : m_assembler.m_rbs) {
-        nlohmann::json jrb;
-        jrb["position"] = to_json(Eigen::VectorXd(rb.pose.position));
-        jrb["rotation"] = to_json(Eigen::VectorXd(rb.pose.rotation));
-        jrb["linear_velocity"] = to_json(Eigen::VectorXd(rb.velocity.position));
-        jrb["angular_velocity"] =
-            to_json(Eigen::VectorXd(rb.velocity.rotation));
+    StateSnapshot snapshot;
+    state_snapshot(snapshot);
+    return snapshot.to_json();
+}
+
+void RigidBodyProblem::state(const nlohmann::json& args)
+{
+    StateSnapshot snapshot;
+    snapshot.from_json(args, dim());
+    state(snapshot);
+}
+
+void RigidBodyProblem::state_snapshot(StateSnapshot& snapshot) const
+{
+    snapshot.resize(dim(), num_bodies());
+    snapshot.has_diagnostics = true;
+    // Linear momentum
+    snapshot.linear_momentum.setZero(PoseD::dim_to_pos_ndof(dim()));
+    // Angular momentum
+    snapshot.angular_momentum.setZero(PoseD::dim_to_rot_ndof(dim()));
+    snapshot.kinetic_energy = snapshot.potential_energy = 0.0;
+    double& T = snapshot.kinetic_energy;   // Kinetic energy
+    double& G = snapshot.potential_energy; // Potential energy
+    snapshot.min_distance = -1;
+
+    for (size_t i = 0; i < num_bodies(); i++) {
+        const RigidBody& rb = m_assembler[i];
+        snapshot.positions.col(i) = rb.pose.position;
+        snapshot.rotations.col(i) = rb.pose.rotation;
+        snapshot.linear_velocities.col(i) = rb.velocity.position;
+        snapshot.angular_velocities.col(i) = rb.velocity.rotation;
         if (dim() == 3) {
-            jrb["Qdot"] = to_json(rb.Qdot);
-            jrb["Qddot"] = to_json(rb.Qddot);
+            snapshot.Qdots.col(i) =
+                Eigen::Map<const Eigen::VectorXd>(rb.Qdot.data(), 9);
+            snapshot.Qddots.col(i) =
+                Eigen::Map<const Eigen::VectorXd>(rb.Qddot.data(), 9);
         }
-        rbs.push_back(jrb);
 
         // momentum
-        p += rb.mass * rb.velocity.position;
-        L += rb.moment_of_inertia.asDiagonal() * rb.velocity.rotation;
+        snapshot.linear_momentum += rb.mass * rb.velocity.position;
+        snapshot.angular_momentum +=
+            rb.moment_of_inertia.asDiagonal() * rb.velocity.rotation;
 
         T += 0.5 * rb.mass * rb.velocity.position.squaredNorm();
         T += 0.5 * rb.velocity.rotation.transpose()
@@ -140,44 +157,83 @@ nlohmann::json RigidBodyProblem::state() const
             G -= rb.mass * gravity.dot(rb.pose.position);
         }
     }
-
-    json["rigid_bodies"] = rbs;
-    json["linear_momentum"] = to_json(p);
-    json["angular_momentum"] = to_json(L);
-    json["kinetic_energy"] = T;
-    json["potential_energy"] = G;
-    return json;
 }
 
-void RigidBodyProblem::state(const nlohmann::json& args)
+void RigidBodyProblem::state(const StateSnapshot& snapshot)
 {
-    nlohmann::json json;
-    auto& rbs = args["rigid_bodies"];
-    assert(rbs.size() == num_bodies());
-    size_t i = 0;
-    for (auto& jrb : args["rigid_bodies"]) {
-        from_json(jrb["position"], m_assembler[i].pose.position);
-        from_json(jrb["rotation"], m_assembler[i].pose.rotation);
-        from_json(jrb["linear_velocity"], m_assembler[i].velocity.position);
-        from_json(jrb["angular_velocity"], m_assembler[i].velocity.rotation);
+    assert(snapshot.num_bodies() == num_bodies());
+    assert(snapshot.dim() == dim());
+    for (size_t i = 0; i < num_bodies(); i++) {
+        RigidBody& rb = m_assembler[i];
+        rb.pose.position = snapshot.positions.col(i);
+        rb.pose.rotation = snapshot.rotations.col(i);
+        rb.velocity.position = snapshot.linear_velocities.col(i);
+        rb.velocity.rotation = snapshot.angular_velocities.col(i);
         if (dim() == 3) {
-            if (jrb.contains("Qdot")) {
-                from_json(jrb["Qdot"], m_assembler[i].Qdot);
-            } else {
-                spdlog::warn("Missing field \"Qdot\" in rigid body state!");
-                m_assembler[i].Qdot.setZero();
-            }
-            if (jrb.contains("Qddot")) {
-                from_json(jrb["Qddot"], m_assembler[i].Qddot);
-            } else {
-                spdlog::warn("Missing field \"Qddot\" in rigid body state!");
-                m_assembler[i].Qddot.setZero();
-            }
+            rb.Qdot = Eigen::Map<const Eigen::Matrix3d>(
+                snapshot.Qdots.col(i).data());
+            rb.Qddot = Eigen::Map<const Eigen::Matrix3d>(
+                snapshot.Qddots.col(i).data());
         }
-        i++;
     }
 }
 
+void RigidBodyProblem::save_checkpoint(CheckpointBuffer& checkpoint) const
+{
+    for (const RigidBody& rb : m_assembler.m_rbs) {
+        // Kinematic bodies may have been converted to static
+        checkpoint.write_value<int32_t>(rb.type);
+        checkpoint.write_pose(rb.pose);
+        checkpoint.write_pose(rb.pose_prev);
+        checkpoint.write_pose(rb.velocity);
+        checkpoint.write_pose(rb.velocity_prev);
+        checkpoint.write_pose(rb.acceleration);
+        checkpoint.write_matrix(rb.Qdot);
+        checkpoint.write_matrix(rb.Qddot);
+        checkpoint.write_value<double>(rb.kinematic_max_time);
+        checkpoint.write_value<uint64_t>(rb.kinematic_poses.size());
+        for (const PoseD& pose : rb.kinematic_poses) {
+            checkpoint.write_pose(pose);
+        }
+    }
+}
+
+bool RigidBodyProblem::load_checkpoint(CheckpointBuffer& checkpoint)
+{
+    for (size_t i = 0; i < num_bodies(); i++) {
+        RigidBody& rb = m_assembler[i];
+        RigidBodyType type = RigidBodyType(checkpoint.read_value<int32_t>());
+        if (type == RigidBodyType::STATIC
+            && rb.type == RigidBodyType::KINEMATIC) {
+            rb.convert_to_static();
+        } else if (type != rb.type) {
+            spdlog::error("Checkpoint does not match the rigid body types!");
+            return false;
+        }
+        checkpoint.read_pose(rb.pose);
+        checkpoint.read_pose(rb.pose_prev);
+        checkpoint.read_pose(rb.velocity);
+        checkpoint.read_pose(rb.velocity_prev);
+        checkpoint.read_pose(rb.acceleration);
+        checkpoint.read_matrix(rb.Qdot);
+        checkpoint.read_matrix(rb.Qddot);
+        rb.kinematic_max_time = checkpoint.read_value<double>();
+        uint64_t num_kinematic_poses = checkpoint.read_value<uint64_t>();
+        if (!checkpoint.good()
+            || num_kinematic_poses > checkpoint.data().size()) {
+            return false;
+        }
+        rb.kinematic_poses.resize(num_kinematic_poses);
+        for (PoseD& pose : rb.kinematic_poses) {
+            checkpoint.read_pose(pose);
+        }
+        if (!checkpoint.good()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void RigidBodyProblem::update_dof()
 {
     poses_t0 = m_assembler.rb_poses_t0();
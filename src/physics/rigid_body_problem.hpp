@@ -31,6 +31,11 @@ public:
 
     virtual nlohmann::json state() const override;
     void state(const nlohmann::json& s) override;
+    virtual void state_snapshot(StateSnapshot& snapshot) const override;
+    void state(const StateSnapshot& snapshot) override;
+
+    virtual void save_checkpoint(CheckpointBuffer& checkpoint) const override;
+    virtual bool load_checkpoint(CheckpointBuffer& checkpoint) override;
 
     virtual double timestep() const override { return m_timestep; }
     virtual void timestep(double timestep) override { m_timestep = timestep; }
@@ -72,18 +77,18 @@ public:
 
     const Eigen::MatrixXi& edges(size_t i) const override
     {
-        return m_assembler[i].edges;
+        return m_assembler[i].edges();
     }
 
     virtual const std::vector<size_t>&
     codim_edges_to_edges(size_t i) const override
     {
-        return m_assembler[i].mesh_selector.codim_edges_to_edges();
+        return m_assembler[i].mesh_selector().codim_edges_to_edges();
     }
 
     const Eigen::MatrixXi& faces(size_t i) const override
     {
-        return m_assembler[i].faces;
+        return m_assembler[i].faces();
     }
 
     Eigen::MatrixXd velocities() const override
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <limits>
+
 #include <nlohmann/json.hpp>
 
+#include <io/checkpoint.hpp>
 #include <opt/collision_constraint.hpp>
 #include <opt/optimization_problem.hpp>
 #include <opt/optimization_results.hpp>
+#include <physics/state_snapshot.hpp>
 
 #include <solvers/optimization_solver.hpp>
 
@@ -36,9 +40,20 @@ public:
     virtual nlohmann::json state() const = 0;
     /// Set the state of the simulation
     virtual void state(const nlohmann::json& s) = 0;
+    /// Get the state of the simulation without converting it to JSON
+    virtual void state_snapshot(StateSnapshot& snapshot) const = 0;
+    /// Set the state of the simulation from a snapshot
+    virtual void state(const StateSnapshot& snapshot) = 0;
+
+    /// Write the state needed to restart the simulation
+    virtual void save_checkpoint(CheckpointBuffer& checkpoint) const = 0;
+    /// Restore the state written by save_checkpoint()
+    virtual bool load_checkpoint(CheckpointBuffer& checkpoint) = 0;
 
     virtual double timestep() const = 0;        ///< Get the timestep size
     virtual void timestep(double timestep) = 0; ///< Set the timestep size
+    /// Can the timestep size change between steps?
+    virtual bool supports_adaptive_timestep() const { return false; }
 
     /// @brief Takes a step in the simulation
     /// @param[out] had_collisions True if the step had collisions.
@@ -78,6 +93,14 @@ public:
 
     /// Compute the minimum distance among geometry
     virtual double compute_min_distance() const = 0;
+    /// Minimum distance among geometry at the end of the last step
+    virtual double step_min_distance() const { return compute_min_distance(); }
+
+    /// Earliest time of impact found by CCD during the last step
+    virtual double step_earliest_toi() const
+    {
+        return std::numeric_limits<double>::infinity();
+    }
 
     OptimizationResults opt_result;
 };
@@ -0,0 +1,100 @@
+#include "state_snapshot.hpp"
+
+#include <io/serialize_json.hpp>
+#include <logger.hpp>
+#include <physics/pose.hpp>
+
+namespace ipc::rigid {
+
+void StateSnapshot::resize(int dim, size_t num_bodies)
+{
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim);
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim);
+    const int n = int(num_bodies);
+    positions.resize(pos_ndof, n);
+    rotations.resize(rot_ndof, n);
+    linear_velocities.resize(pos_ndof, n);
+    angular_velocities.resize(rot_ndof, n);
+    Qdots.resize(dim == 3 ? 9 : 0, n);
+    Qddots.resize(dim == 3 ? 9 : 0, n);
+}
+
+nlohmann::json StateSnapshot::to_json() const
+{
+    using ipc::rigid::to_json;
+    typedef Eigen::Map<const Eigen::Matrix3d> MapMatrix3d;
+
+    std::vector<nlohmann::json> jrbs(num_bodies());
+    for (size_t i = 0; i < jrbs.size(); i++) {
+        nlohmann::json& jrb = jrbs[i];
+        jrb["position"] = to_json(positions.col(i));
+        jrb["rotation"] = to_json(rotations.col(i));
+        jrb["linear_velocity"] = to_json(linear_velocities.col(i));
+        jrb["angular_velocity"] = to_json(angular_velocities.col(i));
+        if (dim() == 3) {
+            jrb["Qdot"] = to_json(MapMatrix3d(Qdots.col(i).data()));
+            jrb["Qddot"] = to_json(MapMatrix3d(Qddots.col(i).data()));
+        }
+    }
+
+    nlohmann::json json;
+    json["rigid_bodies"] = jrbs;
+    if (has_diagnostics) {
+        json["linear_momentum"] = to_json(linear_momentum);
+        json["angular_momentum"] = to_json(angular_momentum);
+        json["kinetic_energy"] = kinetic_energy;
+        json["potential_energy"] = potential_energy;
+    }
+    return json;
+}
+
+void StateSnapshot::from_json(const nlohmann::json& json, int dim)
+{
+    using ipc::rigid::from_json;
+
+    const nlohmann::json& jrbs = json["rigid_bodies"];
+    resize(dim, jrbs.size());
+    VectorMax3d values;
+    Eigen::Matrix3d Q;
+    for (size_t i = 0; i < jrbs.size(); i++) {
+        const nlohmann::json& jrb = jrbs[i];
+        from_json(jrb["position"], values);
+        positions.col(i) = values;
+        from_json(jrb["rotation"], values);
+        rotations.col(i) = values;
+        from_json(jrb["linear_velocity"], values);
+        linear_velocities.col(i) = values;
+        from_json(jrb["angular_velocity"], values);
+        angular_velocities.col(i) = values;
+        if (dim == 3) {
+            if (jrb.contains("Qdot")) {
+                from_json(jrb["Qdot"], Q);
+                Qdots.col(i) = Eigen::Map<const Eigen::VectorXd>(Q.data(), 9);
+            } else {
+                spdlog::warn("Missing field \"Qdot\" in rigid body state!");
+                Qdots.col(i).setZero();
+            }
+            if (jrb.contains("Qddot")) {
+                from_json(jrb["Qddot"], Q);
+                Qddots.col(i) = Eigen::Map<const Eigen::VectorXd>(Q.data(), 9);
+            } else {
+                spdlog::warn("Missing field \"Qddot\" in rigid body state!");
+                Qddots.col(i).setZero();
+            }
+        }
+    }
+
+    has_diagnostics = json.contains("kinetic_energy");
+    if (has_diagnostics) {
+        from_json(json["linear_momentum"], linear_momentum);
+        from_json(json["angular_momentum"], angular_momentum);
+        kinetic_energy = json["kinetic_energy"].get<double>();
+        potential_energy = json["potential_energy"].get<double>();
+    }
+    min_distance = json.contains("min_distance")
+            && json["min_distance"].is_number()
+        ? json["min_distance"].get<double>()
+        : -1;
+}
+
+} // namespace ipc::rigid
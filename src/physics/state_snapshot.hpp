@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <nlohmann/json.hpp>
+
+#include <utils/eigen_ext.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Columnar snapshot of the state of the bodies of a simulation.
+ *
+ * Each quantity is stored as a matrix with one contiguous column per body,
+ * so taking a snapshot into an existing instance does not allocate. The
+ * JSON format of the state is only produced on demand with to_json().
+ */
+struct StateSnapshot {
+    /// @brief Resize the columns for a number of bodies (keeps the memory
+    /// if the sizes do not change).
+    void resize(int dim, size_t num_bodies);
+
+    int dim() const { return int(positions.rows()) == 2 ? 2 : 3; }
+    size_t num_bodies() const { return size_t(positions.cols()); }
+
+    /// @brief Convert to the JSON format of SimulationProblem::state().
+    nlohmann::json to_json() const;
+    /// @brief Read the JSON format of SimulationProblem::state().
+    void from_json(const nlohmann::json& json, int dim);
+
+    // ------------------------------------------------------------------------
+    // Per body (one column per body)
+    // ------------------------------------------------------------------------
+    Eigen::MatrixXd positions;          ///< Positions of the centers of mass
+    Eigen::MatrixXd rotations;          ///< Rotation vectors
+    Eigen::MatrixXd linear_velocities;  ///< Linear velocities
+    Eigen::MatrixXd angular_velocities; ///< Angular velocities
+    Eigen::MatrixXd Qdots;  ///< Col-major 3×3 rotation derivatives (3D only)
+    Eigen::MatrixXd Qddots; ///< Col-major 3×3 second derivatives (3D only)
+
+    // ------------------------------------------------------------------------
+    // Diagnostics
+    // ------------------------------------------------------------------------
+    /// @brief Are the momentum and energies below computed?
+    bool has_diagnostics = false;
+    VectorMax3d linear_momentum;
+    VectorMax3d angular_momentum;
+    double kinetic_energy = 0;
+    double potential_energy = 0;
+    /// @brief Minimum distance between bodies (negative if unknown)
+    double min_distance = -1;
+};
+
+} // namespace ipc::rigid
@@ -1,5 +1,6 @@
 #include "distance_barrier_rb_problem.hpp"
 
+#include <Eigen/Cholesky>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
@@ -26,8 +27,11 @@ DistanceBarrierRBProblem::DistanceBarrierRBProblem()
     : m_barrier_stiffness(1)
     , min_distance(-1)
     , m_had_collisions(false)
+    , m_step_earliest_toi(std::numeric_limits<double>::infinity())
     , static_friction_speed_bound(1e-3)
     , friction_iterations(1)
+    , warm_start_method(NO_WARM_START)
+    , body_hessian_regularization(TIKHONOV_BODY_HESSIAN)
     , body_energy_integration_method(DEFAULT_BODY_ENERGY_INTEGRATION_METHOD)
 {
 }
@@ -53,6 +57,12 @@ bool DistanceBarrierRBProblem::settings(const nlohmann::json& params)
     body_energy_integration_method =
         params["rigid_body_problem"]["time_stepper"]
             .get<BodyEnergyIntegrationMethod>();
+    warm_start_method = params["rigid_body_problem"]["warm_start"]
+                            .get<WarmStartMethod>();
+    body_hessian_regularization =
+        params["rigid_body_problem"]["body_hessian_regularization"]
+            .get<BodyHessianRegularization>();
+    prev_step_velocity.resize(0);
     bool success = RigidBodyProblem::settings(params["rigid_body_problem"]);
     if (!success) {
         return false;
@@ -85,6 +95,8 @@ nlohmann::json DistanceBarrierRBProblem::settings() const
     json["friction_iterations"] = friction_iterations;
     json["static_friction_speed_bound"] = static_friction_speed_bound;
     json["time_stepper"] = body_energy_integration_method;
+    json["warm_start"] = warm_start_method;
+    json["body_hessian_regularization"] = body_hessian_regularization;
     return json;
 }
 
@@ -99,6 +111,41 @@ nlohmann::json DistanceBarrierRBProblem::state() const
     return json;
 }
 
+void DistanceBarrierRBProblem::state_snapshot(StateSnapshot& snapshot) const
+{
+    RigidBodyProblem::state_snapshot(snapshot);
+    snapshot.min_distance = min_distance;
+}
+
+void DistanceBarrierRBProblem::save_checkpoint(
+    CheckpointBuffer& checkpoint) const
+{
+    RigidBodyProblem::save_checkpoint(checkpoint);
+    checkpoint.write_value<double>(m_barrier_stiffness);
+    checkpoint.write_value<double>(min_distance);
+    checkpoint.write_value<double>(linear_augmented_lagrangian_penalty);
+    checkpoint.write_value<double>(angular_augmented_lagrangian_penalty);
+    checkpoint.write_matrix(linear_augmented_lagrangian_multiplier);
+    checkpoint.write_matrix(angular_augmented_lagrangian_multiplier);
+    // Used to warm start the next step
+    checkpoint.write_matrix(prev_step_velocity);
+}
+
+bool DistanceBarrierRBProblem::load_checkpoint(CheckpointBuffer& checkpoint)
+{
+    if (!RigidBodyProblem::load_checkpoint(checkpoint)) {
+        return false;
+    }
+    m_barrier_stiffness = checkpoint.read_value<double>();
+    min_distance = checkpoint.read_value<double>();
+    linear_augmented_lagrangian_penalty = checkpoint.read_value<double>();
+    angular_augmented_lagrangian_penalty = checkpoint.read_value<double>();
+    checkpoint.read_matrix(linear_augmented_lagrangian_multiplier);
+    checkpoint.read_matrix(angular_augmented_lagrangian_multiplier);
+    checkpoint.read_matrix(prev_step_velocity);
+    return checkpoint.good();
+}
+
 Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
 {
     const VectorXb& is_dof_fixed = this->is_dof_fixed();
@@ -112,6 +159,15 @@ Eigen::VectorXi DistanceBarrierRBProblem::free_dof() const
     return Eigen::Map<Eigen::VectorXi>(free_dofs.data(), free_dofs.size());
 }
 
+void DistanceBarrierRBProblem::set_num_concurrent_evaluations(
+    int num_evaluations)
+{
+    // Keep the constraint sets of the current iterate and of every
+    // concurrently evaluated one
+    m_constraint.set_constraint_cache_capacity(
+        std::max(size_t(num_evaluations) + 1, size_t(4)));
+}
+
 ////////////////////////////////////////////////////////////
 // Rigid Body Problem
 
@@ -130,6 +186,7 @@ void DistanceBarrierRBProblem::simulation_step(
     // Reset m_had_collision which will be filled in by has_collisions().
     m_had_collisions = false;
     m_num_contacts = 0;
+    m_step_earliest_toi = std::numeric_limits<double>::infinity();
 
     // Disable barriers if solve_collision == false
     this->m_use_barriers = solve_collisions;
@@ -142,6 +199,16 @@ void DistanceBarrierRBProblem::simulation_step(
     had_collisions = m_had_collisions;
 }
 
+bool DistanceBarrierRBProblem::supports_adaptive_timestep() const
+{
+    for (size_t i = 0; i < num_bodies(); i++) {
+        if (m_assembler[i].kinematic_poses.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void DistanceBarrierRBProblem::update_constraints()
 {
     PROFILE_POINT("DistanceBarrierRBProblem::update_constraints");
@@ -149,9 +216,9 @@ void DistanceBarrierRBProblem::update_constraints()
 
     RigidBodyProblem::update_constraints();
 
-    Constraints collision_constraints;
-    m_constraint.construct_constraint_set(
-        m_assembler, poses_t0, collision_constraints);
+    std::shared_ptr<const Constraints> collision_constraints_ptr =
+        m_constraint.construct_constraint_set(m_assembler, poses_t0);
+    const Constraints& collision_constraints = *collision_constraints_ptr;
 
     Eigen::SparseMatrix<double> hess;
     compute_barrier_term(
@@ -434,7 +501,7 @@ bool DistanceBarrierRBProblem::are_equality_constraints_satisfied(
 OptimizationResults DistanceBarrierRBProblem::solve_constraints()
 {
     OptimizationResults opt_result;
-    opt_result.x = starting_point();
+    opt_result.x = warm_start_point();
     double momentum_balance, eps_d = 1e-2 * world_bbox_diagonal();
     int i = 0;
     int total_newton_iterations = 0;
@@ -447,9 +514,9 @@ OptimizationResults DistanceBarrierRBProblem::solve_constraints()
 
         PosesD poses = this->dofs_to_poses(opt_result.x);
 
-        Constraints collision_constraints;
-        m_constraint.construct_constraint_set(
-            m_assembler, poses, collision_constraints);
+        std::shared_ptr<const Constraints> collision_constraints_ptr =
+            m_constraint.construct_constraint_set(m_assembler, poses);
+        const Constraints& collision_constraints = *collision_constraints_ptr;
         update_friction_constraints(collision_constraints, poses);
 
         Eigen::VectorXd grad_Ex, grad_Bx, grad_Dx;
@@ -481,10 +548,66 @@ OptimizationResults DistanceBarrierRBProblem::solve_constraints()
             "Ending friction solve early because newton solve {:d} failed!", i);
     }
 
+    if (opt_result.success) {
+        prev_step_velocity = (opt_result.x - starting_point()) / timestep();
+    } else {
+        prev_step_velocity.resize(0);
+    }
+
     opt_result.num_iterations = total_newton_iterations;
     return opt_result;
 }
 
+Eigen::VectorXd DistanceBarrierRBProblem::warm_start_point()
+{
+    const Eigen::VectorXd& x_start = starting_point();
+    if (warm_start_method == NO_WARM_START) {
+        return x_start;
+    }
+
+    Eigen::VectorXd x_guess = x_start;
+    for (int i = 0; i < num_bodies(); i++) {
+        if (m_assembler[i].type == RigidBodyType::KINEMATIC) {
+            x_guess.segment(ndof * i, ndof) = x_pred.segment(ndof * i, ndof);
+        } else if (prev_step_velocity.size() == x_start.size()) {
+            // The adaptive time-step can change the length of the step
+            x_guess.segment(ndof * i, ndof) +=
+                timestep() * prev_step_velocity.segment(ndof * i, ndof);
+        }
+    }
+    x_guess = is_dof_fixed().select(x_start, x_guess);
+
+    if (!m_use_barriers) {
+        return x_guess;
+    }
+
+    // Back off along the path from the start of the step until the initial
+    // guess is intersection free. These are not collisions (or impacts) of
+    // the step, so they must not count toward its difficulty.
+    const bool had_collisions = m_had_collisions;
+    const double step_earliest_toi = m_step_earliest_toi;
+    double alpha = std::min(0.8 * compute_earliest_toi(x_start, x_guess), 1.0);
+    Eigen::VectorXd x_warm = x_start + alpha * (x_guess - x_start);
+    bool is_colliding = alpha > 0 && has_collisions(x_start, x_warm);
+    for (int i = 0; i < 10 && is_colliding; i++) {
+        alpha /= 2;
+        x_warm = x_start + alpha * (x_guess - x_start);
+        is_colliding = has_collisions(x_start, x_warm);
+    }
+    if (is_colliding) {
+        alpha = 0;
+        x_warm = x_start;
+    }
+    m_had_collisions = had_collisions;
+    m_step_earliest_toi = step_earliest_toi;
+
+    spdlog::debug(
+        "problem={} warm_start={} alpha={:g}", name(),
+        nlohmann::json(warm_start_method).get<std::string>(), alpha);
+
+    return x_warm;
+}
+
 bool DistanceBarrierRBProblem::take_step(const Eigen::VectorXd& x)
 {
     min_distance = compute_min_distance(x);
@@ -667,9 +790,10 @@ double DistanceBarrierRBProblem::compute_objective(
 
     // Compute a common constraint set to use for contacts and friction
     // Start by updating the constraint set
-    Constraints constraints;
-    m_constraint.construct_constraint_set(
-        m_assembler, this->dofs_to_poses(x), constraints);
+    std::shared_ptr<const Constraints> constraints_ptr =
+        m_constraint.construct_constraint_set(
+            m_assembler, this->dofs_to_poses(x));
+    const Constraints& constraints = *constraints_ptr;
 
     spdlog::debug(
         "problem={} num_vertex_vertex_constraint={:d} "
@@ -702,6 +826,65 @@ double DistanceBarrierRBProblem::compute_objective(
     return Ex + kappa_over_avg_mass * Bx + Dx / average_mass();
 }
 
+// Compute the objective function with the hessian stored as body blocks:
+// f(x) = E(x) + κ ∑_{k ∈ C} b(d(x_k)) + ∑_{k ∈ C} D(x_k)
+double DistanceBarrierRBProblem::compute_objective_blocks(
+    const Eigen::VectorXd& x, Eigen::VectorXd& grad, BodyBlockHessian& hess)
+{
+    PROFILE_POINT("DistanceBarrierRBProblem::compute_objective_blocks");
+    PROFILE_START();
+
+    hess.resize(num_bodies(), PoseD::dim_to_ndof(dim()));
+
+    // The body energy and augmented Lagrangian are block diagonal
+    Eigen::SparseMatrix<double> hess_Ex;
+    double Ex = compute_energy_term(x, grad, hess_Ex);
+    hess.add_block_diagonal(hess_Ex, 1 / average_mass());
+
+    Eigen::VectorXd grad_AL;
+    Eigen::SparseMatrix<double> hess_AL;
+    Ex += compute_augmented_lagrangian(
+        x, grad_AL, hess_AL, /*compute_grad=*/true, /*compute_hess=*/true);
+    grad += grad_AL;
+    hess.add_block_diagonal(hess_AL, 1 / average_mass());
+
+    Ex /= average_mass();
+    grad /= average_mass();
+
+    if (!m_use_barriers) {
+        PROFILE_END();
+        return Ex;
+    }
+
+    std::shared_ptr<const Constraints> constraints_ptr =
+        m_constraint.construct_constraint_set(
+            m_assembler, this->dofs_to_poses(x));
+
+    // The contact potentials couple pairs of bodies
+    Eigen::VectorXd grad_Bx;
+    Eigen::SparseMatrix<double> hess_Bx;
+    std::vector<BodyPairHessianBlock> hess_blocks_Bx;
+    double Bx = compute_barrier_term(
+        x, *constraints_ptr, grad_Bx, hess_Bx, &hess_blocks_Bx,
+        /*compute_grad=*/true, /*compute_hess=*/true);
+
+    Eigen::VectorXd grad_Dx;
+    Eigen::SparseMatrix<double> hess_Dx;
+    std::vector<BodyPairHessianBlock> hess_blocks_Dx;
+    double Dx = compute_friction_term(
+        x, grad_Dx, hess_Dx, &hess_blocks_Dx,
+        /*compute_grad=*/true, /*compute_hess=*/true);
+
+    double kappa_over_avg_mass = barrier_stiffness() / average_mass();
+    grad += kappa_over_avg_mass * grad_Bx + grad_Dx / average_mass();
+    hess.add_pair_blocks(hess_blocks_Bx, kappa_over_avg_mass);
+    hess.add_pair_blocks(hess_blocks_Dx, 1 / average_mass());
+
+    PROFILE_END();
+
+    return Ex + kappa_over_avg_mass * Bx + Dx / average_mass();
+}
+
 // Compute E(x) in f(x) = E(x) + κ ∑_{k ∈ C} b(d(x_k))
 double DistanceBarrierRBProblem::compute_energy_term(
     const Eigen::VectorXd& x,
@@ -713,11 +896,7 @@ double DistanceBarrierRBProblem::compute_energy_term(
     PROFILE_POINT("DistanceBarrierRBProblem::compute_energy_term");
     PROFILE_START();
 
-    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/6> Diff;
-
     int ndof = PoseD::dim_to_ndof(dim());
-    int pos_ndof = PoseD::dim_to_pos_ndof(dim());
-    int rot_ndof = PoseD::dim_to_rot_ndof(dim());
 
     Eigen::VectorXd energies = Eigen::VectorXd::Zero(num_bodies());
     if (compute_grad) {
@@ -732,73 +911,14 @@ double DistanceBarrierRBProblem::compute_energy_term(
     const std::vector<PoseD> poses = this->dofs_to_poses(x);
     assert(poses.size() == num_bodies());
 
-    // tbb::parallel_for(size_t(0), poses.size(), [&](size_t i) {
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(size_t(0), poses.size()),
-        [&](const tbb::blocked_range<size_t>& range) {
-            // Activate autodiff with the correct number of variables
-            Diff::activate(ndof);
-
-            for (long i = range.begin(); i != range.end(); ++i) {
-                const PoseD& pose = poses[i];
-                const RigidBody& body = m_assembler[i];
-
-                // Do not compute the body energy for static and kinematic
-                // bodies
-                if (body.type != RigidBodyType::DYNAMIC) {
-                    continue;
-                }
-
-                VectorMax6d gradi;
-
-                if (compute_hess) {
-                    // Initialize autodiff variables
-                    Pose<Diff::DDouble2> pose_diff(Diff::d2vars(0, pose.dof()));
-
-                    Diff::DDouble2 dExi = compute_body_energy<Diff::DDouble2>(
-                        body, pose_diff,
-                        grad_barrier_t0.segment(i * ndof, ndof));
-
-                    energies[i] = dExi.getValue();
-                    gradi = dExi.getGradient();
-                    MatrixMax6d hessi = dExi.getHessian();
-
-                    // Project dense block to make assembled matrix PSD
-                    hessi.topLeftCorner(pos_ndof, pos_ndof) = project_to_psd(
-                        MatrixMax3d(hessi.topLeftCorner(pos_ndof, pos_ndof)));
-                    // NOTE: This is handled with Tikhonov regularization
-                    // instead hessi.bottomRightCorner(rot_ndof, rot_ndof) =
-                    //     Eigen::project_to_pd(
-                    //         hessi.bottomRightCorner(rot_ndof, rot_ndof));
-
-                    // Add the local hessian as triplets in the global
-                    // hessian
-                    for (int r = 0; r < hessi.rows(); r++) {
-                        for (int c = 0; c < hessi.cols(); c++) {
-                            hess_triplets.emplace_back(
-                                i * ndof + r, i * ndof + c, hessi(r, c));
-                        }
-                    }
-                } else if (compute_grad) {
-                    // Initialize autodiff variables
-                    Pose<Diff::DDouble1> pose_diff(Diff::d1vars(0, pose.dof()));
-
-                    Diff::DDouble1 dExi = compute_body_energy<Diff::DDouble1>(
-                        body, pose_diff,
-                        grad_barrier_t0.segment(i * ndof, ndof));
-
-                    energies[i] = dExi.getValue();
-                    gradi = dExi.getGradient();
-                } else {
-                    energies[i] = compute_body_energy<double>(
-                        body, pose, grad_barrier_t0.segment(i * ndof, ndof));
-                }
-
-                if (compute_grad) {
-                    grad.segment(i * ndof, ndof) = gradi;
-                }
-            }
-        });
+    // Dispatch on the dimension once so the body derivatives are fixed size
+    if (dim() == 2) {
+        compute_body_energies<2>(
+            poses, energies, grad, hess_triplets, compute_grad, compute_hess);
+    } else {
+        compute_body_energies<3>(
+            poses, energies, grad, hess_triplets, compute_grad, compute_hess);
+    }
 
     if (compute_hess) {
         NAMED_PROFILE_POINT(
@@ -843,7 +963,302 @@ double DistanceBarrierRBProblem::compute_energy_term(
     return energies.sum();
 }
 
-// Compute the energy term for a single rigid body
+template <int dim>
+void DistanceBarrierRBProblem::compute_body_energies(
+    const PosesD& poses,
+    Eigen::VectorXd& energies,
+    Eigen::VectorXd& grad,
+    tbb::concurrent_vector<Eigen::Triplet<double>>& hess_triplets,
+    bool compute_grad,
+    bool compute_hess)
+{
+    constexpr int pos_ndof = dim;
+    constexpr int ndof = dim == 2 ? 3 : 6;
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), poses.size()),
+        [&](const tbb::blocked_range<size_t>& range) {
+            for (long i = range.begin(); i != range.end(); ++i) {
+                const RigidBody& body = m_assembler[i];
+
+                // Do not compute the body energy for static and kinematic
+                // bodies
+                if (body.type != RigidBodyType::DYNAMIC) {
+                    continue;
+                }
+
+                Eigen::Matrix<double, ndof, 1> gradi;
+                Eigen::Matrix<double, ndof, ndof> hessi;
+                energies[i] = compute_body_energy<dim>(
+                    body, poses[i], gradi, hessi, compute_grad, compute_hess);
+
+#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
+                check_body_energy_derivatives(
+                    i, poses[i], gradi, hessi, compute_grad, compute_hess);
+#endif
+
+                if (compute_hess) {
+                    // Project dense block to make assembled matrix PSD
+                    if (body_hessian_regularization == BLOCK_PSD_BODY_HESSIAN) {
+                        // Only decompose blocks that are not already PD
+                        if (hessi.llt().info() != Eigen::Success) {
+                            hessi = project_to_psd(hessi);
+                        }
+                    } else {
+                        // NOTE: The rotational block is handled with Tikhonov
+                        // regularization instead.
+                        typedef Eigen::Matrix<double, pos_ndof, pos_ndof>
+                            MatrixP;
+                        auto pos_hessi =
+                            hessi.template topLeftCorner<pos_ndof, pos_ndof>();
+                        pos_hessi = project_to_psd(MatrixP(pos_hessi));
+                    }
+
+                    // Add the local hessian as triplets in the global
+                    // hessian
+                    for (int r = 0; r < ndof; r++) {
+                        for (int c = 0; c < ndof; c++) {
+                            hess_triplets.emplace_back(
+                                i * ndof + r, i * ndof + c, hessi(r, c));
+                        }
+                    }
+                }
+
+                if (compute_grad) {
+                    grad.template segment<ndof>(i * ndof) = gradi;
+                }
+            }
+        });
+}
+
+/// @brief Compute f(θ) = tr(R(θ)B) and its derivatives, where R(θ) is the
+/// rotation matrix of the rotation vector θ.
+///
+/// With t = |θ|, R = cos(t)I + a[θ]ₓ + bθθᵀ where a = sin(t)/t and
+/// b = (1-cos(t))/t², so f = cos(t)tr(B) + aθᵀβ + bθᵀSθ where S = sym(B) and
+/// β is the axial vector of B - Bᵀ.
+inline double rotation_trace(
+    const Eigen::Vector3d& theta,
+    const Eigen::Matrix3d& B,
+    Eigen::Vector3d& grad,
+    Eigen::Matrix3d& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    const double t2 = theta.squaredNorm(), t = sqrt(t2);
+    const double cos_t = cos(t);
+
+    // a, b and the derivatives A1 = a'/t, B1 = b'/t, A2 = A1'/t, B2 = B1'/t
+    double a, b, A1, B1, A2, B2;
+    if (t < 0.1) {
+        // Taylor series to avoid cancellation near zero
+        const double t4 = t2 * t2, t6 = t4 * t2;
+        a = 1 - t2 / 6 + t4 / 120 - t6 / 5040;
+        b = 0.5 - t2 / 24 + t4 / 720 - t6 / 40320;
+        A1 = -1.0 / 3 + t2 / 30 - t4 / 840 + t6 / 45360;
+        B1 = -1.0 / 12 + t2 / 180 - t4 / 6720 + t6 / 453600;
+        A2 = 1.0 / 15 - t2 / 210 + t4 / 7560 - t6 / 498960;
+        B2 = 1.0 / 90 - t2 / 1680 + t4 / 75600 - t6 / 5987520;
+    } else {
+        const double sin_t = sin(t), t3 = t2 * t, t4 = t2 * t2;
+        a = sin_t / t;
+        b = (1 - cos_t) / t2;
+        A1 = (t * cos_t - sin_t) / t3;
+        B1 = (t * sin_t - 2 + 2 * cos_t) / t4;
+        A2 = (3 * sin_t - 3 * t * cos_t - t2 * sin_t) / (t4 * t);
+        B2 = (t2 * cos_t - 5 * t * sin_t - 8 * cos_t + 8) / (t4 * t2);
+    }
+
+    const double trB = B.trace();
+    const Eigen::Matrix3d S = 0.5 * (B + B.transpose());
+    const Eigen::Vector3d beta(
+        B(1, 2) - B(2, 1), B(2, 0) - B(0, 2), B(0, 1) - B(1, 0));
+    const double theta_beta = theta.dot(beta);
+    const Eigen::Vector3d S_theta = S * theta;
+    const double theta_S_theta = theta.dot(S_theta);
+
+    if (compute_grad) {
+        grad = (B1 * theta_S_theta + A1 * theta_beta - a * trB) * theta
+            + a * beta + 2 * b * S_theta;
+    }
+
+    if (compute_hess) {
+        const Eigen::Matrix3d theta_thetaT = theta * theta.transpose();
+        hess = (A2 * theta_beta + B2 * theta_S_theta - A1 * trB) * theta_thetaT
+            + A1 * (beta * theta.transpose() + theta * beta.transpose())
+            + 2 * B1
+                * (S_theta * theta.transpose() + theta * S_theta.transpose())
+            + 2 * b * S;
+        hess.diagonal().array() +=
+            A1 * theta_beta + B1 * theta_S_theta - a * trB;
+    }
+
+    return cos_t * trB + a * theta_beta + b * theta_S_theta;
+}
+
+// Compute the energy term for a single rigid body and its derivatives
+template <int dim>
+double DistanceBarrierRBProblem::compute_body_energy(
+    const RigidBody& body,
+    const PoseD& pose,
+    Eigen::Matrix<double, dim == 2 ? 3 : 6, 1>& grad,
+    Eigen::Matrix<double, dim == 2 ? 3 : 6, dim == 2 ? 3 : 6>& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    constexpr int pos_ndof = dim;
+    constexpr int rot_ndof = dim == 2 ? 1 : 3;
+
+    // NOTE: t0 suffix indicates the current value not the inital value
+    double h = timestep();
+
+    double energy = 0;
+    grad.setZero();
+    hess.setZero();
+
+    // Linear energy
+    if (!body.is_dof_fixed.head(pos_ndof).all()) {
+        const Eigen::Matrix<double, pos_ndof, 1> q = pose.position;
+        const VectorMax3d& q_t0 = body.pose.position;
+        const VectorMax3d& qdot_t0 = body.velocity.position;
+        VectorMax3d qddot_t0 = gravity + body.force.position / body.mass;
+        switch (body_energy_integration_method) {
+        case IMPLICIT_EULER:
+            break;
+        case IMPLICIT_NEWMARK:
+        case STABILIZED_NEWMARK:
+            qddot_t0 += body.acceleration.position;
+            qddot_t0 *= 0.25;
+            break;
+        }
+        const Eigen::Matrix<double, pos_ndof, 1> q_hat =
+            q_t0 + h * (qdot_t0 + h * qddot_t0);
+
+        // ½mqᵀq - mqᵀq̂
+        energy += 0.5 * body.mass * q.dot(q) - body.mass * q.dot(q_hat);
+        if (compute_grad) {
+            grad.template head<pos_ndof>() = body.mass * (q - q_hat);
+        }
+        if (compute_hess) {
+            hess.template topLeftCorner<pos_ndof, pos_ndof>().diagonal()
+                .setConstant(body.mass);
+        }
+    }
+
+    // Rotational energy
+    if (body.is_dof_fixed.tail(rot_ndof).all()) {
+        return energy;
+    }
+
+    if constexpr (dim == 3) {
+        Eigen::Matrix3d Q_t0 = body.pose.construct_rotation_matrix();
+        Eigen::Matrix3d Qdot_t0 = body.Qdot;
+
+        DiagonalMatrix3d J = compute_J(body.moment_of_inertia);
+
+        Eigen::Matrix3d Qddot_t0;
+        double torque_scale = h * h; // scale of the h²tr(Q[τ]) term
+        switch (body_energy_integration_method) {
+        case IMPLICIT_EULER:
+            Qddot_t0.setZero();
+            torque_scale = h * h;
+            break;
+        case IMPLICIT_NEWMARK:
+        case STABILIZED_NEWMARK:
+            Qddot_t0 = 0.25 * body.Qddot;
+            torque_scale = 0.25 * h * h;
+            break;
+        }
+
+        // Transform the world space torque into body space
+        Eigen::Matrix3d Tau = Q_t0.transpose() * Hat(body.force.rotation);
+
+        // ½tr(QJQᵀ) - tr(Q(J(Qᵗ + hQ̇ᵗ + h²Aᵗ)ᵀ - h²[τ])) = ½tr(J) - tr(QB)
+        Eigen::Matrix3d B =
+            J * (Q_t0 + h * (Qdot_t0 + h * Qddot_t0)).transpose()
+            - torque_scale * Tau;
+
+        Eigen::Vector3d grad_rot;
+        Eigen::Matrix3d hess_rot;
+        energy += 0.5 * J.diagonal().sum()
+            - rotation_trace(
+                      pose.rotation, B, grad_rot, hess_rot, compute_grad,
+                      compute_hess);
+        if (compute_grad) {
+            grad.template tail<3>() = -grad_rot;
+        }
+        if (compute_hess) {
+            hess.template bottomRightCorner<3, 3>() = -hess_rot;
+        }
+    } else {
+        double theta = pose.rotation[0];
+        double theta_t0 = body.pose.rotation[0];
+        double theta_dot_t0 = body.velocity.rotation[0];
+        // θ̈ = α + τ/I
+        double I = body.moment_of_inertia[0];
+        double theta_ddot_t0 = body.force.rotation[0] / I;
+        switch (body_energy_integration_method) {
+        case IMPLICIT_EULER:
+            break;
+        case IMPLICIT_NEWMARK:
+        case STABILIZED_NEWMARK:
+            theta_ddot_t0 += body.acceleration.rotation[0];
+            theta_ddot_t0 *= 0.25;
+            break;
+        }
+
+        // ½Iθ² - Iθ(θᵗ + h(θ̇ᵗ + hθ̈ᵗ))
+        double theta_hat = theta_t0 + h * (theta_dot_t0 + h * theta_ddot_t0);
+        energy += 0.5 * I * theta * theta - I * theta * theta_hat;
+        if (compute_grad) {
+            grad(pos_ndof) = I * (theta - theta_hat);
+        }
+        if (compute_hess) {
+            hess(pos_ndof, pos_ndof) = I;
+        }
+    }
+
+    return energy;
+}
+
+#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
+void DistanceBarrierRBProblem::check_body_energy_derivatives(
+    long i,
+    const PoseD& pose,
+    const VectorMax6d& grad,
+    const MatrixMax6d& hess,
+    bool compute_grad,
+    bool compute_hess)
+{
+    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/6> Diff;
+
+    if (!compute_grad && !compute_hess) {
+        return;
+    }
+
+    // Reference derivatives using autodiff
+    int ndof = pose.ndof();
+    Diff::activate(ndof);
+    Pose<Diff::DDouble2> pose_diff(Diff::d2vars(0, pose.dof()));
+    Diff::DDouble2 dExi = compute_body_energy<Diff::DDouble2>(
+        m_assembler[i], pose_diff, grad_barrier_t0.segment(i * ndof, ndof));
+
+    if (compute_grad
+        && !fd::compare_gradient(
+            Eigen::VectorXd(grad), Eigen::VectorXd(dExi.getGradient()))) {
+        spdlog::error(
+            "body_id={:d} autodiff gradient check failed for E(x)", i);
+    }
+    if (compute_hess
+        && !fd::compare_jacobian(
+            Eigen::MatrixXd(hess), Eigen::MatrixXd(dExi.getHessian()))) {
+        spdlog::error(
+            "body_id={:d} autodiff hessian check failed for E(x)", i);
+    }
+}
+#endif
+
+// Compute the energy term for a single rigid body (with autodiff types)
 template <typename T>
 T DistanceBarrierRBProblem::compute_body_energy(
     const RigidBody& body,
@@ -943,6 +1358,27 @@ T DistanceBarrierRBProblem::compute_body_energy(
     return energy;
 }
 
+// The tests compare the analytic derivatives with autodiff
+template double DistanceBarrierRBProblem::compute_body_energy<2>(
+    const RigidBody&,
+    const PoseD&,
+    Eigen::Matrix<double, 3, 1>&,
+    Eigen::Matrix<double, 3, 3>&,
+    bool,
+    bool);
+template double DistanceBarrierRBProblem::compute_body_energy<3>(
+    const RigidBody&,
+    const PoseD&,
+    Eigen::Matrix<double, 6, 1>&,
+    Eigen::Matrix<double, 6, 6>&,
+    bool,
+    bool);
+template AutodiffType<Eigen::Dynamic, /*maxN=*/6>::DDouble2
+DistanceBarrierRBProblem::compute_body_energy(
+    const RigidBody&,
+    const Pose<AutodiffType<Eigen::Dynamic, /*maxN=*/6>::DDouble2>&,
+    const VectorMax6d&);
+
 double DistanceBarrierRBProblem::compute_augmented_lagrangian(
     const Eigen::VectorXd& x,
     Eigen::VectorXd& grad,
@@ -1065,6 +1501,10 @@ double DistanceBarrierRBProblem::compute_augmented_lagrangian(
             }
             if (compute_hess) {
                 Eigen::Matrix3d H = dAL.getHessian();
+                if (body_hessian_regularization == BLOCK_PSD_BODY_HESSIAN
+                    && H.llt().info() != Eigen::Success) {
+                    H = project_to_psd(H);
+                }
                 for (int hi = 0; hi < H.rows(); hi++) {
                     for (int hj = 0; hj < H.cols(); hj++) {
                         hess_triplets.emplace_back(
@@ -1098,7 +1538,9 @@ double DistanceBarrierRBProblem::compute_augmented_lagrangian(
         if (compute_grad) {
             check_augmented_lagrangian_gradient(x, grad);
         }
-        if (compute_hess) {
+        // The projected Hessian does not match finite differences
+        if (compute_hess
+            && body_hessian_regularization != BLOCK_PSD_BODY_HESSIAN) {
             check_augmented_lagrangian_hessian(x, hess);
         }
         is_checking_derivative = false;
@@ -1119,8 +1561,9 @@ double DistanceBarrierRBProblem::compute_barrier_term(
 {
     // Start by updating the constraint set
     PosesD poses = this->dofs_to_poses(x);
-    Constraints constraints;
-    m_constraint.construct_constraint_set(m_assembler, poses, constraints);
+    std::shared_ptr<const Constraints> constraints_ptr =
+        m_constraint.construct_constraint_set(m_assembler, poses);
+    const Constraints& constraints = *constraints_ptr;
     num_constraints = constraints.num_constraints();
 
     m_num_contacts = std::max(m_num_contacts, num_constraints);
@@ -1178,73 +1621,75 @@ void local_hessian_to_global_triplets(
     }
 }
 
-// Apply the chain rule of f(V(x)) given ∇ᵥf(V) and ∇ₓV(x)
-void apply_chain_rule(
+// Apply the chain rule of f(V(x)) given ∇ᵥf(V) and ∇ₓV(x) to get the
+// gradient and hessian with respect to the DOFs of the two bodies involved.
+// The dimension is a template parameter, so all vertex and body blocks are
+// fixed size.
+template <int dim>
+void local_chain_rule(
     const VectorMax12d& grad_f,
     const Eigen::MatrixXd& jac_V,
     const MatrixMax12d& hess_f,
     const Eigen::MatrixXd& hess_V,
     const std::vector<long>& vertex_ids,
     const std::vector<uint8_t>& local_body_ids,
-    const std::array<long, 2>& body_ids,
-    const int dim,
-    Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    VectorMax12d& local_grad,
+    MatrixMax12d& local_hess,
     bool compute_grad,
     bool compute_hess)
 {
-    if (!compute_grad && !compute_hess) {
-        return;
-    }
+    constexpr int rb_ndof = dim == 2 ? 3 : 6;
+    typedef Eigen::Matrix<double, dim, rb_ndof> VertexJacobian;
 
-    // PROFILE_POINT("apply_chain_rule");
-    // PROFILE_START();
-
-    const int rb_ndof = PoseD::dim_to_ndof(dim);
+    // ∇ₓVᵢ ∈ R^{dim × m} of each vertex of the constraint
+    assert(vertex_ids.size() <= 4);
+    std::array<VertexJacobian, 4> jac_Vi;
+    for (int i = 0; i < vertex_ids.size(); i++) {
+        jac_Vi[i] = jac_V.middleRows<dim>(vertex_ids[i] * dim);
+    }
 
     if (compute_grad) {
-        // jac_Vi ∈ R^{4n × 2m}
-        VectorMax12d local_grad = VectorMax12d::Zero(2 * rb_ndof);
+        Eigen::Matrix<double, 2 * rb_ndof, 1> grad;
+        grad.setZero();
         for (int i = 0; i < vertex_ids.size(); i++) {
-            local_grad.segment(rb_ndof * local_body_ids[i], rb_ndof) +=
-                jac_V.middleRows(vertex_ids[i] * dim, dim).transpose()
-                * grad_f.segment(i * dim, dim);
+            grad.template segment<rb_ndof>(rb_ndof * local_body_ids[i]) +=
+                jac_Vi[i].transpose() * grad_f.segment<dim>(i * dim);
         }
-
-        local_gradient_to_global(local_grad, body_ids, rb_ndof, grad);
+        local_grad = grad;
     }
 
     if (compute_hess) {
-        // jac_Vi ∈ R^{4n × 2m}
-        MatrixMax12d jac_Vi =
-            MatrixMax12d::Zero(vertex_ids.size() * dim, 2 * rb_ndof);
+        // hess ∈ R^{2m × 2m}
+        Eigen::Matrix<double, 2 * rb_ndof, 2 * rb_ndof> hess;
+        hess.setZero();
         for (int i = 0; i < vertex_ids.size(); i++) {
-            jac_Vi.block(i * dim, local_body_ids[i] * rb_ndof, dim, rb_ndof) =
-                jac_V.middleRows(vertex_ids[i] * dim, dim);
+            for (int j = 0; j < vertex_ids.size(); j++) {
+                hess.template block<rb_ndof, rb_ndof>(
+                    rb_ndof * local_body_ids[i], rb_ndof * local_body_ids[j]) +=
+                    jac_Vi[i].transpose()
+                    * hess_f.block<dim, dim>(i * dim, j * dim) * jac_Vi[j];
+            }
         }
-
-        // hess ∈ R^{2m × 2m}
-        MatrixMax12d hess = jac_Vi.transpose() * hess_f * jac_Vi;
         for (int i = 0; i < vertex_ids.size(); i++) {
             for (int j = 0; j < dim; j++) {
                 // Off diagaonal blocks are all zero because the derivative
                 // of a vertex of body A with body B is zero.
-                hess.block(
-                    local_body_ids[i] * rb_ndof, local_body_ids[i] * rb_ndof,
-                    rb_ndof, rb_ndof) +=
-                    hess_V.middleRows(
-                        rb_ndof * (vertex_ids[i] * dim + j), rb_ndof)
+                hess.template block<rb_ndof, rb_ndof>(
+                    local_body_ids[i] * rb_ndof, local_body_ids[i] * rb_ndof) +=
+                    hess_V.middleRows<rb_ndof>(
+                        rb_ndof * (vertex_ids[i] * dim + j))
                     * grad_f[i * dim + j];
             }
         }
 
-        hess = project_to_psd(hess);
-
-        local_hessian_to_global_triplets(
-            hess, body_ids, rb_ndof, hess_triplets);
+        local_hess = project_to_psd(hess);
     }
+}
 
-    // PROFILE_END();
+LocalChainRule select_local_chain_rule(int dim)
+{
+    assert(dim == 2 || dim == 3);
+    return dim == 2 ? &local_chain_rule<2> : &local_chain_rule<3>;
 }
 
 struct PotentialStorage {
@@ -1253,6 +1698,29 @@ struct PotentialStorage {
     double potential = 0;
     Eigen::VectorXd gradient;
     std::vector<Eigen::Triplet<double>> hessian_triplets;
+    std::vector<BodyPairHessianBlock> hessian_blocks;
+
+    // Add the local derivatives of a potential on a pair of bodies. The local
+    // hessian is stored as a block if store_blocks is true.
+    void add_local_derivatives(
+        const std::array<long, 2>& body_ids,
+        const VectorMax12d& local_grad,
+        const MatrixMax12d& local_hess,
+        int ndof,
+        bool compute_grad,
+        bool compute_hess,
+        bool store_blocks)
+    {
+        if (compute_grad) {
+            local_gradient_to_global(local_grad, body_ids, ndof, gradient);
+        }
+        if (compute_hess && store_blocks) {
+            hessian_blocks.emplace_back(body_ids, local_hess);
+        } else if (compute_hess) {
+            local_hessian_to_global_triplets(
+                local_hess, body_ids, ndof, hessian_triplets);
+        }
+    }
 };
 typedef tbb::enumerable_thread_specific<PotentialStorage>
     ThreadSpecificPotentials;
@@ -1262,6 +1730,7 @@ double merge_derivative_storage(
     size_t nvars,
     Eigen::VectorXd& grad,
     Eigen::SparseMatrix<double>& hess,
+    std::vector<BodyPairHessianBlock>* hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1283,7 +1752,11 @@ double merge_derivative_storage(
             grad += p.gradient;
         }
 
-        if (compute_hess) {
+        if (compute_hess && hess_blocks != nullptr) {
+            hess_blocks->insert(
+                hess_blocks->end(), p.hessian_blocks.begin(),
+                p.hessian_blocks.end());
+        } else if (compute_hess) {
             Eigen::SparseMatrix<double> p_hess(nvars, nvars);
             p_hess.setFromTriplets(
                 p.hessian_triplets.begin(), p.hessian_triplets.end());
@@ -1301,6 +1774,7 @@ double DistanceBarrierRBProblem::compute_barrier_term(
     const Constraints& constraints,
     Eigen::VectorXd& grad,
     Eigen::SparseMatrix<double>& hess,
+    std::vector<BodyPairHessianBlock>* hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1325,6 +1799,7 @@ double DistanceBarrierRBProblem::compute_barrier_term(
     PROFILE_START();
 
     int rb_ndof = PoseD::dim_to_ndof(dim());
+    const LocalChainRule chain_rule = select_local_chain_rule(dim());
 
     // Compute V(x)
     Eigen::MatrixXd jac_V, hess_V;
@@ -1340,8 +1815,20 @@ double DistanceBarrierRBProblem::compute_barrier_term(
             // Get references to the local derivative storage
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
-            auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
+
+            // Consecutive constraints on the same pair of bodies (see
+            // DistanceBarrierConstraint::sort_constraints) are accumulated
+            // into one local block before being added to the global storage.
+            std::array<long, 2> block_body_ids = { { -1, -1 } };
+            VectorMax12d block_grad;
+            MatrixMax12d block_hess;
+            const auto flush_block = [&]() {
+                if (block_body_ids[0] >= 0) {
+                    local_storage.add_local_derivatives(
+                        block_body_ids, block_grad, block_hess, rb_ndof,
+                        compute_grad, compute_hess, hess_blocks != nullptr);
+                }
+            };
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 const auto& constraint = constraints[ci];
@@ -1368,17 +1855,40 @@ double DistanceBarrierRBProblem::compute_barrier_term(
                     // PROFILE_END(COMPUTE_BARRIER_HESS);
                 }
 
-                apply_chain_rule(
+                if (!compute_grad && !compute_hess) {
+                    continue;
+                }
+
+                const std::array<long, 2> constraint_body_ids =
+                    body_ids(m_assembler, constraints, ci);
+                if (constraint_body_ids != block_body_ids) {
+                    flush_block();
+                    block_body_ids = constraint_body_ids;
+                    block_grad.setZero(2 * rb_ndof);
+                    block_hess.setZero(2 * rb_ndof, 2 * rb_ndof);
+                }
+
+                VectorMax12d grad_Bx;
+                MatrixMax12d hess_Bx;
+                chain_rule(
                     grad_B, jac_V, hess_B, hess_V,
                     constraint.vertex_indices(edges(), faces()),
-                    vertex_local_body_ids(constraints, ci),
-                    body_ids(m_assembler, constraints, ci), dim(), local_grad,
-                    hess_triplets, compute_grad, compute_hess);
+                    vertex_local_body_ids(constraints, ci), grad_Bx, hess_Bx,
+                    compute_grad, compute_hess);
+                if (compute_grad) {
+                    block_grad += grad_Bx;
+                }
+                if (compute_hess) {
+                    block_hess += hess_Bx;
+                }
             }
+
+            flush_block();
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), grad, hess, hess_blocks, compute_grad,
+        compute_hess);
 
     PROFILE_END();
 
@@ -1388,7 +1898,7 @@ double DistanceBarrierRBProblem::compute_barrier_term(
         if (compute_grad) {
             check_barrier_gradient(x, constraints, grad);
         }
-        if (compute_hess) {
+        if (compute_hess && hess_blocks == nullptr) {
             check_barrier_hessian(x, constraints, hess);
         }
         is_checking_derivative = false;
@@ -1412,9 +1922,11 @@ double DistanceBarrierRBProblem::compute_friction_potential(
     const Eigen::MatrixXd& U,
     const Eigen::MatrixXd& jac_V,
     const Eigen::MatrixXd& hess_V,
+    const LocalChainRule chain_rule,
     const FrictionConstraint& constraint,
-    Eigen::VectorXd& grad,
-    std::vector<Eigen::Triplet<double>>& hess_triplets,
+    VectorMax12d& local_grad,
+    MatrixMax12d& local_hess,
+    std::array<long, 2>& body_ids,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1431,8 +1943,6 @@ double DistanceBarrierRBProblem::compute_friction_potential(
     //     local_to_global(∇ₓD(V(x)))
     //     local_to_global(project_to_psd(∇ₓ²D(V(x))))
 
-    int rb_ndof = PoseD::dim_to_ndof(dim());
-
     double epsv_times_h = static_friction_speed_bound * timestep();
 
     // PROFILE_START(COMPUTE_FRICTION_VAL);
@@ -1457,11 +1967,12 @@ double DistanceBarrierRBProblem::compute_friction_potential(
     }
 
     RigidBodyConstraint rbc(m_assembler, constraint);
-    apply_chain_rule(
+    body_ids = rbc.body_ids();
+    chain_rule(
         grad_D, jac_V, hess_D, hess_V,
         constraint.vertex_indices(edges(), faces()),
-        rbc.vertex_local_body_ids(), rbc.body_ids(), dim(), //
-        grad, hess_triplets, compute_grad, compute_hess);
+        rbc.vertex_local_body_ids(), local_grad, local_hess, compute_grad,
+        compute_hess);
 
     return Dx;
 }
@@ -1470,6 +1981,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
     const Eigen::VectorXd& x,
     Eigen::VectorXd& grad,
     Eigen::SparseMatrix<double>& hess,
+    std::vector<BodyPairHessianBlock>* hess_blocks,
     bool compute_grad,
     bool compute_hess)
 {
@@ -1483,6 +1995,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
     PROFILE_START();
 
     int rb_ndof = PoseD::dim_to_ndof(dim());
+    const LocalChainRule chain_rule = select_local_chain_rule(dim());
 
     // Compute V(x)
     Eigen::MatrixXd jac_V, hess_V;
@@ -1504,54 +2017,59 @@ double DistanceBarrierRBProblem::compute_friction_term(
             // Get references to the local derivative storage
             auto& local_storage = thread_storage.local();
             auto& potential = local_storage.potential;
-            auto& local_grad = local_storage.gradient;
-            auto& hess_triplets = local_storage.hessian_triplets;
 
             for (size_t ci = range.begin(); ci != range.end(); ++ci) {
                 size_t local_ci = ci;
 
+                std::array<long, 2> body_ids;
+                VectorMax12d local_grad;
+                MatrixMax12d local_hess;
                 if (local_ci < friction_constraints.vv_constraints.size()) {
                     potential += compute_friction_potential<
                         RigidBodyVertexVertexConstraint>(
-                        U, jac_V, hess_V,
+                        U, jac_V, hess_V, chain_rule,
                         friction_constraints.vv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
-                    continue;
-                }
-
-                local_ci -= friction_constraints.vv_constraints.size();
-                if (local_ci < friction_constraints.ev_constraints.size()) {
+                        local_grad, local_hess, body_ids, compute_grad,
+                        compute_hess);
+                } else if (
+                    (local_ci -= friction_constraints.vv_constraints.size())
+                    < friction_constraints.ev_constraints.size()) {
                     potential += compute_friction_potential<
                         RigidBodyEdgeVertexConstraint>(
-                        U, jac_V, hess_V,
+                        U, jac_V, hess_V, chain_rule,
                         friction_constraints.ev_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
-                    continue;
-                }
-
-                local_ci -= friction_constraints.ev_constraints.size();
-                if (local_ci < friction_constraints.ee_constraints.size()) {
+                        local_grad, local_hess, body_ids, compute_grad,
+                        compute_hess);
+                } else if (
+                    (local_ci -= friction_constraints.ev_constraints.size())
+                    < friction_constraints.ee_constraints.size()) {
                     potential +=
                         compute_friction_potential<RigidBodyEdgeEdgeConstraint>(
-                            U, jac_V, hess_V,
+                            U, jac_V, hess_V, chain_rule,
                             friction_constraints.ee_constraints[local_ci],
-                            local_grad, hess_triplets, compute_grad,
+                            local_grad, local_hess, body_ids, compute_grad,
                             compute_hess);
-                    continue;
+                } else {
+                    local_ci -= friction_constraints.ee_constraints.size();
+                    assert(
+                        local_ci < friction_constraints.fv_constraints.size());
+                    potential += compute_friction_potential<
+                        RigidBodyFaceVertexConstraint>(
+                        U, jac_V, hess_V, chain_rule,
+                        friction_constraints.fv_constraints[local_ci],
+                        local_grad, local_hess, body_ids, compute_grad,
+                        compute_hess);
                 }
 
-                local_ci -= friction_constraints.ee_constraints.size();
-                assert(local_ci < friction_constraints.fv_constraints.size());
-                potential +=
-                    compute_friction_potential<RigidBodyFaceVertexConstraint>(
-                        U, jac_V, hess_V,
-                        friction_constraints.fv_constraints[local_ci],
-                        local_grad, hess_triplets, compute_grad, compute_hess);
+                local_storage.add_local_derivatives(
+                    body_ids, local_grad, local_hess, rb_ndof, compute_grad,
+                    compute_hess, hess_blocks != nullptr);
             }
         });
 
     double potential = merge_derivative_storage(
-        thread_storage, x.size(), grad, hess, compute_grad, compute_hess);
+        thread_storage, x.size(), grad, hess, hess_blocks, compute_grad,
+        compute_hess);
 
     PROFILE_END();
 
@@ -1561,7 +2079,7 @@ double DistanceBarrierRBProblem::compute_friction_term(
         if (compute_grad) {
             check_friction_gradient(x, grad);
         }
-        if (compute_hess) {
+        if (compute_hess && hess_blocks == nullptr) {
             check_friction_hessian(x, hess);
         }
         is_checking_derivative = false;
@@ -1589,6 +2107,42 @@ DistanceBarrierRBProblem::compute_min_distance(const Eigen::VectorXd& x) const
     return std::isfinite(min_distance) ? min_distance : -1;
 }
 
+size_t DistanceBarrierRBProblem::active_set_hash(const Eigen::VectorXd& x) const
+{
+    if (!m_use_barriers) {
+        return 0;
+    }
+
+    std::shared_ptr<const Constraints> constraints_ptr =
+        m_constraint.construct_constraint_set(
+            m_assembler, this->dofs_to_poses(x));
+    const Constraints& constraints = *constraints_ptr;
+
+    size_t seed = 0;
+    const auto hash_combine = [&seed](long value) {
+        seed ^=
+            std::hash<long>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    hash_combine(constraints.size());
+    for (const auto& c : constraints.vv_constraints) {
+        hash_combine(c.vertex0_index);
+        hash_combine(c.vertex1_index);
+    }
+    for (const auto& c : constraints.ev_constraints) {
+        hash_combine(c.edge_index);
+        hash_combine(c.vertex_index);
+    }
+    for (const auto& c : constraints.ee_constraints) {
+        hash_combine(c.edge0_index);
+        hash_combine(c.edge1_index);
+    }
+    for (const auto& c : constraints.fv_constraints) {
+        hash_combine(c.face_index);
+        hash_combine(c.vertex_index);
+    }
+    return seed;
+}
+
 bool DistanceBarrierRBProblem::has_collisions(
     const Eigen::VectorXd& x_i, const Eigen::VectorXd& x_j)
 {
@@ -1596,7 +2150,9 @@ bool DistanceBarrierRBProblem::has_collisions(
     PosesD poses_j = this->dofs_to_poses(x_j);
     bool collisions =
         m_constraint.has_active_collisions(m_assembler, poses_i, poses_j);
-    m_had_collisions |= collisions;
+    if (collisions) {
+        m_had_collisions = true;
+    }
     // m_use_barriers := solve_collisions
     return m_use_barriers ? collisions : false;
 }
@@ -1616,7 +2172,10 @@ double DistanceBarrierRBProblem::compute_earliest_toi(
     PosesD poses_j = this->dofs_to_poses(x_j);
     double earliest_toi =
         m_constraint.compute_earliest_toi(m_assembler, poses_i, poses_j);
-    m_had_collisions |= earliest_toi <= 1;
+    if (earliest_toi <= 1) {
+        m_had_collisions = true;
+    }
+    m_step_earliest_toi = std::min(m_step_earliest_toi, earliest_toi);
     return earliest_toi;
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include <tbb/concurrent_vector.h>
 
 #include <ipc/collision_constraint.hpp>
@@ -32,6 +34,50 @@ NLOHMANN_JSON_SERIALIZE_ENUM(
       { STABILIZED_NEWMARK, "stabilized_newmark" },
       { DEFAULT_BODY_ENERGY_INTEGRATION_METHOD, "default" } });
 
+/// @brief Possible initial guesses for the Newton solve of a time-step.
+enum WarmStartMethod {
+    /// Start from the poses at the start of the time-step
+    NO_WARM_START,
+    /// Repeat the velocity of the previous time-step, with kinematic bodies
+    /// at their targets
+    PREVIOUS_DELTA_WARM_START
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    WarmStartMethod,
+    { { NO_WARM_START, "none" },
+      { PREVIOUS_DELTA_WARM_START, "previous_delta" } });
+
+/// @brief How indefinite rotational blocks of the body Hessians are handled.
+enum BodyHessianRegularization {
+    /// Leave them to the Tikhonov regularization of the Newton solver
+    TIKHONOV_BODY_HESSIAN,
+    /// Project each body's (ndof × ndof) block to PSD before assembly
+    BLOCK_PSD_BODY_HESSIAN
+};
+
+NLOHMANN_JSON_SERIALIZE_ENUM(
+    BodyHessianRegularization,
+    { { TIKHONOV_BODY_HESSIAN, "tikhonov" },
+      { BLOCK_PSD_BODY_HESSIAN, "block_psd" } });
+
+/// @brief Chain rule from the derivatives of a potential with respect to the
+/// vertices of a constraint to the DoF of the (two) bodies involved.
+typedef void (*LocalChainRule)(
+    const VectorMax12d& grad_f,
+    const Eigen::MatrixXd& jac_V,
+    const MatrixMax12d& hess_f,
+    const Eigen::MatrixXd& hess_V,
+    const std::vector<long>& vertex_ids,
+    const std::vector<uint8_t>& local_body_ids,
+    VectorMax12d& local_grad,
+    MatrixMax12d& local_hess,
+    bool compute_grad,
+    bool compute_hess);
+
+/// @brief Get the chain rule specialized for the dimension of the scene.
+LocalChainRule select_local_chain_rule(int dim);
+
 /// This class is both a simulation and optimization problem.
 class DistanceBarrierRBProblem : public RigidBodyProblem,
                                  public virtual BarrierProblem {
@@ -43,6 +89,10 @@ public:
     nlohmann::json settings() const override;
 
     nlohmann::json state() const override;
+    void state_snapshot(StateSnapshot& snapshot) const override;
+
+    void save_checkpoint(CheckpointBuffer& checkpoint) const override;
+    bool load_checkpoint(CheckpointBuffer& checkpoint) override;
 
     static std::string problem_name() { return "distance_barrier_rb_problem"; }
 
@@ -78,6 +128,20 @@ public:
 
     Eigen::VectorXi free_dof() const override;
 
+    /// The objective and collision checks only share the constraint set
+    /// caches (which are locked) and the collision flag (which is atomic).
+    bool is_thread_safe() const override
+    {
+#ifdef RIGID_IPC_WITH_DERIVATIVE_CHECK
+        return false; // The derivative checks are not reentrant
+#else
+        return true;
+#endif
+    }
+
+    /// Size the constraint set cache for the concurrent evaluations.
+    void set_num_concurrent_evaluations(int num_evaluations) override;
+
     /// Determine if there is a collision between two configurations
     bool has_collisions(
         const Eigen::VectorXd& x_i, const Eigen::VectorXd& x_j) override;
@@ -127,6 +191,12 @@ public:
         bool compute_grad = true,
         bool compute_hess = true) override;
 
+    /// Compute the objective function f(x) with an unassembled Hessian
+    double compute_objective_blocks(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        BodyBlockHessian& hess) override;
+
     /// Compute E(x) in f(x) = E(x) + κ ∑_{k ∈ C} b(d(x_k))
     double compute_energy_term(
         const Eigen::VectorXd& x,
@@ -149,7 +219,22 @@ public:
         Eigen::VectorXd& grad,
         Eigen::SparseMatrix<double>& hess,
         bool compute_grad = true,
-        bool compute_hess = true);
+        bool compute_hess = true)
+    {
+        return compute_friction_term(
+            x, grad, hess, /*hess_blocks=*/nullptr, compute_grad,
+            compute_hess);
+    }
+
+    /// Compute the friction term. If hess_blocks is not null, the local
+    /// hessians are stored there instead of being assembled into hess.
+    double compute_friction_term(
+        const Eigen::VectorXd& x,
+        Eigen::VectorXd& grad,
+        Eigen::SparseMatrix<double>& hess,
+        std::vector<BodyPairHessianBlock>* hess_blocks,
+        bool compute_grad,
+        bool compute_hess);
 
     virtual double compute_friction_term(const Eigen::VectorXd& x) final
     {
@@ -176,6 +261,11 @@ public:
     /// Compute the minimum distance among geometry
     double compute_min_distance() const override;
     double compute_min_distance(const Eigen::VectorXd& x) const override;
+    /// Minimum distance computed when taking the last step
+    double step_min_distance() const override { return min_distance; }
+
+    /// Hash the primitive indices of the active constraints at x
+    size_t active_set_hash(const Eigen::VectorXd& x) const override;
 
     /// Compute the value of the barrier at a distance x
     double barrier_hessian(double x) const override
@@ -207,6 +297,10 @@ public:
 
     int num_contacts() const override { return m_num_contacts; };
 
+    /// The targets of kinematic pose sequences are given per time-step.
+    bool supports_adaptive_timestep() const override;
+    double step_earliest_toi() const override { return m_step_earliest_toi; }
+
     ////////////////////////////////////////////////////////////
     // Augmented Lagrangian for equality constraints
 
@@ -245,6 +339,28 @@ protected:
     void update_friction_constraints(
         const Constraints& collision_constraints, const PosesD& poses);
 
+    /// Compute the energy of every dynamic body with analytic derivatives.
+    template <int dim>
+    void compute_body_energies(
+        const PosesD& poses,
+        Eigen::VectorXd& energies,
+        Eigen::VectorXd& grad,
+        tbb::concurrent_vector<Eigen::Triplet<double>>& hess_triplets,
+        bool compute_grad,
+        bool compute_hess);
+
+    /// Compute the energy of a single body and its (ndof × ndof) derivatives.
+    template <int dim>
+    double compute_body_energy(
+        const RigidBody& body,
+        const PoseD& pose,
+        Eigen::Matrix<double, dim == 2 ? 3 : 6, 1>& grad,
+        Eigen::Matrix<double, dim == 2 ? 3 : 6, dim == 2 ? 3 : 6>& hess,
+        bool compute_grad,
+        bool compute_hess);
+
+    /// Compute the energy of a single body with any scalar type (e.g.,
+    /// autodiff types).
     template <typename T>
     T compute_body_energy(
         const RigidBody& body,
@@ -256,9 +372,11 @@ protected:
         const Eigen::MatrixXd& U,
         const Eigen::MatrixXd& jac_V,
         const Eigen::MatrixXd& hess_V,
+        const LocalChainRule chain_rule,
         const FrictionConstraint& constraint,
-        Eigen::VectorXd& grad,
-        std::vector<Eigen::Triplet<double>>& hess_triplets,
+        VectorMax12d& local_grad,
+        MatrixMax12d& local_hess,
+        std::array<long, 2>& body_ids,
         bool compute_grad,
         bool compute_hess);
 
@@ -270,6 +388,23 @@ protected:
         Eigen::VectorXd& grad,
         Eigen::SparseMatrix<double>& hess,
         bool compute_grad,
+        bool compute_hess)
+    {
+        return compute_barrier_term(
+            x, distance_constraints, grad, hess, /*hess_blocks=*/nullptr,
+            compute_grad, compute_hess);
+    }
+
+    /// Computes the barrier term value, gradient, and hessian from
+    /// distance constraints. If hess_blocks is not null, the local hessians
+    /// are stored there instead of being assembled into hess.
+    double compute_barrier_term(
+        const Eigen::VectorXd& x,
+        const Constraints& distance_constraints,
+        Eigen::VectorXd& grad,
+        Eigen::SparseMatrix<double>& hess,
+        std::vector<BodyPairHessianBlock>* hess_blocks,
+        bool compute_grad,
         bool compute_hess);
 
     virtual double compute_barrier_term(
@@ -323,6 +458,15 @@ protected:
     void check_augmented_lagrangian_hessian(
         const Eigen::VectorXd& x, const Eigen::SparseMatrix<double>& hess);
 
+    /// Compare the analytic body energy derivatives to autodiff.
+    void check_body_energy_derivatives(
+        long i,
+        const PoseD& pose,
+        const VectorMax6d& grad,
+        const MatrixMax6d& hess,
+        bool compute_grad,
+        bool compute_hess);
+
     bool is_checking_derivative = false;
 #endif
 
@@ -341,9 +485,12 @@ protected:
     double min_distance;
 
     /// @brief Did the step have collisions?
-    bool m_had_collisions;
+    /// @note Atomic because the line search may check steps in parallel.
+    std::atomic<bool> m_had_collisions;
     /// @brief The number of collision during the timestep.
     int m_num_contacts;
+    /// @brief Earliest time of impact computed during the timestep.
+    double m_step_earliest_toi;
 
     /// @brief Gradient of barrier potential at the start of the time-step.
     Eigen::VectorXd grad_barrier_t0;
@@ -361,7 +508,18 @@ protected:
     Eigen::VectorXd x_pred; ///< Predicted DoF using unconstrained timestep
     VectorXb is_dof_satisfied;
 
-private:
+    /// @brief Compute a collision free initial guess for the Newton solve.
+    Eigen::VectorXd warm_start_point();
+
+    /// @brief Method for computing the initial guess of the Newton solve.
+    WarmStartMethod warm_start_method;
+    /// @brief Change in DoF of the previous time-step divided by its
+    /// time-step, so it can be repeated over a time-step of another length.
+    Eigen::VectorXd prev_step_velocity;
+
+    /// @brief Regularization of the body energy and AL Hessian blocks.
+    BodyHessianRegularization body_hessian_regularization;
+
     /// Method for integrating the body energy.
     BodyEnergyIntegrationMethod body_energy_integration_method;
 };
@@ -83,6 +83,7 @@ void IPCSolver::post_step_update()
             iteration_number, kappa);
         barrier_problem_ptr()->barrier_stiffness(kappa);
         num_kappa_updates++;
+        refresh_hessian = true; // The Hessian scales with κ
     }
     prev_min_distance = min_distance;
 }
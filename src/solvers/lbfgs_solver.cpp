@@ -0,0 +1,159 @@
+#include "lbfgs_solver.hpp"
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+LBFGSSolver::LBFGSSolver()
+    : IPCSolver()
+    , history_size(8)
+    , hessian_refresh_interval(10)
+{
+}
+
+void LBFGSSolver::settings(const nlohmann::json& json)
+{
+    IPCSolver::settings(json);
+    history_size = json["history_size"].get<int>();
+    hessian_refresh_interval = json["hessian_refresh_interval"].get<int>();
+    // The refresh of the exact Hessian is managed here
+    hessian_reuse = false;
+    num_quasi_newton_steps = 0;
+    num_hessian_refreshes = 0;
+}
+
+nlohmann::json LBFGSSolver::settings() const
+{
+    nlohmann::json json = IPCSolver::settings();
+    json["history_size"] = history_size;
+    json["hessian_refresh_interval"] = hessian_refresh_interval;
+    return json;
+}
+
+void LBFGSSolver::init_solve(const Eigen::VectorXd& x0)
+{
+    IPCSolver::init_solve(x0);
+    history.clear();
+}
+
+bool LBFGSSolver::compute_free_direction(double& fx)
+{
+    is_hessian_lagged = false;
+
+    if (refresh_hessian || hessian_age >= hessian_refresh_interval
+        || hessian_free.rows() != dof_reduction.num_free_dof()
+        || problem_ptr->active_set_hash(x) != hessian_active_set_hash) {
+        return compute_exact_free_direction(fx);
+    }
+
+    fx = problem_ptr->compute_objective(x, gradient);
+    num_fx++;
+    num_grad_fx++;
+
+    dof_reduction.reduce(gradient, gradient_free);
+    Eigen::VectorXd x_free;
+    dof_reduction.reduce(x, x_free);
+    update_history(x_free);
+
+    compute_quasi_newton_direction();
+    if (!direction_free.allFinite()
+        || gradient_free.dot(direction_free) >= 0) {
+        spdlog::debug(
+            "solver={} iter={:d} msg=\"L-BFGS direction is not a descent "
+            "direction; refreshing the hessian\"",
+            name(), iteration_number);
+        return compute_exact_free_direction(fx);
+    }
+
+    hessian_age++;
+    num_quasi_newton_steps++;
+    // Let the Newton solve refresh the Hessian if the line search fails
+    is_hessian_lagged = true;
+    return true;
+}
+
+bool LBFGSSolver::compute_exact_free_direction(double& fx)
+{
+    fx = problem_ptr->compute_objective(x, gradient, hessian);
+    num_fx++;
+    num_grad_fx++;
+    num_hessian_fx++;
+    num_hessian_refreshes++;
+
+    dof_reduction.reduce(gradient, gradient_free);
+    dof_reduction.reduce(hessian, hessian_free);
+
+    // The factorization of the (regularized) Hessian is the initial
+    // inverse Hessian approximation of the following iterations.
+    bool success = compute_regularized_direction(
+        fx, gradient_free, hessian_free, direction_free,
+        regularization_coeff);
+
+    history.clear();
+    dof_reduction.reduce(x, prev_x_free);
+    prev_gradient_free = gradient_free;
+
+    refresh_hessian = !success;
+    hessian_age = 0;
+    hessian_active_set_hash = problem_ptr->active_set_hash(x);
+    return success;
+}
+
+void LBFGSSolver::update_history(const Eigen::VectorXd& x_free)
+{
+    CurvaturePair pair;
+    pair.s = x_free - prev_x_free;
+    pair.y = gradient_free - prev_gradient_free;
+    prev_x_free = x_free;
+    prev_gradient_free = gradient_free;
+
+    // Skip pairs violating the curvature condition to keep H positive
+    // definite.
+    double ys = pair.y.dot(pair.s);
+    if (ys <= std::numeric_limits<double>::epsilon() * pair.y.squaredNorm()) {
+        return;
+    }
+    pair.rho = 1 / ys;
+
+    history.push_back(pair);
+    while (history.size() > size_t(std::max(history_size, 0))) {
+        history.pop_front();
+    }
+}
+
+void LBFGSSolver::compute_quasi_newton_direction()
+{
+    // Two-loop recursion with H₀⁻¹ applied by the factorized Hessian
+    Eigen::VectorXd q = -gradient_free;
+    std::vector<double> alpha(history.size());
+    for (int i = int(history.size()) - 1; i >= 0; i--) {
+        alpha[i] = history[i].rho * history[i].s.dot(q);
+        q -= alpha[i] * history[i].y;
+    }
+
+    direction_free = Eigen::VectorXd::Zero(q.size());
+    linear_solver->solve(q, direction_free);
+
+    for (size_t i = 0; i < history.size(); i++) {
+        double beta = history[i].rho * history[i].y.dot(direction_free);
+        direction_free += (alpha[i] - beta) * history[i].s;
+    }
+}
+
+std::string LBFGSSolver::stats_string() const
+{
+    return fmt::format(
+        "num_quasi_newton_steps={:d} num_hessian_refreshes={:d} {}",
+        num_quasi_newton_steps, num_hessian_refreshes,
+        IPCSolver::stats_string());
+}
+
+nlohmann::json LBFGSSolver::stats() const
+{
+    nlohmann::json stats_json = IPCSolver::stats();
+    stats_json["num_quasi_newton_steps"] = num_quasi_newton_steps;
+    stats_json["num_hessian_refreshes"] = num_hessian_refreshes;
+    return stats_json;
+}
+
+} // namespace ipc::rigid
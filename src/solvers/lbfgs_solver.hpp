@@ -0,0 +1,74 @@
+#pragma once
+
+#include <deque>
+
+#include <solvers/ipc_solver.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Limited-memory BFGS solver for barrier problems.
+ *
+ * The inverse Hessian is approximated with an L-BFGS history on top of the
+ * factorized exact Hessian, which is only recomputed every few iterations or
+ * when the active constraint set changes. Steps are taken with the same
+ * CCD-filtered line search as the Newton solver.
+ */
+class LBFGSSolver : public IPCSolver {
+public:
+    LBFGSSolver();
+    virtual ~LBFGSSolver() = default;
+
+    /// Initialize the state of the solver using the settings saved in JSON
+    virtual void settings(const nlohmann::json& params) override;
+    /// Export the state of the solver using the settings saved in JSON
+    virtual nlohmann::json settings() const override;
+
+    /// An identifier for the solver class
+    static std::string solver_name() { return "lbfgs_solver"; }
+    /// An identifier for this solver
+    virtual std::string name() const override
+    {
+        return LBFGSSolver::solver_name();
+    }
+
+    /// Initialize the solver state for a new solve
+    virtual void init_solve(const Eigen::VectorXd& x0) override;
+
+    virtual std::string stats_string() const override;
+    virtual nlohmann::json stats() const override;
+
+protected:
+    bool compute_free_direction(double& fx) override;
+
+    /// @brief Compute the direction with the exact Hessian and reset the
+    /// history.
+    bool compute_exact_free_direction(double& fx);
+
+    /// @brief Compute the direction with the two-loop recursion.
+    void compute_quasi_newton_direction();
+
+    /// @brief Add the change between consecutive iterates to the history.
+    void update_history(const Eigen::VectorXd& x_free);
+
+    /// @brief Pair of iterate and gradient changes.
+    struct CurvaturePair {
+        Eigen::VectorXd s;  ///< @brief Change in x
+        Eigen::VectorXd y;  ///< @brief Change in the gradient
+        double rho;         ///< @brief 1 / (yᵀs)
+    };
+
+    /// @brief Maximum number of curvature pairs stored.
+    int history_size;
+    /// @brief Number of iterations between exact Hessian refreshes.
+    int hessian_refresh_interval;
+
+    std::deque<CurvaturePair> history;
+    Eigen::VectorXd prev_x_free, prev_gradient_free;
+
+private:
+    size_t num_quasi_newton_steps = 0;
+    size_t num_hessian_refreshes = 0;
+};
+
+} // namespace ipc::rigid
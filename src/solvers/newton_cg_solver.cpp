@@ -0,0 +1,218 @@
+#include "newton_cg_solver.hpp"
+
+#include <Eigen/Cholesky>
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+// Eisenstat–Walker "choice 2" parameters
+static constexpr double EW_GAMMA = 0.9;
+static constexpr double EW_ALPHA = 2.0;
+static constexpr double EW_SAFEGUARD_THRESHOLD = 0.1;
+
+NewtonCGSolver::NewtonCGSolver()
+    : IPCSolver()
+    , max_cg_iterations(1000)
+    , max_forcing_term(0.5)
+    , prev_forcing_term(0.5)
+    , prev_grad_norm(-1)
+{
+}
+
+void NewtonCGSolver::settings(const nlohmann::json& json)
+{
+    IPCSolver::settings(json);
+    max_cg_iterations = json["max_cg_iterations"].get<int>();
+    max_forcing_term = json["max_forcing_term"].get<double>();
+    cg_iterations = 0;
+    num_negative_curvature = 0;
+}
+
+nlohmann::json NewtonCGSolver::settings() const
+{
+    nlohmann::json json = IPCSolver::settings();
+    json["max_cg_iterations"] = max_cg_iterations;
+    json["max_forcing_term"] = max_forcing_term;
+    return json;
+}
+
+void NewtonCGSolver::init_solve(const Eigen::VectorXd& x0)
+{
+    IPCSolver::init_solve(x0);
+    prev_forcing_term = max_forcing_term;
+    prev_grad_norm = -1;
+}
+
+double NewtonCGSolver::update_forcing_term(double grad_norm)
+{
+    double eta = max_forcing_term;
+    if (prev_grad_norm > 0) {
+        eta = EW_GAMMA * std::pow(grad_norm / prev_grad_norm, EW_ALPHA);
+        // Safeguard against the forcing term decreasing too quickly
+        double safeguard = EW_GAMMA * std::pow(prev_forcing_term, EW_ALPHA);
+        if (safeguard > EW_SAFEGUARD_THRESHOLD) {
+            eta = std::max(eta, safeguard);
+        }
+        eta = std::min(eta, max_forcing_term);
+    }
+    prev_forcing_term = eta;
+    prev_grad_norm = grad_norm;
+    return eta;
+}
+
+void NewtonCGSolver::compute_preconditioner(
+    const BodyBlockHessian& hess, const Eigen::VectorXi& free_dof)
+{
+    const int ndof = hess.ndof();
+    const std::vector<MatrixMax6d> diag_blocks = hess.diagonal_blocks();
+
+    preconditioner.clear();
+    int start = 0;
+    while (start < free_dof.size()) {
+        // Group the consecutive free DoF of a single body
+        const int body_id = free_dof(start) / ndof;
+        int end = start + 1;
+        while (end < free_dof.size() && free_dof(end) / ndof == body_id) {
+            end++;
+        }
+        const int n = end - start;
+
+        MatrixMax6d A(n, n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                A(i, j) = diag_blocks[body_id](
+                    free_dof(start + i) % ndof, free_dof(start + j) % ndof);
+            }
+        }
+
+        PreconditionerBlock block;
+        block.start = start;
+        Eigen::LDLT<MatrixMax6d> ldlt(A);
+        if (ldlt.info() == Eigen::Success && ldlt.isPositive()
+            && ldlt.vectorD().minCoeff() > 0) {
+            block.inv = ldlt.solve(MatrixMax6d::Identity(n, n));
+        } else {
+            // Fall back to Jacobi on indefinite blocks
+            block.inv = MatrixMax6d::Zero(n, n);
+            for (int i = 0; i < n; i++) {
+                double d = std::abs(A(i, i));
+                block.inv(i, i) = d > 0 ? 1 / d : 1;
+            }
+        }
+        preconditioner.push_back(block);
+
+        start = end;
+    }
+}
+
+Eigen::VectorXd
+NewtonCGSolver::apply_preconditioner(const Eigen::VectorXd& r) const
+{
+    Eigen::VectorXd z(r.size());
+    for (const PreconditionerBlock& block : preconditioner) {
+        const int n = block.inv.rows();
+        z.segment(block.start, n) = block.inv * r.segment(block.start, n);
+    }
+    return z;
+}
+
+int NewtonCGSolver::solve_free_system(
+    const BodyBlockHessian& hess,
+    const Eigen::VectorXd& b,
+    double tol,
+    Eigen::VectorXd& d)
+{
+    compute_preconditioner(hess, dof_reduction.free_dof());
+
+    // Hessian-vector product restricted to the free DoF
+    Eigen::VectorXd p_full = Eigen::VectorXd::Zero(hess.size());
+    const auto hess_free_product = [&](const Eigen::VectorXd& p) {
+        dof_reduction.expand(p, p_full);
+        Eigen::VectorXd Hp;
+        dof_reduction.reduce(hess * p_full, Hp);
+        return Hp;
+    };
+
+    // Truncated preconditioned conjugate gradient
+    d = Eigen::VectorXd::Zero(b.size());
+    Eigen::VectorXd r = b;
+    Eigen::VectorXd z = apply_preconditioner(r);
+    Eigen::VectorXd p = z;
+    double rz = r.dot(z);
+
+    int i;
+    for (i = 0; i < max_cg_iterations && r.norm() > tol; i++) {
+        Eigen::VectorXd Hp = hess_free_product(p);
+        double pHp = p.dot(Hp);
+        if (pHp <= 0) {
+            // Negative curvature: stop with the current iterate or with the
+            // preconditioned steepest descent direction if there is none.
+            num_negative_curvature++;
+            if (i == 0) {
+                d = p;
+            }
+            break;
+        }
+        double alpha = rz / pHp;
+        d += alpha * p;
+        r -= alpha * Hp;
+        z = apply_preconditioner(r);
+        double rz_next = r.dot(z);
+        p = z + (rz_next / rz) * p;
+        rz = rz_next;
+    }
+    cg_iterations += i;
+
+    spdlog::debug(
+        "solver={} iter={:d} cg_iterations={:d} forcing_term={:g} "
+        "relative_residual={:g}",
+        name(), iteration_number, i, prev_forcing_term,
+        b.norm() > 0 ? r.norm() / b.norm() : 0.0);
+
+    return i;
+}
+
+bool NewtonCGSolver::compute_free_direction(double& fx)
+{
+    BodyBlockHessian hess;
+    fx = problem_ptr->compute_objective_blocks(x, gradient, hess);
+
+    num_fx++;
+    num_grad_fx++;
+    num_hessian_fx++;
+
+    dof_reduction.reduce(gradient, gradient_free);
+
+    const double grad_norm = gradient_free.norm();
+    const double tol = update_forcing_term(grad_norm) * grad_norm;
+
+    solve_free_system(hess, -gradient_free, tol, direction_free);
+
+    if (gradient_free.dot(direction_free) >= 0 && grad_norm > 0) {
+        spdlog::warn(
+            "solver={} iter={:d} failure=\"CG direction is not a descent "
+            "direction\" failsafe=\"gradient descent\"",
+            name(), iteration_number);
+        direction_free = -gradient_free;
+    }
+
+    return true;
+}
+
+std::string NewtonCGSolver::stats_string() const
+{
+    return fmt::format(
+        "total_cg_iterations={:d} num_negative_curvature={:d} {}",
+        cg_iterations, num_negative_curvature, IPCSolver::stats_string());
+}
+
+nlohmann::json NewtonCGSolver::stats() const
+{
+    nlohmann::json stats_json = IPCSolver::stats();
+    stats_json["total_cg_iterations"] = cg_iterations;
+    stats_json["num_negative_curvature"] = num_negative_curvature;
+    return stats_json;
+}
+
+} // namespace ipc::rigid
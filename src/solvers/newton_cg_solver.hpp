@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+
+#include <opt/body_block_hessian.hpp>
+#include <solvers/ipc_solver.hpp>
+
+namespace ipc::rigid {
+
+/**
+ * @brief Matrix-free inexact Newton solver.
+ *
+ * The Newton system is solved with a preconditioned conjugate gradient (PCG)
+ * using Hessian-vector products with the unassembled per-body and body-pair
+ * blocks of the objective's Hessian. The PCG is preconditioned with the
+ * (factorized) per-body diagonal blocks and truncated with an
+ * Eisenstat–Walker forcing term.
+ */
+class NewtonCGSolver : public IPCSolver {
+public:
+    NewtonCGSolver();
+    virtual ~NewtonCGSolver() = default;
+
+    /// Initialize the state of the solver using the settings saved in JSON
+    virtual void settings(const nlohmann::json& params) override;
+    /// Export the state of the solver using the settings saved in JSON
+    virtual nlohmann::json settings() const override;
+
+    /// An identifier for the solver class
+    static std::string solver_name() { return "newton_cg_solver"; }
+    /// An identifier for this solver
+    virtual std::string name() const override
+    {
+        return NewtonCGSolver::solver_name();
+    }
+
+    /// Initialize the solver state for a new solve
+    virtual void init_solve(const Eigen::VectorXd& x0) override;
+
+    virtual std::string stats_string() const override;
+    virtual nlohmann::json stats() const override;
+
+protected:
+    bool compute_free_direction(double& fx) override;
+
+    /// @brief Inverse of a diagonal block of the Hessian over the free DoF.
+    struct PreconditionerBlock {
+        int start;        ///< @brief First free DoF of the block
+        MatrixMax6d inv;  ///< @brief Inverse of the block
+    };
+
+    /// @brief Build the block-Jacobi preconditioner over the free DoF.
+    void compute_preconditioner(
+        const BodyBlockHessian& hess, const Eigen::VectorXi& free_dof);
+
+    /// @brief Apply the block-Jacobi preconditioner to a free DoF vector.
+    Eigen::VectorXd apply_preconditioner(const Eigen::VectorXd& r) const;
+
+    /**
+     * @brief Solve H d = b over the free DoF with a truncated PCG.
+     *
+     * @param hess  Hessian over all DoF
+     * @param b     Right-hand side over the free DoF
+     * @param tol   Absolute tolerance on the residual norm
+     * @param d     Solution over the free DoF
+     * @return The number of CG iterations.
+     */
+    int solve_free_system(
+        const BodyBlockHessian& hess,
+        const Eigen::VectorXd& b,
+        double tol,
+        Eigen::VectorXd& d);
+
+    /// @brief Update the Eisenstat–Walker forcing term.
+    double update_forcing_term(double grad_norm);
+
+    /// @brief Maximum number of CG iterations per Newton iteration.
+    int max_cg_iterations;
+    /// @brief Upper bound on the forcing term (relative CG tolerance).
+    double max_forcing_term;
+
+    /// @brief Forcing term of the previous Newton iteration.
+    double prev_forcing_term;
+    /// @brief Norm of the free gradient of the previous Newton iteration.
+    double prev_grad_norm;
+
+    std::vector<PreconditionerBlock> preconditioner;
+
+private:
+    size_t cg_iterations = 0;
+    size_t num_negative_curvature = 0;
+};
+
+} // namespace ipc::rigid
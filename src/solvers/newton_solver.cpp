@@ -4,6 +4,7 @@
 #include <igl/slice.h>
 #include <igl/slice_into.h>
 #include <igl/writeOBJ.h>
+#include <tbb/parallel_for.h>
 
 #include <constants.hpp>
 #include <logger.hpp>
@@ -18,6 +19,14 @@ NewtonSolver::NewtonSolver()
     , iteration_number(0)
     , convergence_criteria(ConvergenceCriteria::ENERGY)
     , m_line_search_lower_bound(Constants::DEFAULT_LINE_SEARCH_LOWER_BOUND)
+    , line_search_batch_size(1)
+    , regularization_coeff(0)
+    , hessian_reuse(false)
+    , max_hessian_reuse(10)
+    , refresh_hessian(true)
+    , is_hessian_lagged(false)
+    , hessian_age(0)
+    , hessian_active_set_hash(0)
     , energy_conv_tol(Constants::DEFAULT_NEWTON_ENERGY_CONVERGENCE_TOL)
     , velocity_conv_tol(Constants::DEFAULT_NEWTON_VELOCITY_CONVERGENCE_TOL)
     , is_velocity_conv_tol_abs(false)
@@ -34,6 +43,9 @@ void NewtonSolver::settings(const nlohmann::json& json)
     velocity_conv_tol = json["velocity_conv_tol"];
     is_velocity_conv_tol_abs = json["is_velocity_conv_tol_abs"];
     m_line_search_lower_bound = json["line_search_lower_bound"];
+    hessian_reuse = json["hessian_reuse"];
+    max_hessian_reuse = json["max_hessian_reuse"];
+    line_search_batch_size = json["line_search_batch_size"];
 
     linear_solver_settings = json["linear_solver"];
     try {
@@ -59,6 +71,9 @@ nlohmann::json NewtonSolver::settings() const
     settings["energy_conv_tol"] = energy_conv_tol;
     settings["velocity_conv_tol"] = velocity_conv_tol;
     settings["is_velocity_conv_tol_abs"] = is_velocity_conv_tol_abs;
+    settings["hessian_reuse"] = hessian_reuse;
+    settings["max_hessian_reuse"] = max_hessian_reuse;
+    settings["line_search_batch_size"] = line_search_batch_size;
     return settings;
 }
 
@@ -78,7 +93,8 @@ nlohmann::json NewtonSolver::stats() const
              { "count_grad", num_grad_fx },
              { "count_hess", num_hessian_fx },
              { "count_ccd", num_collision_check },
-             { "total_regularizations", regularization_iterations } };
+             { "total_regularizations", regularization_iterations },
+             { "count_hessian_reuse", num_hessian_reuses } };
 }
 
 std::string NewtonSolver::stats_string() const
@@ -87,10 +103,10 @@ std::string NewtonSolver::stats_string() const
         "total_newton_steps={:d} total_ls_steps={:d} "
         "num_newton_ls_fails={:d} num_grad_ls_fails={:d} count_fx={:d} "
         "count_grad={:d} count_hess={:d} count_ccd={:d} "
-        "total_regularizations={:d}",
+        "total_regularizations={:d} count_hessian_reuse={:d}",
         newton_iterations, ls_iterations, num_newton_ls_fails,
         num_grad_ls_fails, num_fx, num_grad_fx, num_hessian_fx,
-        num_collision_check, regularization_iterations);
+        num_collision_check, regularization_iterations, num_hessian_reuses);
 }
 
 void NewtonSolver::reset_stats()
@@ -104,6 +120,7 @@ void NewtonSolver::reset_stats()
     num_newton_ls_fails = 0;
     num_grad_ls_fails = 0;
     regularization_iterations = 0;
+    num_hessian_reuses = 0;
 }
 
 bool NewtonSolver::converged()
@@ -182,7 +199,14 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
     //     dynamic_cast<SimulationProblem*>(problem_ptr)->faces());
 
     double step_length = 1.0;
-    double regulariztion_coeff = 0;
+    regularization_coeff = 0;
+    // The objective changes between solves, so never reuse a factorization
+    refresh_hessian = true;
+
+    dof_reduction =
+        DofReduction(problem_ptr->free_dof(), problem_ptr->num_vars());
+    problem_ptr->set_num_concurrent_evaluations(
+        std::max(line_search_batch_size, 1));
 
     spdlog::debug("solver={} action=BEGIN", name());
 
@@ -196,47 +220,49 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
 
     for (iteration_number = 0; iteration_number < max_iterations;
          iteration_number++) {
-        double fx = problem_ptr->compute_objective(x, gradient, hessian);
+        double fx;
+        bool found_newton_step = false, is_done = false;
+        // Retry with a fresh Hessian (in the same iteration) before falling
+        // back to the gradient
+        while (true) {
+            if (!compute_free_direction(fx)) {
+                exit_reason = "regularization failed";
+                is_done = true;
+                break;
+            }
 
-        num_fx++;
-        num_grad_fx++;
-        num_hessian_fx++;
+            ///////////////////////////////////////////////////////////////
+            // Line search over newton direction
+            // get grad direction for lineseach
+            dof_reduction.expand(gradient_free, grad_direction);
+            dof_reduction.expand(direction_free, direction);
+
+            // check for newton termination
+            if (iteration_number > 0 && converged()) {
+                exit_reason = "found a local optimum with newton dir";
+                success = true;
+                is_done = true;
+                break;
+            }
 
-        // Remove rows and cols of fixed DoF
-        Eigen::VectorXi free_dof = problem_ptr->free_dof();
-        igl::slice(gradient, free_dof, gradient_free);
-        igl::slice(hessian, free_dof, free_dof, hessian_free);
+            step_length = 1;
+            found_newton_step =
+                line_search(x, direction, fx, grad_direction, step_length);
+            ///////////////////////////////////////////////////////////////
 
-#ifdef USE_GRADIENT_DESCENT
-        direction_free = -gradient_free;
-#else
-        bool solve_success = compute_regularized_direction(
-            fx, gradient_free, hessian_free, direction_free,
-            regulariztion_coeff);
-        if (!solve_success) {
-            exit_reason = "regularization failed";
-            break;
+            if (found_newton_step || !is_hessian_lagged) {
+                break;
+            }
+            spdlog::debug(
+                "solver={} iter={:d} msg=\"lagged newton line-search failed; "
+                "refreshing the hessian\"",
+                name(), iteration_number);
+            refresh_hessian = true;
         }
-#endif
-
-        ///////////////////////////////////////////////////////////////////
-        // Line search over newton direction
-        // get grad direction for lineseach
-        igl::slice_into(gradient_free, free_dof, grad_direction);
-        igl::slice_into(direction_free, free_dof, direction);
-
-        // check for newton termination
-        if (iteration_number > 0 && converged()) {
-            exit_reason = "found a local optimum with newton dir";
-            success = true;
+        if (is_done) {
             break;
         }
 
-        step_length = 1;
-        bool found_newton_step =
-            line_search(x, direction, fx, grad_direction, step_length);
-        ///////////////////////////////////////////////////////////////////
-
         ///////////////////////////////////////////////////////////////////
         // When newton direction fails, revert to gradient descent
         if (!found_newton_step) {
@@ -295,6 +321,11 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
             "solver={} iter={:d} step_length={:g}", name(), iteration_number,
             step_length);
 
+        // A lagged Hessian that no longer gives full steps has gone stale
+        if (is_hessian_lagged && step_length < 1) {
+            refresh_hessian = true;
+        }
+
         x_prev = x;
         x += step_length * direction;
         assert(!problem_ptr->has_collisions(x_prev, x));
@@ -311,6 +342,68 @@ OptimizationResults NewtonSolver::solve(const Eigen::VectorXd& x0)
         x, problem_ptr->compute_objective(x), success, true, iteration_number);
 }
 
+bool NewtonSolver::compute_free_direction(double& fx)
+{
+    is_hessian_lagged = false;
+    if (hessian_reuse && compute_lagged_free_direction(fx)) {
+        is_hessian_lagged = true;
+        return true;
+    }
+
+    fx = problem_ptr->compute_objective(x, gradient, hessian);
+
+    num_fx++;
+    num_grad_fx++;
+    num_hessian_fx++;
+
+    // Remove rows and cols of fixed DoF
+    dof_reduction.reduce(gradient, gradient_free);
+    dof_reduction.reduce(hessian, hessian_free);
+
+#ifdef USE_GRADIENT_DESCENT
+    direction_free = -gradient_free;
+    return true;
+#else
+    bool success = compute_regularized_direction(
+        fx, gradient_free, hessian_free, direction_free,
+        regularization_coeff);
+    if (hessian_reuse) {
+        // The linear solver now holds the factorization of hessian_free
+        refresh_hessian = !success;
+        hessian_age = 0;
+        hessian_active_set_hash = problem_ptr->active_set_hash(x);
+    }
+    return success;
+#endif
+}
+
+bool NewtonSolver::compute_lagged_free_direction(double& fx)
+{
+    if (refresh_hessian || hessian_age >= max_hessian_reuse
+        || hessian_free.rows() != dof_reduction.num_free_dof()
+        || problem_ptr->active_set_hash(x) != hessian_active_set_hash) {
+        return false;
+    }
+
+    fx = problem_ptr->compute_objective(x, gradient);
+    num_fx++;
+    num_grad_fx++;
+
+    dof_reduction.reduce(gradient, gradient_free);
+
+    // Solve with the factorization of a previous iteration's Hessian
+    direction_free = Eigen::VectorXd::Zero(gradient_free.size());
+    linear_solver->solve(-gradient_free, direction_free);
+    if (!direction_free.allFinite()
+        || gradient_free.dot(direction_free) >= 0) {
+        return false; // The gradient is still valid for a full refresh
+    }
+
+    hessian_age++;
+    num_hessian_reuses++;
+    return true;
+}
+
 bool NewtonSolver::line_search(
     const Eigen::VectorXd& x,
     const Eigen::VectorXd& dir,
@@ -356,29 +449,66 @@ bool NewtonSolver::line_search(
             name(), iteration_number, step_length, lower_bound);
     }
 
+    // Number of consecutive halvings of the step length evaluated together
+    int max_batch_size = std::max(line_search_batch_size, 1);
+    if (!problem_ptr->is_thread_safe()) {
+        max_batch_size = 1;
+    }
+#ifdef RIGID_IPC_PROFILE_FUNCTIONS
+    max_batch_size = 1; // The profiler is not thread safe
+#endif
+
     double fxi = std::numeric_limits<double>::infinity();
     while (std::isfinite(lower_bound) && step_length >= lower_bound) {
-        num_it++;        // Count the number of iterations
-        ls_iterations++; // Count the gloabal number of iterations
-
-        // Compute the next variable
-        Eigen::VectorXd xi = x + step_length * dir;
-
-        // NOTE: We do not need to check for collisions because we filtered
-        // the step length.
-        // Check for collisions between newton updates
-        if (is_ccd_aligned_with_newton_update
-            || !problem_ptr->has_collisions(x, xi)) {
-            fxi = problem_ptr->compute_objective(xi);
+        // Do not evaluate step lengths below the lower bound
+        int batch_size = max_batch_size;
+        while (batch_size > 1
+               && std::ldexp(step_length, 1 - batch_size) < lower_bound) {
+            batch_size--;
+        }
+
+        // NaN marks step lengths skipped because of collisions
+        std::vector<double> batch_fx(
+            batch_size, std::numeric_limits<double>::quiet_NaN());
+        const auto evaluate = [&](int i) {
+            // Compute the next variable
+            Eigen::VectorXd xi = x + std::ldexp(step_length, -i) * dir;
+
+            // NOTE: We do not need to check for collisions because we
+            // filtered the step length.
+            // Check for collisions between newton updates
+            if (is_ccd_aligned_with_newton_update
+                || !problem_ptr->has_collisions(x, xi)) {
+                batch_fx[i] = problem_ptr->compute_objective(xi);
+            }
+        };
+        if (batch_size == 1) {
+            evaluate(0);
+        } else {
+            tbb::parallel_for(0, batch_size, evaluate);
+        }
+
+        // Take the largest step length that decreases the objective
+        for (int i = 0; i < batch_size; i++) {
+            num_it++;        // Count the number of iterations
+            ls_iterations++; // Count the gloabal number of iterations
+            if (std::isnan(batch_fx[i])) {
+                continue;
+            }
+            fxi = batch_fx[i];
             num_fx++; // Count the number of objective computations
             if (fxi < fx) {
+                step_length = std::ldexp(step_length, -i);
                 success = true;
-                break; // while loop
+                break;
             }
         }
+        if (success) {
+            break; // while loop
+        }
 
         // Try again with a smaller step_length
-        step_length /= 2.0;
+        step_length = std::ldexp(step_length, -batch_size);
     }
 
     PROFILE_MESSAGE(
@@ -625,6 +755,12 @@ void NewtonSolver::post_step_update()
     if (is_energy_converged
         && !problem_ptr->are_equality_constraints_satisfied(x)) {
         problem_ptr->update_augmented_lagrangian(x);
+        // Satisfied constraints fix DoF
+        dof_reduction =
+            DofReduction(problem_ptr->free_dof(), problem_ptr->num_vars());
+        direction.setZero();
+        grad_direction.setZero();
+        refresh_hessian = true;
     }
 }
 
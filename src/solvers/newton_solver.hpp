@@ -4,6 +4,7 @@
 #include <polysolve/LinearSolver.hpp>
 
 #include <constants.hpp>
+#include <opt/dof_reduction.hpp>
 #include <solvers/optimization_solver.hpp>
 #include <utils/not_implemented_error.hpp>
 
@@ -94,6 +95,28 @@ public:
     int max_iterations;
 
 protected:
+    /**
+     * @brief Evaluate the objective at x and compute the search direction
+     * over the free DoF (see dof_reduction).
+     *
+     * Fills in gradient, gradient_free, and direction_free.
+     *
+     * @param[out] fx  Value of the objective at x.
+     *
+     * @return Returns false if no search direction could be computed.
+     */
+    virtual bool compute_free_direction(double& fx);
+
+    /**
+     * @brief Compute the search direction over the free DoF using the
+     * factorization of a previous iteration's Hessian.
+     *
+     * Only the objective and its gradient are evaluated.
+     *
+     * @return Returns false if the Hessian needs to be refreshed.
+     */
+    bool compute_lagged_free_direction(double& fx);
+
     virtual bool converged();
 
     virtual void post_step_update();
@@ -114,9 +137,29 @@ protected:
     OptimizationProblem* problem_ptr;
 
     int iteration_number; ///< @brief The current iteration number.
+
+    /// @brief Map to the free DoF (updated when the fixed DoF change).
+    DofReduction dof_reduction;
     ConvergenceCriteria convergence_criteria;
 
     double m_line_search_lower_bound; ///< @brief Line search lower bound
+    /// @brief Number of step lengths the line search evaluates in parallel.
+    /// @note Only used if the problem is thread safe.
+    int line_search_batch_size;
+    double regularization_coeff; ///< @brief Current Tikhonov regularization
+
+    /// @brief Reuse the factorized Hessian over multiple iterations.
+    bool hessian_reuse;
+    /// @brief Maximum number of iterations a factorization is reused.
+    int max_hessian_reuse;
+    /// @brief Recompute the Hessian at the next iteration.
+    bool refresh_hessian;
+    /// @brief Was the current direction computed with a lagged Hessian?
+    bool is_hessian_lagged;
+    /// @brief Number of iterations the current factorization was reused.
+    int hessian_age;
+    /// @brief Active set of the factorized Hessian.
+    size_t hessian_active_set_hash;
 
     double energy_conv_tol;        ///< @brief Energy convergence tolerance
     double velocity_conv_tol;      ///< @brief Velocity convergence tolerance
@@ -134,9 +177,6 @@ protected:
     std::unique_ptr<polysolve::LinearSolver> linear_solver;
     nlohmann::json linear_solver_settings;
 
-private:
-    void reset_stats();
-
     size_t num_fx = 0;
     size_t num_grad_fx = 0;
     size_t num_hessian_fx = 0;
@@ -146,6 +186,10 @@ private:
     size_t num_newton_ls_fails = 0;
     size_t num_grad_ls_fails = 0;
     size_t regularization_iterations = 0;
+    size_t num_hessian_reuses = 0;
+
+private:
+    void reset_stats();
 };
 
 /**
@@ -2,6 +2,8 @@
 
 #include <solvers/homotopy_solver.hpp>
 #include <solvers/ipc_solver.hpp>
+#include <solvers/lbfgs_solver.hpp>
+#include <solvers/newton_cg_solver.hpp>
 
 namespace ipc::rigid {
 
@@ -18,6 +20,10 @@ SolverFactory::SolverFactory()
         HomotopySolver::solver_name(), std::make_shared<HomotopySolver>());
     barrier_solvers.emplace(
         IPCSolver::solver_name(), std::make_shared<IPCSolver>());
+    barrier_solvers.emplace(
+        NewtonCGSolver::solver_name(), std::make_shared<NewtonCGSolver>());
+    barrier_solvers.emplace(
+        LBFGSSolver::solver_name(), std::make_shared<LBFGSSolver>());
 }
 
 std::shared_ptr<OptimizationSolver>
@@ -0,0 +1,111 @@
+#include "adaptive_timestep.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include <logger.hpp>
+
+namespace ipc::rigid {
+
+AdaptiveTimestep::AdaptiveTimestep()
+    : enabled(false)
+    , min_timestep(1e-5)
+    , shrink_factor(0.5)
+    , grow_factor(1.5)
+    , max_iterations(50)
+    , min_iterations(10)
+    , min_toi(0.1)
+    , m_frame_timestep(0)
+    , m_frame_time(0)
+    , m_timestep(std::numeric_limits<double>::infinity())
+{
+}
+
+void AdaptiveTimestep::settings(const nlohmann::json& json)
+{
+    enabled = json["enabled"];
+    min_timestep = json["min_timestep"];
+    shrink_factor = json["shrink_factor"];
+    grow_factor = json["grow_factor"];
+    max_iterations = json["max_iterations"];
+    min_iterations = json["min_iterations"];
+    min_toi = json["min_toi"];
+    assert(0 < shrink_factor && shrink_factor < 1);
+    assert(grow_factor >= 1);
+    m_timestep = std::numeric_limits<double>::infinity();
+}
+
+nlohmann::json AdaptiveTimestep::settings() const
+{
+    nlohmann::json json;
+    json["enabled"] = enabled;
+    json["min_timestep"] = min_timestep;
+    json["shrink_factor"] = shrink_factor;
+    json["grow_factor"] = grow_factor;
+    json["max_iterations"] = max_iterations;
+    json["min_iterations"] = min_iterations;
+    json["min_toi"] = min_toi;
+    return json;
+}
+
+void AdaptiveTimestep::begin_frame(double frame_timestep)
+{
+    m_frame_timestep = frame_timestep;
+    m_frame_time = 0;
+    m_timestep = std::min(m_timestep, frame_timestep);
+    if (!enabled) {
+        m_timestep = frame_timestep;
+    }
+}
+
+bool AdaptiveTimestep::is_frame_finished() const
+{
+    // Tolerate round-off from summing the substeps
+    return m_frame_timestep - m_frame_time <= 1e-12 * m_frame_timestep;
+}
+
+double AdaptiveTimestep::next_substep() const
+{
+    double remaining = m_frame_timestep - m_frame_time;
+    // Avoid leaving a sliver of the frame for one tiny extra substep
+    if (remaining <= 1.25 * m_timestep) {
+        return remaining;
+    }
+    return m_timestep;
+}
+
+void AdaptiveTimestep::end_substep(
+    double substep, const SubstepDifficulty& difficulty)
+{
+    m_frame_time += substep;
+    if (!enabled) {
+        return;
+    }
+
+    bool is_hard = !difficulty.success
+        || difficulty.num_iterations > max_iterations
+        || difficulty.num_line_search_failures > 0
+        || difficulty.earliest_toi < min_toi;
+    bool is_easy = difficulty.success
+        && difficulty.num_iterations <= min_iterations
+        && difficulty.num_line_search_failures == 0
+        && difficulty.earliest_toi > 1;
+
+    double prev_timestep = m_timestep;
+    if (is_hard) {
+        m_timestep = std::max(shrink_factor * substep, min_timestep);
+    } else if (is_easy) {
+        m_timestep = std::min(grow_factor * m_timestep, m_frame_timestep);
+    }
+
+    if (m_timestep != prev_timestep) {
+        spdlog::debug(
+            "adaptive_timestep substep={:g} iterations={:d} "
+            "ls_failures={:d} toi={:g} timestep={:g}",
+            substep, difficulty.num_iterations,
+            difficulty.num_line_search_failures, difficulty.earliest_toi,
+            m_timestep);
+    }
+}
+
+} // namespace ipc::rigid
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <limits>
+
+#include <nlohmann/json.hpp>
+
+namespace ipc::rigid {
+
+/// @brief Indicators of how hard a substep was to solve.
+struct SubstepDifficulty {
+    /// @brief Did the optimization solver converge?
+    bool success = true;
+    /// @brief Number of solver iterations.
+    int num_iterations = 0;
+    /// @brief Number of failed line-searches.
+    int num_line_search_failures = 0;
+    /// @brief Earliest time of impact found by CCD (∞ if none).
+    double earliest_toi = std::numeric_limits<double>::infinity();
+};
+
+/**
+ * @brief Controller of the time-step size used to advance one output frame.
+ *
+ * A frame is advanced with one or more substeps whose size shrinks when a
+ * substep was hard to solve (no convergence, many iterations, failed
+ * line-searches, or a small time of impact) and grows back when substeps
+ * converge quickly. The last substep of a frame is clamped so that every
+ * frame ends exactly at its output time.
+ */
+class AdaptiveTimestep {
+public:
+    AdaptiveTimestep();
+
+    /// Initialize the state of the controller using the settings saved in JSON
+    void settings(const nlohmann::json& params);
+    /// Export the state of the controller using the settings saved in JSON
+    nlohmann::json settings() const;
+
+    /// @brief Start advancing a frame of the given length.
+    void begin_frame(double frame_timestep);
+    /// @brief Has the current frame been fully advanced?
+    bool is_frame_finished() const;
+    /// @brief Size of the next substep of the current frame.
+    double next_substep() const;
+    /// @brief Advance the frame by a substep and adapt the substep size.
+    void end_substep(double substep, const SubstepDifficulty& difficulty);
+
+    /// @brief Current (unclamped) substep size.
+    double timestep() const { return m_timestep; }
+    /// @brief Set the substep size (e.g., when restarting a simulation).
+    void timestep(double timestep) { m_timestep = timestep; }
+
+    /// @brief Adapt the time-step (otherwise one substep per frame).
+    bool enabled;
+    /// @brief Smallest allowed substep size.
+    double min_timestep;
+    /// @brief Factor applied to the substep size after a hard substep.
+    double shrink_factor;
+    /// @brief Factor applied to the substep size after an easy substep.
+    double grow_factor;
+    /// @brief Substeps with more solver iterations are hard.
+    int max_iterations;
+    /// @brief Substeps with at most this many solver iterations are easy.
+    int min_iterations;
+    /// @brief Substeps with an earlier time of impact are hard.
+    double min_toi;
+
+protected:
+    double m_frame_timestep; ///< @brief Length of the current frame
+    double m_frame_time;     ///< @brief Time advanced in the current frame
+    double m_timestep;       ///< @brief Current substep size
+};
+
+} // namespace ipc::rigid
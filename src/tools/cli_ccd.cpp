@@ -3,6 +3,7 @@
 #include <ccd/ccd.hpp>
 #include <io/read_rb_scene.hpp>
 #include <io/serialize_json.hpp>
+#include <io/trajectory.hpp>
 
 #include <logger.hpp>
 
@@ -33,9 +34,12 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    auto state_sequence =
-        scene["animation"]["state_sequence"].get<std::vector<nlohmann::json>>();
-    if (state_sequence.size() == 0) {
+    TrajectoryReader states;
+    if (!states.open(scene, input_filename)) {
+        spdlog::error("Unable to read the simulation states");
+        return 1;
+    }
+    if (states.num_frames() == 0) {
         return 0;
     }
 
@@ -48,23 +52,12 @@ int main(int argc, char* argv[])
         ? CollisionType::EDGE_VERTEX
         : (CollisionType::EDGE_EDGE | CollisionType::FACE_VERTEX);
 
-    PosesD poses_t0(bodies.num_bodies());
-    assert(state_sequence[0]["rigid_bodies"].size() == bodies.num_bodies());
-    for (int i = 0; i < bodies.num_bodies(); i++) {
-        const auto& jrb = state_sequence[0]["rigid_bodies"][i];
-        from_json(jrb["position"], poses_t0[i].position);
-        from_json(jrb["rotation"], poses_t0[i].rotation);
-    }
+    assert(states.num_bodies() == bodies.num_bodies());
+    PosesD poses_t0 = states.poses(0);
 
     int collision_steps = 0;
-    for (size_t i = 1; i < state_sequence.size(); ++i) {
-        PosesD poses_t1(bodies.num_bodies());
-        assert(state_sequence[i]["rigid_bodies"].size() == bodies.num_bodies());
-        for (int j = 0; j < bodies.num_bodies(); j++) {
-            const auto& jrb = state_sequence[i]["rigid_bodies"][j];
-            from_json(jrb["position"], poses_t1[j].position);
-            from_json(jrb["rotation"], poses_t1[j].rotation);
-        }
+    for (size_t i = 1; i < states.num_frames(); ++i) {
+        PosesD poses_t1 = states.poses(i);
 
         Impacts impacts;
         detect_collisions(
@@ -5,6 +5,7 @@
 
 #include <io/read_rb_scene.hpp>
 #include <io/serialize_json.hpp>
+#include <io/trajectory.hpp>
 #include <physics/rigid_body_assembler.hpp>
 
 #include <logger.hpp>
@@ -47,9 +48,12 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    auto state_sequence =
-        scene["animation"]["state_sequence"].get<std::vector<nlohmann::json>>();
-    if (state_sequence.size() == 0) {
+    TrajectoryReader states;
+    if (!states.open(scene, input_json)) {
+        spdlog::error("Unable to read the simulation states");
+        return 1;
+    }
+    if (states.num_frames() == 0) {
         return 0;
     }
 
@@ -60,14 +64,9 @@ int main(int argc, char* argv[])
 
     std::stringstream csv;
     csv << fmt::format("it, {}\n", header);
-    for (size_t i = 0; i < state_sequence.size(); ++i) {
-        PosesD poses(bodies.num_bodies());
-        assert(state_sequence[i]["rigid_bodies"].size() == bodies.num_bodies());
-        for (int j = 0; j < bodies.num_bodies(); j++) {
-            const auto& jrb = state_sequence[i]["rigid_bodies"][j];
-            from_json(jrb["position"], poses[j].position);
-            from_json(jrb["rotation"], poses[j].rotation);
-        }
+    assert(states.num_bodies() == bodies.num_bodies());
+    for (size_t i = 0; i < states.num_frames(); ++i) {
+        PosesD poses = states.poses(i);
 
         Eigen::MatrixXd V = bodies.world_vertices(poses);
 
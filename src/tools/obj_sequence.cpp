@@ -2,6 +2,8 @@
 #include <ghc/fs_std.hpp> // filesystem
 
 #include <SimState.hpp>
+#include <io/trajectory.hpp>
+#include <io/write_obj.hpp>
 #include <logger.hpp>
 
 int main(int argc, char* argv[])
@@ -13,7 +15,7 @@ int main(int argc, char* argv[])
     std::string sim_path = "";
     app.add_option(
            "sim_path,-i,-s,--sim-path", sim_path,
-           "JSON file with simulation results")
+           "JSON file with simulation results or a trajectory file (.traj)")
         ->required();
 
     std::string output_dir = "";
@@ -22,6 +24,11 @@ int main(int argc, char* argv[])
            "directory for OBJ sequence")
         ->required();
 
+    bool per_body = false;
+    app.add_flag(
+        "--per-body", per_body,
+        "write one OBJ per body and the body transforms of each frame");
+
     spdlog::level::level_enum loglevel = spdlog::level::warn;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -36,8 +43,20 @@ int main(int argc, char* argv[])
 
     set_logger_level(loglevel);
 
-    // Create the output directory if it does not exist
-    fs::create_directories(fs::path(output_dir));
+    // Read the poses and meshes directly from a binary trajectory
+    if (fs::path(sim_path).extension() == ".traj") {
+        TrajectoryReader states;
+        std::vector<RigidBody> rbs;
+        if (!states.open(sim_path) || !states.bodies(rbs)) {
+            return app.exit(CLI::Error(
+                "load_sim_failed", "Unable to load simulation trajectory!"));
+        }
+        RigidBodyAssembler bodies;
+        bodies.init(rbs);
+        bool success =
+            write_obj_sequence(output_dir, bodies, states, per_body);
+        return success ? 0 : 1;
+    }
 
     SimState sim;
     bool success = sim.load_scene(sim_path);
@@ -45,5 +64,5 @@ int main(int argc, char* argv[])
         return app.exit(
             CLI::Error("load_sim_failed", "Unable to load simulation result!"));
     }
-    sim.save_obj_sequence(output_dir);
+    return sim.save_obj_sequence(output_dir, per_body) ? 0 : 1;
 }
@@ -10,6 +10,7 @@
 #include <io/read_obj.hpp>
 #include <io/read_rb_scene.hpp>
 #include <io/serialize_json.hpp>
+#include <io/trajectory.hpp>
 #include <logger.hpp>
 #include <physics/pose.hpp>
 #include <physics/rigid_body_assembler.hpp>
@@ -57,12 +58,13 @@ SimRenderArgs parse_args(int argc, char* argv[])
 
     if (!fs::is_directory(args.sim_path)
         && args.sim_path.extension().string() != ".json"
-        && args.sim_path.extension().string() != ".JSON") {
+        && args.sim_path.extension().string() != ".JSON"
+        && args.sim_path.extension().string() != ".traj") {
         exit(app.exit(CLI::Error(
             "invalid input",
             fmt::format(
-                "invalid input path ({}) must be a simulation JSON or "
-                "directory "
+                "invalid input path ({}) must be a simulation JSON, "
+                "trajectory (.traj), or directory "
                 "containing an OBJ sequence",
                 args.sim_path.string()))));
     }
@@ -159,47 +161,54 @@ class RigidBodySequence : public MeshGenerator {
 public:
     RigidBodySequence(const fs::path& input)
     {
-        // Read the simulation json file
-        nlohmann::json sim;
-        if (!read_json(input.string(), sim)) {
-            spdlog::error("Invalid simulation JSON file");
-            exit(1);
-        }
+        std::vector<ipc::rigid::RigidBody> rbs;
+        if (input.extension().string() == ".traj") {
+            // The trajectory stores the meshes, so no scene is needed
+            if (!states.open(input.string()) || !states.bodies(rbs)) {
+                spdlog::error("Unable to read the simulation trajectory");
+                exit(1);
+            }
+        } else {
+            // Read the simulation json file
+            nlohmann::json sim;
+            if (!read_json(input.string(), sim)) {
+                spdlog::error("Invalid simulation JSON file");
+                exit(1);
+            }
 
-        state_sequence = sim["animation"]["state_sequence"]
-                             .get<std::vector<nlohmann::json>>();
+            if (!states.open(sim, input.string())) {
+                spdlog::error("Unable to read the simulation states");
+                exit(1);
+            }
 
-        std::vector<ipc::rigid::RigidBody> rbs;
-        ipc::rigid::read_rb_scene(sim["args"]["rigid_body_problem"], rbs);
+            if (!states.bodies(rbs)) {
+                ipc::rigid::read_rb_scene(
+                    sim["args"]["rigid_body_problem"], rbs);
+            }
+        }
         bodies.init(rbs);
 
         // Per-vertex colors
         vertex_colors.resize(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_colors.segment(start_i, body.vertices.rows())
+            vertex_colors.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
 
-        m_fps = int(1 / sim["args"]["timestep"].get<double>());
+        m_fps = int(1 / states.timestep());
     }
 
     virtual ~RigidBodySequence() override {};
 
-    size_t num_meshes() override { return state_sequence.size(); }
+    size_t num_meshes() override { return states.num_frames(); }
 
     Eigen::MatrixXd vertices(size_t i) override
     {
         assert(i < num_meshes());
-        ipc::rigid::PosesD poses(bodies.num_bodies());
-        assert(state_sequence[i]["rigid_bodies"].size() == bodies.num_bodies());
-        for (int j = 0; j < bodies.num_bodies(); j++) {
-            const auto& jrb = state_sequence[i]["rigid_bodies"][j];
-            ipc::rigid::from_json(jrb["position"], poses[j].position);
-            ipc::rigid::from_json(jrb["rotation"], poses[j].rotation);
-        }
-        return bodies.world_vertices(poses);
+        assert(states.num_bodies() == bodies.num_bodies());
+        return bodies.world_vertices(states.poses(i));
     }
 
     Eigen::MatrixXi edges(size_t i) override { return bodies.m_edges; }
@@ -211,7 +220,7 @@ public:
     int fps() override { return m_fps; }
 
 protected:
-    std::vector<nlohmann::json> state_sequence;
+    ipc::rigid::TrajectoryReader states;
     ipc::rigid::RigidBodyAssembler bodies;
     Eigen::VectorXi vertex_colors;
     int m_fps;
@@ -2,6 +2,8 @@
 #include <ghc/fs_std.hpp> // filesystem
 
 #include <SimState.hpp>
+#include <io/trajectory.hpp>
+#include <io/write_gltf.hpp>
 #include <logger.hpp>
 
 int main(int argc, char* argv[])
@@ -13,12 +15,24 @@ int main(int argc, char* argv[])
     std::string sim_path = "";
     app.add_option(
            "sim_path,-i,-s,--sim-path", sim_path,
-           "JSON file with simulation results")
+           "JSON file with simulation results or a trajectory file (.traj)")
         ->required();
 
     std::string output = "";
     app.add_option("output,-o,--output", output, "output filename")->required();
 
+    GLTFOptions gltf_options;
+    CLI::Option* translation_tolerance = app.add_option(
+        "--translation-tolerance", gltf_options.translation_tolerance,
+        "drop keyframes within this distance of the interpolated translation");
+    CLI::Option* rotation_tolerance = app.add_option(
+        "--rotation-tolerance", gltf_options.rotation_tolerance,
+        "drop keyframes within this angle (radians) of the interpolated "
+        "rotation");
+    CLI::Option* quantize_rotations = app.add_flag(
+        "--quantize-rotations", gltf_options.quantize_rotations,
+        "store rotations as normalized int16");
+
     spdlog::level::level_enum loglevel = spdlog::level::warn;
     app.add_option("--log,--loglevel", loglevel, "log level")
         ->default_val(loglevel)
@@ -39,11 +53,36 @@ int main(int argc, char* argv[])
         fs::create_directories(output_path.parent_path());
     }
 
+    // Read the poses and meshes directly from a binary trajectory
+    if (fs::path(sim_path).extension() == ".traj") {
+        TrajectoryReader states;
+        std::vector<RigidBody> rbs;
+        if (!states.open(sim_path) || !states.bodies(rbs)) {
+            return app.exit(CLI::Error(
+                "load_sim_failed", "Unable to load simulation trajectory!"));
+        }
+        RigidBodyAssembler bodies;
+        bodies.init(rbs);
+        return write_gltf(output, bodies, states, gltf_options) ? 0 : 1;
+    }
+
     SimState sim;
     bool success = sim.load_scene(sim_path);
     if (!success) {
         return app.exit(
             CLI::Error("load_sim_failed", "Unable to load simulation result!"));
     }
-    sim.save_gltf(output);
+    // Override the options saved with the results
+    if (*translation_tolerance) {
+        sim.m_gltf_options.translation_tolerance =
+            gltf_options.translation_tolerance;
+    }
+    if (*rotation_tolerance) {
+        sim.m_gltf_options.rotation_tolerance =
+            gltf_options.rotation_tolerance;
+    }
+    if (*quantize_rotations) {
+        sim.m_gltf_options.quantize_rotations = true;
+    }
+    return sim.save_gltf(output) ? 0 : 1;
 }
@@ -29,7 +29,7 @@ RigidBody create_body(
         /*is_dof_fixed=*/VectorMax6b::Zero(pose.ndof()),
         /*oriented=*/false,
         /*group_id=*/id++);
-    rb.vertices = vertices; // Cancel out the inertial rotation for testing
+    rb.vertices(vertices); // Cancel out the inertial rotation for testing
     rb.pose.position.setZero();
     rb.pose.rotation.setZero();
     return rb;
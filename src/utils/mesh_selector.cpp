@@ -3,6 +3,8 @@
 #include <Eigen/SparseCore>
 #include <igl/Timer.h>
 
+#include <io/checkpoint.hpp>
+
 namespace ipc::rigid {
 
 Eigen::SparseMatrix<size_t>
@@ -134,4 +136,24 @@ void MeshSelector::init_codim_edges_to_edges(size_t num_edges)
     }
 }
 
+void MeshSelector::write(CheckpointBuffer& buffer) const
+{
+    buffer.write_vector(m_vertex_to_edge);
+    buffer.write_vector(m_vertex_to_face);
+    buffer.write_vector(m_edge_to_face);
+    buffer.write_matrix(m_faces_to_edges);
+    buffer.write_vector(m_codim_vertices_to_vertices);
+    buffer.write_vector(m_codim_edges_to_edges);
+}
+
+void MeshSelector::read(CheckpointBuffer& buffer)
+{
+    buffer.read_vector(m_vertex_to_edge);
+    buffer.read_vector(m_vertex_to_face);
+    buffer.read_vector(m_edge_to_face);
+    buffer.read_matrix(m_faces_to_edges);
+    buffer.read_vector(m_codim_vertices_to_vertices);
+    buffer.read_vector(m_codim_edges_to_edges);
+}
+
 } // namespace ipc::rigid
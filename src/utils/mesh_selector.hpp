@@ -7,6 +7,8 @@
 
 namespace ipc::rigid {
 
+class CheckpointBuffer;
+
 class MeshSelector {
 public:
     MeshSelector() {}
@@ -49,6 +51,11 @@ public:
 
     size_t num_codim_edges() const { return m_codim_edges_to_edges.size(); }
 
+    /// @brief Write the maps to a binary buffer.
+    void write(CheckpointBuffer& buffer) const;
+    /// @brief Read maps written with write().
+    void read(CheckpointBuffer& buffer);
+
 protected:
     /// Map from vertices to the minimum index edge containing the vertex.
     void init_vertex_to_edge(size_t num_vertices, const Eigen::MatrixXi& E);
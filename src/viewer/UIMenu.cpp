@@ -177,7 +177,7 @@ void UISimState::draw_simulation_player()
     // --------------------------------------------------------------------
     if (ImGui::SliderInt(
             "step##Replay", &m_state.m_num_simulation_steps, 0,
-            m_state.state_sequence.size() - 1)) {
+            m_state.num_states() - 1)) {
         replaying = true;
     }
 }
@@ -93,9 +93,9 @@ void UISimState::load_scene()
         vertex_type.resize(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_type.segment(start_i, body.vertices.rows())
+            vertex_type.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
     } else {
         vertex_type =
@@ -160,9 +160,9 @@ void UISimState::redraw_scene()
         Eigen::VectorXi vertex_type(bodies.num_vertices());
         int start_i = 0;
         for (const auto& body : bodies.m_rbs) {
-            vertex_type.segment(start_i, body.vertices.rows())
+            vertex_type.segment(start_i, body.vertices().rows())
                 .setConstant(int(body.type));
-            start_i += body.vertices.rows();
+            start_i += body.vertices().rows();
         }
         mesh_data->set_vertex_data(
             m_state.problem_ptr->vertex_dof_fixed(), vertex_type);
@@ -177,15 +177,15 @@ void UISimState::redraw_scene()
 
 bool UISimState::pre_draw_loop()
 {
-    size_t last_save_state = m_state.state_sequence.size() - 1;
+    size_t last_save_state = m_state.num_states() - 1;
     if (m_state.m_num_simulation_steps > last_save_state) {
         m_state.m_num_simulation_steps = last_save_state;
         m_player_state = PlayerState::Paused;
         replaying = false;
     }
     if (replaying) {
-        m_state.problem_ptr->state(
-            m_state.state_sequence[m_state.m_num_simulation_steps]);
+        m_state.get_state(m_state.m_num_simulation_steps, m_replay_state);
+        m_state.problem_ptr->state(m_replay_state);
         redraw_scene();
         m_scene_changed = true;
         if (m_player_state == PlayerState::Playing) {
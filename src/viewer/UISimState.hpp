@@ -64,8 +64,8 @@ public:
     bool save_obj_sequence(const std::string& dir_name)
     {
         bool success = m_state.save_obj_sequence(dir_name);
-        m_state.problem_ptr->state(
-            m_state.state_sequence[m_state.m_num_simulation_steps]);
+        m_state.get_state(m_state.m_num_simulation_steps, m_replay_state);
+        m_state.problem_ptr->state(m_replay_state);
         return success;
     }
 
@@ -142,6 +142,8 @@ private:
     double m_gif_scale = 0.5;
     bool m_is_gif_recording = false;
     bool m_scene_changed;
+    /// @brief Reused to replay saved states without allocations
+    StateSnapshot m_replay_state;
 
     double m_simulation_time;
 
@@ -34,11 +34,11 @@ void print_EE_obj(
             Pose<double>::interpolate(bodyA_pose_t0, bodyA_pose_t1, i / n);
         std::cout
             << "v "
-            << bodyA.world_vertex(pose, bodyA.edges(edgeA_id, 0)).transpose()
+            << bodyA.world_vertex(pose, bodyA.edges()(edgeA_id, 0)).transpose()
             << std::endl;
         std::cout
             << "v "
-            << bodyA.world_vertex(pose, bodyA.edges(edgeA_id, 1)).transpose()
+            << bodyA.world_vertex(pose, bodyA.edges()(edgeA_id, 1)).transpose()
             << std::endl;
     }
     fmt::print("# Edge 2 vertices\n");
@@ -47,11 +47,11 @@ void print_EE_obj(
             Pose<double>::interpolate(bodyB_pose_t0, bodyB_pose_t1, i / n);
         std::cout
             << "v "
-            << bodyB.world_vertex(pose, bodyB.edges(edgeB_id, 0)).transpose()
+            << bodyB.world_vertex(pose, bodyB.edges()(edgeB_id, 0)).transpose()
             << std::endl;
         std::cout
             << "v "
-            << bodyB.world_vertex(pose, bodyB.edges(edgeB_id, 1)).transpose()
+            << bodyB.world_vertex(pose, bodyB.edges()(edgeB_id, 1)).transpose()
             << std::endl;
     }
     fmt::print("# Edge 1 surface\n");
@@ -80,7 +80,7 @@ RigidBody create_body(
         /*is_dof_fixed=*/VectorMax6b::Zero(pose.ndof()),
         /*oriented=*/false,
         /*group_id=*/id++);
-    rb.vertices = vertices; // Cancel out the inertial rotation for testing
+    rb.vertices(vertices); // Cancel out the inertial rotation for testing
     rb.pose.position.setZero();
     rb.pose.rotation.setZero();
     return rb;
@@ -270,7 +270,7 @@ TEST_CASE("Rigid face-vertex time of impact", "[ccd][rigid_toi][face_vertex]")
         double z_t1 = GENERATE(1, 1e-8, 0.0, -1e-8, -2.0, -10);
         expected_toi = 1 / (-z_t1 + 1);
         is_impact_expected = z_t1 <= 0.0 && y >= 0 && y <= 1.0;
-        bodyB_pose_t1.position.z() = z_t1 - bodyB.vertices(0, 2);
+        bodyB_pose_t1.position.z() = z_t1 - bodyB.vertices()(0, 2);
     }
     // SECTION("Rotation")
     // {
@@ -280,7 +280,7 @@ TEST_CASE("Rigid face-vertex time of impact", "[ccd][rigid_toi][face_vertex]")
     // }
 
     CAPTURE(
-        y, bodyB.vertices.row(0), bodyB_pose_t0.position.transpose(),
+        y, bodyB.vertices().row(0), bodyB_pose_t0.position.transpose(),
         bodyB_pose_t1.position.transpose(),
         bodyB.world_vertex(bodyB_pose_t0, 0).transpose(),
         bodyB.world_vertex(bodyB_pose_t1, 0).transpose());
@@ -314,11 +314,11 @@ TEST_CASE("Fast EE case", "[!benchmark][ccd][rigid_toi][edge_edge][fast]")
     RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
 
     // clang-format off
-    bodyA.vertices.row(0) << 2.66473512640082, 0.622074238426736, 0.0506824409538513;
-    bodyA.vertices.row(1) << 2.11663114018755, 0.24694623070118, 0.689392835886464;
+    bodyA_vertices.row(0) << 2.66473512640082, 0.622074238426736, 0.0506824409538513;
+    bodyA_vertices.row(1) << 2.11663114018755, 0.24694623070118, 0.689392835886464;
 
-    bodyB.vertices.row(0) << -8.23540431483827, -2.00204356583054, -0.0850398676470792;
-    bodyB.vertices.row(1) << -7.59698634143846, -2.65778542381018, 0.220598272033643;
+    bodyB_vertices.row(0) << -8.23540431483827, -2.00204356583054, -0.0850398676470792;
+    bodyB_vertices.row(1) << -7.59698634143846, -2.65778542381018, 0.220598272033643;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.0743518262648221, 2.0045466941596, -7.30362621222097e-05),
@@ -337,6 +337,8 @@ TEST_CASE("Fast EE case", "[!benchmark][ccd][rigid_toi][edge_edge][fast]")
         Eigen::Vector3d(-0.0467509876415133, -0.0464937186371367, 1.56888122389168)
     );
     // clang-format on
+    bodyA.vertices(bodyA_vertices);
+    bodyB.vertices(bodyB_vertices);
 
     BENCHMARK("Fast EE case")
     {
@@ -362,11 +364,11 @@ TEST_CASE("Slow EE case", "[!benchmark][ccd][rigid_toi][edge_edge][slow]")
     RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
 
     // clang-format off
-    bodyA.vertices.row(0) << -1.45054325721069, 2.29538642849017, 0.461193969193908;
-    bodyA.vertices.row(1) << -1.12537372801783, 1.78188213954136, 1.12303701209507;
+    bodyA_vertices.row(0) << -1.45054325721069, 2.29538642849017, 0.461193969193908;
+    bodyA_vertices.row(1) << -1.12537372801783, 1.78188213954136, 1.12303701209507;
 
-    bodyB.vertices.row(0) << -8.63773122773594, 0.523601125992661, 1.91725528075351;
-    bodyB.vertices.row(1) << -8.00096703934998, 1.01814387645424, 2.44728456523133;
+    bodyB_vertices.row(0) << -8.63773122773594, 0.523601125992661, 1.91725528075351;
+    bodyB_vertices.row(1) << -8.00096703934998, 1.01814387645424, 2.44728456523133;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.0743518262648221, 2.0045466941596, -7.30362621222097e-05),
@@ -385,6 +387,8 @@ TEST_CASE("Slow EE case", "[!benchmark][ccd][rigid_toi][edge_edge][slow]")
         Eigen::Vector3d(-0.156274624583429, -0.156172306264317, 1.56372038452934)
     );
     // clang-format on
+    bodyA.vertices(bodyA_vertices);
+    bodyB.vertices(bodyB_vertices);
 
     BENCHMARK("Slow EE Case")
     {
@@ -410,11 +414,11 @@ TEST_CASE("Actual EE Collision", "[!benchmark][ccd][rigid_toi][edge_edge]")
     RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges);
 
     // clang-format off
-    bodyA.vertices.row(0) << -1, 0, 0;
-    bodyA.vertices.row(1) << 1, 0, 0;
+    bodyA_vertices.row(0) << -1, 0, 0;
+    bodyA_vertices.row(1) << 1, 0, 0;
 
-    bodyB.vertices.row(0) << 0, 0, -1;
-    bodyB.vertices.row(1) << 0, 0, 1;
+    bodyB_vertices.row(0) << 0, 0, -1;
+    bodyB_vertices.row(1) << 0, 0, 1;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(0, 0.5, 0),
@@ -433,6 +437,8 @@ TEST_CASE("Actual EE Collision", "[!benchmark][ccd][rigid_toi][edge_edge]")
         Eigen::Vector3d(2 * 3.14, 0, 0)
     );
     // clang-format on
+    bodyA.vertices(bodyA_vertices);
+    bodyB.vertices(bodyB_vertices);
 
     BENCHMARK("Actually EE Collision")
     {
@@ -462,11 +468,11 @@ TEST_CASE("Actual VF Collision", "[!benchmark][ccd][rigid_toi][face_vertex]")
     RigidBody bodyB = create_body(bodyB_vertices, bodyB_edges, bodyB_faces);
 
     // clang-format off
-    bodyA.vertices.row(0) << 0.063161123153442, -0.00975209722618602, 0.0246948915619087;
+    bodyA_vertices.row(0) << 0.063161123153442, -0.00975209722618602, 0.0246948915619087;
 
-    bodyB.vertices.row(0) << -0.00733894260009082, 0.0199670606490534, 0.000727755816038143;
-    bodyB.vertices.row(1) << -0.0122514761614292, 0.0244249832266042, -0.00566776185395443;
-    bodyB.vertices.row(2) << -0.00945035723923828, 0.025642170175986, -0.00591155842365654;
+    bodyB_vertices.row(0) << -0.00733894260009082, 0.0199670606490534, 0.000727755816038143;
+    bodyB_vertices.row(1) << -0.0122514761614292, 0.0244249832266042, -0.00566776185395443;
+    bodyB_vertices.row(2) << -0.00945035723923828, 0.025642170175986, -0.00591155842365654;
 
     Pose<double> bodyA_pose_t0(
         Eigen::Vector3d(-0.000591328227883731, 0.0888868556875028, -0.000277685809028307),
@@ -485,6 +491,8 @@ TEST_CASE("Actual VF Collision", "[!benchmark][ccd][rigid_toi][face_vertex]")
         Eigen::Vector3d(1.21919966781284, -1.19787487380512, 1.19585545343065)
     );
     // clang-format on
+    bodyA.vertices(bodyA_vertices);
+    bodyB.vertices(bodyB_vertices);
 
     BENCHMARK("Actually VF Collision")
     {
@@ -519,11 +527,11 @@ TEST_CASE(
     SECTION("0")
     {
         // clang-format off
-        bodyA.vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
-        bodyA.vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
 
-        bodyB.vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
-        bodyB.vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
 
         bodyA_pose_t0 = Pose<double>(
             Eigen::Vector3d(-0.749789935368566, 1.00585262304029, 1.37760763963751e-05),
@@ -547,11 +555,11 @@ TEST_CASE(
     SECTION("1")
     {
         // clang-format off
-        bodyA.vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
-        bodyA.vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(0) << 1.25, 0.625, -1.11022302462516e-16;
+        bodyA_vertices.row(1) << 1.25, -0.625, -1.11022302462516e-16;
 
-        bodyB.vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
-        bodyB.vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(0) << 1.25, 0.625, 1.11022302462516e-16;
+        bodyB_vertices.row(1) << 1.25, -0.625, 1.11022302462516e-16;
 
         bodyA_pose_t0 = Pose<double>(
             Eigen::Vector3d(-0.749781303981602, 1.00328869329824, 1.45053758187115e-05),
@@ -577,6 +585,8 @@ TEST_CASE(
         // clang-format on
         earliest_toi = 0.57421;
     }
+    bodyA.vertices(bodyA_vertices);
+    bodyB.vertices(bodyB_vertices);
 
     // print_EE_obj(
     //     bodyA, bodyA_pose_t0, bodyA_pose_t1, /*edgeA_id=*/0, //
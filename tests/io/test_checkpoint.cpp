@@ -0,0 +1,252 @@
+#include <catch2/catch.hpp>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <SimState.hpp>
+#include <io/checkpoint.hpp>
+#include <io/trajectory.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// Expose the background checkpoint writer
+class CheckpointSimState : public SimState {
+public:
+    void wait_checkpoints() { checkpoint_writer.wait(); }
+};
+
+} // namespace
+
+TEST_CASE("Checkpoint buffer", "[io][checkpoint]")
+{
+    const int dim = GENERATE(2, 3);
+    PoseD pose(
+        VectorMax3d::Random(dim), VectorMax3d::Random(dim == 2 ? 1 : 3));
+    Eigen::Matrix3d Q = Eigen::Matrix3d::Random();
+    Eigen::MatrixXd M = Eigen::MatrixXd::Random(4, dim);
+
+    CheckpointBuffer buffer;
+    buffer.write_value<int32_t>(dim);
+    buffer.write_pose(pose);
+    buffer.write_matrix(Q);
+    buffer.write_matrix(M);
+    buffer.write_string("trajectory.traj");
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_checkpoint.ckpt").string();
+    {
+        CheckpointWriter writer;
+        writer.write(filename, std::move(buffer));
+        writer.wait();
+    }
+
+    CheckpointBuffer loaded;
+    REQUIRE(loaded.load(filename));
+    CHECK(loaded.read_value<int32_t>() == dim);
+    PoseD loaded_pose;
+    loaded.read_pose(loaded_pose);
+    CHECK(loaded_pose.position == pose.position);
+    CHECK(loaded_pose.rotation == pose.rotation);
+    Eigen::Matrix3d loaded_Q;
+    loaded.read_matrix(loaded_Q);
+    CHECK(loaded_Q == Q);
+    Eigen::MatrixXd loaded_M;
+    loaded.read_matrix(loaded_M);
+    CHECK(loaded_M == M);
+    CHECK(loaded.read_string() == "trajectory.traj");
+    CHECK(loaded.good());
+
+    // Reading past the end fails without throwing
+    loaded.read_value<double>();
+    CHECK(!loaded.good());
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Checkpoint matrix size mismatch", "[io][checkpoint]")
+{
+    CheckpointBuffer buffer;
+    buffer.write_matrix(Eigen::MatrixXd::Zero(4, 4));
+
+    Eigen::Matrix3d Q;
+    buffer.read_matrix(Q);
+    CHECK(!buffer.good());
+}
+
+TEST_CASE("Checkpoint waits for the trajectory", "[io][checkpoint]")
+{
+    const size_t num_bodies = 2;
+    const size_t frame_size = num_bodies * trajectory::record_size(2);
+    const Eigen::VectorXd record = Eigen::VectorXd::Random(frame_size);
+
+    const fs::path dir = fs::temp_directory_path();
+    const std::string trajectory_filename =
+        (dir / "rigid_ipc_test_checkpoint.traj").string();
+    const std::string filename =
+        (dir / "rigid_ipc_test_checkpoint.ckpt").string();
+    fs::remove(filename);
+
+    const size_t max_pending_chunks = GENERATE(0, 2);
+    TrajectoryWriter trajectory_writer;
+    REQUIRE(trajectory_writer.open(
+        trajectory_filename, 2, num_bodies, 0.01,
+        3 * frame_size * sizeof(double), max_pending_chunks));
+    trajectory_writer.append(record.data());
+    trajectory_writer.append(record.data());
+
+    CheckpointWriter writer;
+    CheckpointBuffer buffer;
+    buffer.write_value<uint64_t>(2);
+    writer.write(filename, std::move(buffer), [&]() {
+        return trajectory_writer.wait_durable(2);
+    });
+
+    // The checkpoint is saved once its chunk of states is written
+    CHECK(!fs::exists(filename));
+    trajectory_writer.append(record.data());
+    writer.wait();
+    CHECK(fs::exists(filename));
+    fs::remove(filename);
+
+    // Submitting the short chunk writes the states without closing
+    CHECK(trajectory_writer.num_durable_frames() == 3);
+    trajectory_writer.append(record.data());
+    writer.write(filename, CheckpointBuffer(), [&]() {
+        return trajectory_writer.wait_durable(4);
+    });
+    trajectory_writer.submit_chunk();
+    writer.wait();
+    CHECK(trajectory_writer.num_durable_frames() == 4);
+    CHECK(fs::exists(filename));
+    fs::remove(filename);
+
+    // Checkpoints of states that are never written are dropped
+    writer.write(filename, CheckpointBuffer(), [&]() {
+        return trajectory_writer.wait_durable(10);
+    });
+    trajectory_writer.close();
+    writer.wait();
+    CHECK(!fs::exists(filename));
+
+    fs::remove(trajectory_filename);
+}
+
+TEST_CASE("Restart from a checkpoint", "[io][checkpoint]")
+{
+    using namespace nlohmann;
+    // A spinning square falling freely (small chunks so the checkpoint is
+    // in the middle of one)
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "output": {"chunk_size": 256, "max_pending_chunks": 2},
+        "rigid_body_problem": {
+            "gravity": [0, -9.81],
+            "rigid_bodies": [{
+                "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "linear_velocity": [1, 0],
+                "angular_velocity": [1]
+            }]
+        }
+    })"_json;
+    const int num_steps = 6, checkpoint_step = 3;
+
+    const fs::path dir =
+        fs::temp_directory_path() / "rigid_ipc_test_restart";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string trajectory_filename = (dir / "sim.traj").string();
+    const std::string filename = (dir / "sim-chkpt.ckpt").string();
+
+    std::vector<PosesD> poses;
+    {
+        SimState sim;
+        REQUIRE(sim.init(scene));
+        REQUIRE(sim.open_trajectory(trajectory_filename));
+        for (int i = 0; i < num_steps; i++) {
+            sim.simulation_step();
+            sim.save_simulation_step();
+            if (i + 1 == checkpoint_step) {
+                REQUIRE(sim.save_checkpoint(filename));
+            }
+        }
+        for (size_t i = 0; i < sim.num_states(); i++) {
+            poses.push_back(sim.get_poses(i));
+        }
+    } // Closing the trajectory writes the checkpoint
+    REQUIRE(fs::exists(filename));
+
+    {
+        SimState sim;
+        REQUIRE(sim.init(scene));
+        REQUIRE(sim.load_checkpoint(filename));
+        CHECK(sim.m_num_simulation_steps == checkpoint_step);
+        CHECK(sim.num_states() == checkpoint_step + 1);
+
+        // The restarted simulation continues the same trajectory file
+        REQUIRE(sim.open_trajectory(trajectory_filename));
+        for (int i = checkpoint_step; i < num_steps; i++) {
+            sim.simulation_step();
+            sim.save_simulation_step();
+        }
+        REQUIRE(sim.num_states() == poses.size());
+        for (size_t i = 0; i < poses.size(); i++) {
+            const PosesD restarted_poses = sim.get_poses(i);
+            REQUIRE(restarted_poses.size() == poses[i].size());
+            for (size_t j = 0; j < poses[i].size(); j++) {
+                CHECK(
+                    (restarted_poses[j].position - poses[i][j].position).norm()
+                    == Approx(0).margin(1e-10));
+                CHECK(
+                    (restarted_poses[j].rotation - poses[i][j].rotation).norm()
+                    == Approx(0).margin(1e-10));
+            }
+        }
+    }
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Checkpoint before closing the trajectory", "[io][checkpoint]")
+{
+    // A small scene whose states fit in the default 4 MiB chunks
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "rigid_body_problem": {
+            "gravity": [0, -9.81],
+            "rigid_bodies": [{
+                "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "linear_velocity": [1, 0]
+            }]
+        }
+    })"_json;
+
+    const fs::path dir =
+        fs::temp_directory_path() / "rigid_ipc_test_checkpoint_open";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string filename = (dir / "sim-chkpt.ckpt").string();
+
+    {
+        CheckpointSimState sim;
+        REQUIRE(sim.init(scene));
+        REQUIRE(sim.open_trajectory((dir / "sim.traj").string()));
+        for (int i = 0; i < 3; i++) {
+            sim.simulation_step();
+            sim.save_simulation_step();
+        }
+        REQUIRE(sim.save_checkpoint(filename));
+
+        // The checkpoint is on disk while the simulation is still running
+        sim.wait_checkpoints();
+        CHECK(fs::exists(filename));
+
+        CheckpointSimState restarted;
+        REQUIRE(restarted.init(scene));
+        REQUIRE(restarted.load_checkpoint(filename));
+        CHECK(restarted.m_num_simulation_steps == 3);
+    }
+    fs::remove_all(dir);
+}
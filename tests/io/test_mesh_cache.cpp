@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+
+#include <ghc/fs_std.hpp> // filesystem
+#include <tbb/parallel_for.h>
+
+#include <io/checkpoint.hpp>
+#include <io/mesh_cache.hpp>
+#include <io/read_rb_scene.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Rigid body geometry round trip", "[io][mesh_cache]")
+{
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    RigidBodyGeometry geometry(V, E, F);
+
+    CheckpointBuffer buffer;
+    geometry.write(buffer);
+    std::shared_ptr<RigidBodyGeometry> loaded =
+        RigidBodyGeometry::read(buffer);
+    REQUIRE(loaded != nullptr);
+
+    CHECK(loaded->vertices == geometry.vertices);
+    CHECK(loaded->edges == geometry.edges);
+    CHECK(loaded->faces == geometry.faces);
+    CHECK(
+        loaded->mesh_selector.face_to_edges()
+        == geometry.mesh_selector.face_to_edges());
+    CHECK(
+        loaded->mesh_selector.codim_edges_to_edges()
+        == geometry.mesh_selector.codim_edges_to_edges());
+    CHECK(loaded->center_of_mass == geometry.center_of_mass);
+    CHECK(loaded->volume == geometry.volume);
+    CHECK(loaded->moment_of_inertia == geometry.moment_of_inertia);
+    CHECK(loaded->R0 == geometry.R0);
+    CHECK(loaded->r_max == geometry.r_max);
+
+    // A truncated buffer is rejected
+    CheckpointBuffer truncated;
+    truncated.write_matrix(V);
+    CHECK(RigidBodyGeometry::read(truncated) == nullptr);
+}
+
+TEST_CASE("Scene with mesh cache", "[io][mesh_cache]")
+{
+    fs::path cache_dir = fs::temp_directory_path() / "rigid_ipc_mesh_cache";
+    fs::remove_all(cache_dir);
+
+    nlohmann::json scene = R"({"rigid_bodies": [
+             {"mesh": "cube.obj", "position": [0, 0, 0]},
+             {"mesh": "cube.obj", "position": [2, 0, 0], "scale": 2},
+             {"mesh": "2cubes.obj", "split_components": true}
+           ]})"_json;
+    scene["mesh_cache"] = cache_dir.string();
+
+    std::vector<RigidBody> expected_rbs;
+    REQUIRE(read_rb_scene(scene, expected_rbs));
+    // Two meshes and three processed geometries
+    CHECK(std::distance(
+              fs::directory_iterator(cache_dir), fs::directory_iterator())
+          == 5);
+
+    std::vector<RigidBody> rbs;
+    REQUIRE(read_rb_scene(scene, rbs));
+    REQUIRE(rbs.size() == expected_rbs.size());
+    for (size_t i = 0; i < rbs.size(); i++) {
+        CHECK(rbs[i].name == expected_rbs[i].name);
+        CHECK(rbs[i].vertices() == expected_rbs[i].vertices());
+        CHECK(rbs[i].faces() == expected_rbs[i].faces());
+        CHECK(rbs[i].mass == expected_rbs[i].mass);
+        CHECK(rbs[i].pose.position == expected_rbs[i].pose.position);
+        CHECK(rbs[i].pose.rotation == expected_rbs[i].pose.rotation);
+    }
+
+    fs::remove_all(cache_dir);
+}
+
+TEST_CASE("Mesh cache entries", "[io][mesh_cache]")
+{
+    fs::path cache_dir = fs::temp_directory_path() / "rigid_ipc_mesh_entries";
+    fs::remove_all(cache_dir);
+    MeshCache cache(cache_dir.string());
+    REQUIRE(cache.enabled());
+
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    const uint64_t key = 0x1234;
+
+    // Concurrent writers of the same entry each use their own temporary file
+    tbb::parallel_for(0, 16, [&](int) { cache.save_mesh(key, V, E, F); });
+    CHECK(std::distance(
+              fs::directory_iterator(cache_dir), fs::directory_iterator())
+          == 1);
+
+    Eigen::MatrixXd loaded_V;
+    Eigen::MatrixXi loaded_E, loaded_F;
+    REQUIRE(cache.load_mesh(key, loaded_V, loaded_E, loaded_F));
+    CHECK(loaded_V == V);
+    CHECK(loaded_E == E);
+    CHECK(loaded_F == F);
+    CHECK(!cache.load_mesh(key + 1, loaded_V, loaded_E, loaded_F));
+
+    const fs::path entry = fs::directory_iterator(cache_dir)->path();
+    const uintmax_t size = fs::file_size(entry);
+    SECTION("Corrupted")
+    {
+        std::fstream file(
+            entry.string(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(size - 1);
+        file.put(char(0xFF));
+    }
+    SECTION("Truncated") { fs::resize_file(entry, size - 8); }
+    SECTION("Extended")
+    {
+        std::ofstream file(entry.string(), std::ios::binary | std::ios::app);
+        file.put(0);
+    }
+    CHECK(!cache.load_mesh(key, loaded_V, loaded_E, loaded_F));
+
+    // Saving again replaces the bad entry
+    cache.save_mesh(key, V, E, F);
+    REQUIRE(cache.load_mesh(key, loaded_V, loaded_E, loaded_F));
+    CHECK(loaded_V == V);
+
+    fs::remove_all(cache_dir);
+}
@@ -48,7 +48,7 @@ TEST_CASE("Read 2D RB Scene", "[io][json][rigid-body]")
 
     Eigen::MatrixXi edges(6, 2);
     edges << 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 0;
-    CHECK((edges - rbs[0].edges).squaredNorm() == Approx(0.0).margin(1e-12));
+    CHECK((edges - rbs[0].edges()).squaredNorm() == Approx(0.0).margin(1e-12));
 
     Eigen::Vector3d velocity(3);
     velocity << 0, 0, 0;
@@ -58,3 +58,51 @@ TEST_CASE("Read 2D RB Scene", "[io][json][rigid-body]")
 }
 
 // TODO: Test reading 3D RB scenes
+
+TEST_CASE("Instances share geometry", "[io][json][rigid-body]")
+{
+    std::vector<ipc::rigid::RigidBody> rbs;
+    using namespace nlohmann;
+    auto j = R"({"rigid_bodies": [
+             {"mesh": "cube.obj", "position": [0, 0, 0]},
+             {"mesh": "cube.obj", "position": [2, 0, 0]},
+             {"mesh": "cube.obj", "position": [4, 0, 0], "scale": 2},
+             {"mesh": "cube.obj", "position": [6, 0, 0], "type": "static"}
+           ]})"_json;
+
+    REQUIRE(ipc::rigid::read_rb_scene(j, rbs));
+    REQUIRE(rbs.size() == 4);
+
+    CHECK(rbs[0].geometry == rbs[1].geometry);
+    CHECK(rbs[0].geometry != rbs[2].geometry);
+    CHECK(rbs[0].geometry == rbs[3].geometry);
+    CHECK(rbs[0].group_id != rbs[1].group_id);
+    CHECK(rbs[1].pose.position.x() == Approx(2));
+    CHECK(rbs[2].mass == Approx(8 * rbs[0].mass));
+}
+
+TEST_CASE("Scene body order", "[io][json][rigid-body]")
+{
+    std::vector<ipc::rigid::RigidBody> rbs;
+    using namespace nlohmann;
+    auto j = R"({"rigid_bodies": [
+             {"mesh": "cube.obj", "position": [0, 0, 0]},
+             {"mesh": "2cubes.obj", "split_components": true},
+             {"mesh": "cube.obj", "position": [2, 0, 0], "enabled": false},
+             {"mesh": "cube.obj", "position": [4, 0, 0], "group_id": 0},
+             {"mesh": "2cubes.obj", "split_components": true}
+           ]})"_json;
+
+    REQUIRE(ipc::rigid::read_rb_scene(j, rbs));
+    REQUIRE(rbs.size() == 6);
+
+    CHECK(rbs[0].name == "cube");
+    CHECK(rbs[1].name == "2cubes-part000");
+    CHECK(rbs[2].name == "2cubes-part001");
+    CHECK(rbs[3].name == "cube");
+    CHECK(rbs[3].pose.position.x() == Approx(4));
+    CHECK(rbs[3].group_id == 0);
+    CHECK(rbs[4].geometry == rbs[1].geometry);
+    CHECK(rbs[5].geometry == rbs[2].geometry);
+    CHECK(rbs[1].geometry != rbs[2].geometry);
+}
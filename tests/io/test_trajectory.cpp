@@ -0,0 +1,350 @@
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/trajectory.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Binary trajectory", "[io][trajectory]")
+{
+    const int dim = GENERATE(2, 3);
+    const size_t num_bodies = 3, num_frames = 10;
+    const size_t frame_size = num_bodies * trajectory::record_size(dim);
+
+    Eigen::MatrixXd records = Eigen::MatrixXd::Random(frame_size, num_frames);
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_trajectory.bin").string();
+
+    // Small chunks to test frames spanning multiple chunks
+    const size_t chunk_bytes = 3 * frame_size * sizeof(double);
+
+    // Write the chunks on the calling thread or on the I/O thread
+    const size_t max_pending_chunks = GENERATE(0, 2);
+
+    TrajectoryWriter writer;
+    REQUIRE(writer.open(
+        filename, dim, num_bodies, 0.01, chunk_bytes, max_pending_chunks));
+    for (size_t i = 0; i < num_frames; i++) {
+        writer.append(records.col(i).data());
+    }
+    CHECK(writer.num_frames() == num_frames);
+
+    // Unclosed trajectories are read without the index
+    bool close_writer = GENERATE(false, true);
+    if (close_writer) {
+        writer.close();
+    } else {
+        writer.flush();
+    }
+
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    CHECK(reader.dim() == dim);
+    CHECK(reader.num_bodies() == num_bodies);
+    CHECK(reader.timestep() == 0.01);
+    REQUIRE(reader.num_frames() == num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        CHECK(
+            Eigen::Map<const Eigen::VectorXd>(reader.frame(i), frame_size)
+            == records.col(i));
+    }
+
+    // Round trip through the JSON state
+    std::vector<nlohmann::json> state_sequence;
+    for (size_t i = 0; i < num_frames; i++) {
+        state_sequence.push_back(reader.state(i));
+    }
+    PosesD poses = reader.poses(num_frames - 1);
+
+    TrajectoryReader json_reader;
+    REQUIRE(json_reader.open(state_sequence, 0.01));
+    CHECK(json_reader.dim() == dim);
+    CHECK(json_reader.num_bodies() == num_bodies);
+    REQUIRE(json_reader.num_frames() == num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        CHECK(
+            Eigen::Map<const Eigen::VectorXd>(json_reader.frame(i), frame_size)
+            == records.col(i));
+    }
+    PosesD json_poses = json_reader.poses(num_frames - 1);
+    REQUIRE(json_poses.size() == num_bodies);
+    for (size_t i = 0; i < num_bodies; i++) {
+        CHECK(json_poses[i].position == poses[i].position);
+        CHECK(json_poses[i].rotation == poses[i].rotation);
+    }
+
+    reader.close();
+    writer.close();
+    fs::remove(filename);
+}
+
+TEST_CASE("Durable trajectory frames", "[io][trajectory]")
+{
+    const size_t num_bodies = 2;
+    const size_t frame_size = num_bodies * trajectory::record_size(2);
+    const Eigen::VectorXd record = Eigen::VectorXd::Random(frame_size);
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_durable.bin").string();
+
+    const size_t max_pending_chunks = GENERATE(0, 2);
+
+    TrajectoryWriter writer;
+    REQUIRE(writer.open(
+        filename, 2, num_bodies, 0.01, 3 * frame_size * sizeof(double),
+        max_pending_chunks));
+
+    // Frames are only written once their chunk is full
+    writer.append(record.data());
+    writer.append(record.data());
+    CHECK(writer.num_durable_frames() == 0);
+
+    // Wait on another thread like the checkpoints do
+    std::thread waiter([&] { CHECK(writer.wait_durable(3)); });
+    writer.append(record.data());
+    waiter.join();
+    CHECK(writer.num_durable_frames() == 3);
+
+    writer.append(record.data());
+    writer.flush();
+    CHECK(writer.num_durable_frames() == 4);
+
+    // Closing wakes up waiters on frames that are never appended
+    waiter = std::thread([&] { CHECK(!writer.wait_durable(10)); });
+    writer.close();
+    waiter.join();
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Reopen a trajectory", "[io][trajectory]")
+{
+    const size_t num_bodies = 2, num_frames = 10;
+    const size_t frame_size = num_bodies * trajectory::record_size(2);
+    const size_t chunk_bytes = 3 * frame_size * sizeof(double);
+
+    Eigen::MatrixXd records = Eigen::MatrixXd::Random(frame_size, num_frames);
+    Eigen::MatrixXd new_records =
+        Eigen::MatrixXd::Random(frame_size, num_frames);
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_reopen.bin").string();
+
+    // Keep whole chunks or end in the middle of one
+    const size_t num_kept_frames = GENERATE(0, 3, 5);
+    const size_t max_pending_chunks = GENERATE(0, 2);
+
+    TrajectoryWriter writer;
+    REQUIRE(writer.open(
+        filename, 2, num_bodies, 0.01, chunk_bytes, max_pending_chunks));
+    for (size_t i = 0; i < num_frames; i++) {
+        writer.append(records.col(i).data());
+    }
+    writer.close();
+
+    size_t chunks_offset;
+    {
+        TrajectoryReader reader;
+        REQUIRE(reader.open(filename));
+        chunks_offset = reader.chunks_offset();
+    }
+
+    // The later frames and the index are dropped
+    REQUIRE(writer.reopen(
+        filename, num_kept_frames, chunk_bytes, max_pending_chunks));
+    CHECK(writer.num_frames() == num_kept_frames);
+    CHECK(writer.num_durable_frames() == num_kept_frames);
+    CHECK(
+        fs::file_size(filename)
+        == chunks_offset
+            + (num_kept_frames + 2) / 3 * sizeof(trajectory::Chunk)
+            + num_kept_frames * frame_size * sizeof(double));
+
+    for (size_t i = num_kept_frames; i < num_frames; i++) {
+        writer.append(new_records.col(i).data());
+    }
+    writer.close();
+
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    REQUIRE(reader.num_frames() == num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+        CHECK(
+            Eigen::Map<const Eigen::VectorXd>(reader.frame(i), frame_size)
+            == (i < num_kept_frames ? records : new_records).col(i));
+    }
+    reader.close();
+
+    // Frames past the end of the trajectory cannot be kept
+    CHECK(!writer.reopen(filename, num_frames + 1));
+    CHECK(!writer.is_open());
+
+    fs::remove(filename);
+}
+
+TEST_CASE("Trajectory mesh table", "[io][trajectory]")
+{
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    auto geometry = std::make_shared<const RigidBodyGeometry>(V, E, F);
+
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < 3; i++) {
+        PoseD pose = PoseD::Zero(3);
+        pose.position.x() = 2 * i;
+        rbs.emplace_back(
+            geometry, pose, PoseD::Zero(3), PoseD::Zero(3), 1.0,
+            VectorMax6b::Zero(6), /*oriented=*/false, /*group_id=*/i,
+            i == 0 ? RigidBodyType::STATIC : RigidBodyType::DYNAMIC);
+        rbs.back().name = "tet" + std::to_string(i);
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_trajectory.traj")
+            .string();
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(filename, bodies, 0.01));
+        writer.append(bodies);
+    }
+
+    TrajectoryReader reader;
+    REQUIRE(reader.open(filename));
+    REQUIRE(reader.has_meshes());
+    REQUIRE(reader.num_frames() == 1);
+    // The mesh table is padded so the records are aligned
+    CHECK(reader.chunks_offset() % alignof(double) == 0);
+    CHECK(reinterpret_cast<uintptr_t>(reader.frame(0)) % alignof(double) == 0);
+
+    std::vector<RigidBody> loaded;
+    REQUIRE(reader.bodies(loaded));
+    REQUIRE(loaded.size() == rbs.size());
+    for (size_t i = 0; i < rbs.size(); i++) {
+        CHECK(loaded[i].name == bodies[i].name);
+        CHECK(loaded[i].type == bodies[i].type);
+        CHECK(loaded[i].group_id == bodies[i].group_id);
+        CHECK(loaded[i].vertices() == bodies[i].vertices());
+        CHECK(loaded[i].faces() == bodies[i].faces());
+        CHECK(loaded[i].pose.position == bodies[i].pose.position);
+        CHECK(loaded[i].pose.rotation == bodies[i].pose.rotation);
+        // Instances still share a single geometry
+        CHECK(loaded[i].geometry == loaded[0].geometry);
+    }
+
+    // Trajectories written without the bodies have an empty mesh table
+    reader.close();
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(filename, 3, rbs.size(), 0.01));
+        writer.append(bodies);
+    }
+    REQUIRE(reader.open(filename));
+    CHECK(!reader.has_meshes());
+    CHECK(!reader.bodies(loaded));
+    CHECK(reader.num_frames() == 1);
+
+    // Trajectories without a mesh table (version 1) are not read
+    reader.close();
+    {
+        std::fstream file(
+            filename, std::ios::binary | std::ios::in | std::ios::out);
+        const uint32_t version = 1;
+        file.seekp(offsetof(trajectory::Header, version));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    CHECK(!reader.open(filename));
+
+    reader.close();
+    fs::remove(filename);
+}
+
+TEST_CASE("Misaligned trajectory chunks", "[io][trajectory]")
+{
+    const size_t num_bodies = 2;
+    const size_t frame_size = num_bodies * trajectory::record_size(3);
+    const Eigen::VectorXd record = Eigen::VectorXd::Random(frame_size);
+
+    const std::string filename =
+        (fs::temp_directory_path() / "rigid_ipc_test_trajectory.traj")
+            .string();
+    {
+        TrajectoryWriter writer;
+        REQUIRE(writer.open(
+            filename, 3, num_bodies, 0.01, 2 * frame_size * sizeof(double)));
+        for (int i = 0; i < 5; i++) {
+            writer.append(record.data());
+        }
+    }
+
+    std::string data;
+    {
+        std::ifstream file(filename, std::ios::binary);
+        data.assign(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+    }
+
+    // Grow the mesh table and shift the chunks after it
+    const size_t shift = GENERATE(4, 8);
+    trajectory::MeshTable table;
+    const size_t table_offset = sizeof(trajectory::Header);
+    std::memcpy(&table, &data[table_offset], sizeof(table));
+    const size_t chunks_offset = table_offset + sizeof(table) + table.size;
+    table.size += shift;
+    std::memcpy(&data[table_offset], &table, sizeof(table));
+    data.insert(chunks_offset, shift, '\0');
+
+    trajectory::Footer footer;
+    std::memcpy(&footer, &data[data.size() - sizeof(footer)], sizeof(footer));
+    REQUIRE(footer.num_chunks == 3);
+    footer.index_offset += shift;
+    for (size_t i = 0; i < footer.num_chunks; i++) {
+        const size_t index_entry =
+            footer.index_offset + i * sizeof(trajectory::Chunk);
+        trajectory::Chunk chunk;
+        std::memcpy(&chunk, &data[index_entry], sizeof(chunk));
+        chunk.offset += shift;
+        std::memcpy(&data[index_entry], &chunk, sizeof(chunk));
+        std::memcpy(&data[chunk.offset], &chunk, sizeof(chunk));
+    }
+    std::memcpy(&data[data.size() - sizeof(footer)], &footer, sizeof(footer));
+
+    // Whether the chunks come from the index or from a scan
+    const bool has_index = GENERATE(true, false);
+    if (!has_index) {
+        data.resize(footer.index_offset);
+    }
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    TrajectoryReader reader;
+    if (shift % alignof(double) == 0) {
+        REQUIRE(reader.open(filename));
+        REQUIRE(reader.num_frames() == 5);
+        CHECK(
+            Eigen::Map<const Eigen::VectorXd>(reader.frame(4), frame_size)
+            == record);
+        reader.close();
+    } else {
+        CHECK(!reader.open(filename));
+    }
+
+    fs::remove(filename);
+}
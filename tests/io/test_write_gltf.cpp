@@ -0,0 +1,300 @@
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <Eigen/Geometry>
+#include <ghc/fs_std.hpp> // filesystem
+#include <nlohmann/json.hpp>
+
+#include <io/write_gltf.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+std::string read_file(const fs::path& path)
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+template <typename T> T read_value(const std::string& data, size_t offset)
+{
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+/// Decoded values of a glTF accessor (one row per element)
+Eigen::MatrixXd read_accessor(
+    const nlohmann::json& gltf, const std::string& buffer, int accessor_id)
+{
+    const nlohmann::json& accessor = gltf["accessors"][accessor_id];
+    const nlohmann::json& view =
+        gltf["bufferViews"][accessor["bufferView"].get<int>()];
+    const std::string type = accessor["type"];
+    const int cols = type == "SCALAR" ? 1 : (type == "VEC3" ? 3 : 4);
+    const size_t count = accessor["count"];
+    const size_t offset = view["byteOffset"];
+
+    Eigen::MatrixXd values(count, cols);
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < cols; j++) {
+            const size_t k = i * cols + j;
+            switch (accessor["componentType"].get<int>()) {
+            case 5126: // FLOAT
+                values(i, j) = read_value<float>(buffer, offset + 4 * k);
+                break;
+            case 5122: // SHORT
+                REQUIRE(accessor.value("normalized", false));
+                values(i, j) = std::max(
+                    read_value<int16_t>(buffer, offset + 2 * k) / 32767.0,
+                    -1.0);
+                break;
+            default:
+                FAIL("Unexpected component type");
+            }
+        }
+    }
+    return values;
+}
+
+/// Check that the views and accessors match the buffer
+void check_buffer(const nlohmann::json& gltf, const std::string& buffer)
+{
+    REQUIRE(gltf["buffers"].size() == 1);
+    const size_t byte_length = gltf["buffers"][0]["byteLength"];
+    CHECK(buffer.size() == byte_length);
+
+    // The views are packed in order
+    size_t offset = 0;
+    for (const nlohmann::json& view : gltf["bufferViews"]) {
+        CHECK(view["buffer"] == 0);
+        CHECK(view["byteOffset"] == offset);
+        CHECK(view["byteOffset"].get<size_t>() % 4 == 0);
+        offset += view["byteLength"].get<size_t>();
+    }
+    CHECK(offset == byte_length);
+
+    for (const nlohmann::json& accessor : gltf["accessors"]) {
+        const nlohmann::json& view =
+            gltf["bufferViews"][accessor["bufferView"].get<int>()];
+        const std::string type = accessor["type"];
+        const size_t num_components =
+            type == "SCALAR" ? 1 : (type == "VEC3" ? 3 : 4);
+        const size_t component_size =
+            accessor["componentType"] == 5122 ? 2 : 4;
+        CHECK(
+            view["byteLength"]
+            == accessor["count"].get<size_t>() * num_components
+                * component_size);
+    }
+}
+
+} // namespace
+
+TEST_CASE("glTF animation", "[io][write_gltf]")
+{
+    // A tetrahedron shared by three bodies and a unique one
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    auto tet = std::make_shared<const RigidBodyGeometry>(V, E, F);
+    Eigen::MatrixXd V_other(4, 3);
+    V_other << 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 1;
+    auto other = std::make_shared<const RigidBodyGeometry>(V_other, E, F);
+
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < 4; i++) {
+        rbs.emplace_back(
+            i < 3 ? tet : other, PoseD::Zero(3), PoseD::Zero(3),
+            PoseD::Zero(3), 1.0, VectorMax6b::Zero(6), /*oriented=*/false,
+            /*group_id=*/i);
+        rbs.back().name = "body" + std::to_string(i);
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+    REQUIRE(bodies.num_bodies() == rbs.size());
+
+    // Static, uniform motion, falling and tumbling, and noisy
+    const size_t num_frames = 120;
+    const double timestep = 0.01;
+    std::vector<PosesD> poses(num_frames);
+    for (size_t j = 0; j < num_frames; j++) {
+        const double t = j * timestep;
+        poses[j].emplace_back(
+            Eigen::Vector3d(1, 2, 3), Eigen::Vector3d(0.1, 0.2, 0.3));
+        poses[j].emplace_back(
+            Eigen::Vector3d(t, 0, 0), Eigen::Vector3d(0, 0, 0.5 * t));
+        poses[j].emplace_back(
+            Eigen::Vector3d(0, -4.9 * t * t, 0),
+            Eigen::Vector3d(3 * t, std::sin(5 * t), 0));
+        poses[j].emplace_back(
+            Eigen::Vector3d::Random(), Eigen::Vector3d::Random());
+    }
+
+    GLTFOptions options;
+    options.translation_tolerance = GENERATE(0.0, 1e-3, 1e-2);
+    options.rotation_tolerance = options.translation_tolerance;
+    options.quantize_rotations = GENERATE(false, true);
+    const bool is_binary = GENERATE(true, false);
+    CAPTURE(
+        options.translation_tolerance, options.quantize_rotations, is_binary);
+
+    const fs::path dir = fs::temp_directory_path() / "rigid_ipc_test_gltf";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const fs::path path = dir / (is_binary ? "sim.glb" : "sim.gltf");
+    REQUIRE(write_gltf(path.string(), bodies, poses, timestep, options));
+
+    nlohmann::json gltf;
+    std::string buffer;
+    if (is_binary) {
+        const std::string data = read_file(path);
+        REQUIRE(data.size() >= 20);
+        CHECK(read_value<uint32_t>(data, 0) == 0x46546C67); // "glTF"
+        CHECK(read_value<uint32_t>(data, 4) == 2);
+        CHECK(read_value<uint32_t>(data, 8) == data.size());
+
+        const uint32_t json_length = read_value<uint32_t>(data, 12);
+        CHECK(json_length % 4 == 0);
+        CHECK(read_value<uint32_t>(data, 16) == 0x4E4F534A); // "JSON"
+        REQUIRE(20 + json_length + 8 <= data.size());
+        gltf = nlohmann::json::parse(data.substr(20, json_length));
+
+        const size_t bin_offset = 20 + json_length;
+        const uint32_t bin_length = read_value<uint32_t>(data, bin_offset);
+        CHECK(read_value<uint32_t>(data, bin_offset + 4) == 0x004E4942);
+        CHECK(bin_offset + 8 + bin_length == data.size());
+        CHECK(!gltf["buffers"][0].contains("uri"));
+        buffer = data.substr(bin_offset + 8);
+    } else {
+        gltf = nlohmann::json::parse(read_file(path));
+        REQUIRE(gltf["buffers"][0]["uri"] == "sim.bin");
+        buffer = read_file(dir / "sim.bin");
+    }
+    CHECK(gltf["asset"]["version"] == "2.0");
+    check_buffer(gltf, buffer);
+
+    // One mesh per unique geometry
+    REQUIRE(gltf["meshes"].size() == 2);
+    for (const nlohmann::json& mesh : gltf["meshes"]) {
+        const nlohmann::json& primitive = mesh["primitives"][0];
+        const int vertices = primitive["attributes"]["POSITION"];
+        const Eigen::MatrixXd& expected_V =
+            mesh["name"] == "body0" ? tet->vertices : other->vertices;
+        const Eigen::MatrixXd decoded_V =
+            read_accessor(gltf, buffer, vertices);
+        CHECK(decoded_V.isApprox(expected_V, 1e-6));
+        for (int d = 0; d < 3; d++) {
+            CHECK(
+                gltf["accessors"][vertices]["min"][d].get<double>()
+                == Approx(expected_V.col(d).minCoeff()));
+            CHECK(
+                gltf["accessors"][vertices]["max"][d].get<double>()
+                == Approx(expected_V.col(d).maxCoeff()));
+        }
+        CHECK(
+            gltf["accessors"][primitive["indices"].get<int>()]["count"]
+            == F.size());
+    }
+
+    // The keyframes reproduce every frame within the tolerances
+    REQUIRE(gltf["nodes"].size() == bodies.num_bodies());
+    std::vector<int> num_channels(bodies.num_bodies(), 0);
+    const nlohmann::json& animation = gltf["animations"][0];
+    for (const nlohmann::json& channel : animation["channels"]) {
+        const size_t body = channel["target"]["node"];
+        const bool is_rotation = channel["target"]["path"] == "rotation";
+        const nlohmann::json& sampler =
+            animation["samplers"][channel["sampler"].get<int>()];
+        CHECK(sampler["interpolation"] == "LINEAR");
+        num_channels[body]++;
+
+        const Eigen::VectorXd times =
+            read_accessor(gltf, buffer, sampler["input"].get<int>());
+        const Eigen::MatrixXd values =
+            read_accessor(gltf, buffer, sampler["output"].get<int>());
+        REQUIRE(times.size() == values.rows());
+        REQUIRE(times.size() >= 2);
+        CHECK(times(0) == 0);
+        CHECK(
+            times(times.size() - 1)
+            == Approx((num_frames - 1) * timestep));
+        const nlohmann::json& input =
+            gltf["accessors"][sampler["input"].get<int>()];
+        CHECK(input["min"][0] == times.minCoeff());
+        CHECK(input["max"][0] == times.maxCoeff());
+
+        // Frames of the keyframes
+        std::vector<size_t> keyframes;
+        for (int k = 0; k < times.size(); k++) {
+            keyframes.push_back(size_t(std::round(times(k) / timestep)));
+        }
+        CHECK(std::is_sorted(keyframes.begin(), keyframes.end()));
+
+        // Rotations are quantized to int16, so they are within half a step
+        // per component of the exact quaternions
+        const double quantization_error =
+            options.quantize_rotations ? 0.5 / 32767 : 1e-7;
+        const double float_error = 1e-5;
+
+        size_t k = 0;
+        for (size_t j = 0; j < num_frames; j++) {
+            while (keyframes[k + 1] < j) {
+                k++;
+            }
+            const double s = double(j - keyframes[k])
+                / double(keyframes[k + 1] - keyframes[k]);
+            const PoseD& pose = poses[j][body];
+            if (is_rotation) {
+                // Stored as x, y, z, w
+                Eigen::Quaterniond q0(Eigen::Vector4d(values.row(k)));
+                Eigen::Quaterniond q1(Eigen::Vector4d(values.row(k + 1)));
+                if (keyframes[k] == j) {
+                    Eigen::Vector4d expected =
+                        pose.construct_quaternion().coeffs();
+                    if (expected.dot(q0.coeffs()) < 0) {
+                        expected *= -1;
+                    }
+                    CHECK(
+                        (q0.coeffs() - expected).lpNorm<Eigen::Infinity>()
+                        <= quantization_error + 1e-7);
+                }
+                Eigen::Quaterniond q =
+                    q0.normalized().slerp(s, q1.normalized());
+                CHECK(
+                    q.angularDistance(pose.construct_quaternion())
+                    <= options.rotation_tolerance
+                        + 10 * quantization_error + float_error);
+            } else {
+                Eigen::Vector3d p = (1 - s) * values.row(k).transpose()
+                    + s * values.row(k + 1).transpose();
+                CHECK(
+                    (p - pose.position).norm()
+                    <= options.translation_tolerance + float_error);
+            }
+        }
+    }
+
+    // Only the moving bodies are animated
+    CHECK(num_channels[0] == 0);
+    for (size_t i = 1; i < bodies.num_bodies(); i++) {
+        CHECK(num_channels[i] == 2);
+    }
+    // The noisy body keeps every frame
+    CHECK(
+        gltf["accessors"][animation["samplers"].back()["output"].get<int>()]
+            ["count"]
+        == num_frames);
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+
+#include <fmt/format.h>
+#include <ghc/fs_std.hpp> // filesystem
+
+#include <io/trajectory.hpp>
+#include <io/write_obj.hpp>
+#include <physics/state_snapshot.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+static std::string read_file(const fs::path& path)
+{
+    std::ifstream file(path.string(), std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+TEST_CASE("OBJ sequence", "[io][write_obj]")
+{
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    auto geometry = std::make_shared<const RigidBodyGeometry>(V, E, F);
+
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < 3; i++) {
+        rbs.emplace_back(
+            geometry, PoseD::Zero(3), PoseD::Zero(3), PoseD::Zero(3), 1.0,
+            VectorMax6b::Zero(6), /*oriented=*/false, /*group_id=*/i);
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    const size_t num_frames = 20;
+    std::vector<nlohmann::json> state_sequence;
+    StateSnapshot snapshot;
+    snapshot.resize(3, rbs.size());
+    snapshot.linear_velocities.setZero();
+    snapshot.angular_velocities.setZero();
+    snapshot.Qdots.setZero();
+    snapshot.Qddots.setZero();
+    for (size_t i = 0; i < num_frames; i++) {
+        snapshot.positions.setRandom();
+        snapshot.rotations.setRandom();
+        state_sequence.push_back(snapshot.to_json());
+    }
+    TrajectoryReader states;
+    REQUIRE(states.open(state_sequence, 0.01));
+
+    const fs::path dir_path =
+        fs::temp_directory_path() / "rigid_ipc_test_obj_sequence";
+    fs::remove_all(dir_path);
+
+    SECTION("Baked vertices")
+    {
+        REQUIRE(write_obj_sequence(dir_path.string(), bodies, states));
+        // Frames match the serial export of their poses
+        const fs::path expected_path = dir_path / "expected.obj";
+        for (size_t i = 0; i < num_frames; i++) {
+            REQUIRE(write_obj(
+                expected_path.string(), bodies, states.poses(i)));
+            CHECK(
+                read_file(dir_path / fmt::format("{:05d}.obj", i))
+                == read_file(expected_path));
+        }
+    }
+
+    SECTION("Per-body transforms")
+    {
+        REQUIRE(write_obj_sequence(dir_path.string(), bodies, states, true));
+        for (size_t i = 0; i < rbs.size(); i++) {
+            CHECK(fs::exists(dir_path / fmt::format("body{:04d}.obj", i)));
+        }
+        for (size_t i = 0; i < num_frames; i++) {
+            std::ifstream file(
+                (dir_path / fmt::format("{:05d}.txt", i)).string());
+            REQUIRE(file.is_open());
+            std::string line;
+            std::getline(file, line); // Header
+            const PosesD poses = states.poses(i);
+            for (size_t j = 0; j < rbs.size(); j++) {
+                std::string name;
+                Eigen::Matrix4d T;
+                file >> name;
+                for (int r = 0; r < 4; r++) {
+                    for (int c = 0; c < 4; c++) {
+                        file >> T(r, c);
+                    }
+                }
+                CHECK(name == fmt::format("body{:04d}", j));
+                // The transform maps the body vertices to the world vertices
+                Eigen::MatrixXd world_vertices =
+                    (bodies[j].vertices().rowwise().homogeneous()
+                     * T.transpose())
+                        .leftCols(3);
+                CHECK(world_vertices.isApprox(
+                    bodies[j].world_vertices(poses[j])));
+            }
+        }
+    }
+
+    fs::remove_all(dir_path);
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <Eigen/Cholesky>
+
+#include <opt/body_block_hessian.hpp>
+#include <solvers/newton_cg_solver.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// Random symmetric positive definite Hessian with the given body pairs
+BodyBlockHessian random_block_hessian(
+    size_t num_bodies,
+    int ndof,
+    const std::vector<std::array<long, 2>>& body_pairs)
+{
+    BodyBlockHessian hess(num_bodies, ndof);
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (size_t b = 0; b < num_bodies; b++) {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Random(ndof, ndof);
+        Eigen::MatrixXd block = A * A.transpose()
+            + ndof * Eigen::MatrixXd::Identity(ndof, ndof);
+        for (int r = 0; r < ndof; r++) {
+            for (int c = 0; c < ndof; c++) {
+                triplets.emplace_back(
+                    b * ndof + r, b * ndof + c, block(r, c));
+            }
+        }
+    }
+    Eigen::SparseMatrix<double> diagonal(hess.size(), hess.size());
+    diagonal.setFromTriplets(triplets.begin(), triplets.end());
+    hess.add_block_diagonal(diagonal);
+
+    std::vector<BodyPairHessianBlock> blocks;
+    for (const std::array<long, 2>& body_ids : body_pairs) {
+        Eigen::MatrixXd B = Eigen::MatrixXd::Random(2 * ndof, 2 * ndof);
+        blocks.emplace_back(body_ids, B * B.transpose());
+    }
+    hess.add_pair_blocks(blocks, /*scale=*/0.5);
+
+    return hess;
+}
+
+/// Expose the PCG of the Newton-CG solver
+class PCGSolver : public NewtonCGSolver {
+public:
+    using NewtonCGSolver::dof_reduction;
+    using NewtonCGSolver::solve_free_system;
+};
+
+} // namespace
+
+TEST_CASE("Body block Hessian product", "[opt][body_block_hessian]")
+{
+    const int ndof = GENERATE(3, 6);
+    const size_t num_bodies = 5;
+
+    std::vector<std::array<long, 2>> body_pairs;
+    SECTION("No pairs") {}
+    SECTION("Pairs")
+    {
+        // Repeated pairs, both orders, and a body without contacts
+        body_pairs = { { { 0, 1 } }, { { 2, 0 } }, { { 1, 3 } },
+                       { { 0, 1 } }, { { 3, 2 } } };
+    }
+
+    BodyBlockHessian hess = random_block_hessian(num_bodies, ndof, body_pairs);
+    CHECK(hess.num_pair_blocks() == body_pairs.size());
+
+    Eigen::VectorXd x = Eigen::VectorXd::Random(hess.size());
+    Eigen::VectorXd expected = hess.assemble() * x;
+    Eigen::VectorXd y = hess * x;
+    CHECK(y.isApprox(expected));
+
+    // The product does not depend on the scheduling of the threads
+    for (int i = 0; i < 10; i++) {
+        CHECK((hess * x).cwiseEqual(y).all());
+    }
+}
+
+TEST_CASE("PCG on a body block system", "[opt][body_block_hessian][pcg]")
+{
+    const int ndof = GENERATE(3, 6);
+    const size_t num_bodies = 4;
+
+    BodyBlockHessian hess = random_block_hessian(
+        num_bodies, ndof,
+        { { { 0, 1 } }, { { 1, 2 } }, { { 2, 3 } }, { { 3, 0 } } });
+    const int n = hess.size();
+
+    Eigen::VectorXi free_dof;
+    SECTION("All free") { free_dof = Eigen::VectorXi::LinSpaced(n, 0, n - 1); }
+    SECTION("Some fixed")
+    {
+        std::vector<int> free;
+        for (int i = 0; i < n; i++) {
+            if (i % ndof != 0) {
+                free.push_back(i);
+            }
+        }
+        free_dof = Eigen::Map<Eigen::VectorXi>(free.data(), free.size());
+    }
+
+    PCGSolver solver;
+    solver.dof_reduction = DofReduction(free_dof, n);
+
+    Eigen::SparseMatrix<double> A = hess.assemble(), A_free;
+    solver.dof_reduction.reduce(A, A_free);
+    Eigen::VectorXd b = Eigen::VectorXd::Random(free_dof.size());
+    Eigen::VectorXd expected = Eigen::MatrixXd(A_free).ldlt().solve(b);
+
+    Eigen::VectorXd d;
+    int iterations = solver.solve_free_system(hess, b, 1e-12 * b.norm(), d);
+    CHECK(iterations > 0);
+    CHECK(iterations <= 2 * free_dof.size());
+    CHECK(d.isApprox(expected, 1e-8));
+}
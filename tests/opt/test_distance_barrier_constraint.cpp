@@ -1,7 +1,12 @@
 #include <catch2/catch.hpp>
 
+#include <cmath>
+
+#include <ipc/distance/edge_edge_mollifier.hpp>
+
 #include <logger.hpp>
 #include <opt/distance_barrier_constraint.hpp>
+#include <physics/rigid_body_assembler.hpp>
 
 using namespace ipc;
 using namespace ipc::rigid;
@@ -102,3 +107,185 @@ using namespace ipc::rigid;
 //         CHECK(actual_barrier[i] == Approx(expected_barrier[i]));
 //     }
 // }
+
+namespace {
+
+/// Check that two constraint sets have the same constraints in the same order
+void check_same_constraints(
+    const Constraints& actual, const Constraints& expected)
+{
+    REQUIRE(actual.vv_constraints.size() == expected.vv_constraints.size());
+    for (size_t j = 0; j < expected.vv_constraints.size(); j++) {
+        const auto& a = actual.vv_constraints[j];
+        const auto& b = expected.vv_constraints[j];
+        CHECK(a.vertex0_index == b.vertex0_index);
+        CHECK(a.vertex1_index == b.vertex1_index);
+        CHECK(a.multiplicity == b.multiplicity);
+    }
+    REQUIRE(actual.ev_constraints.size() == expected.ev_constraints.size());
+    for (size_t j = 0; j < expected.ev_constraints.size(); j++) {
+        const auto& a = actual.ev_constraints[j];
+        const auto& b = expected.ev_constraints[j];
+        CHECK(a.edge_index == b.edge_index);
+        CHECK(a.vertex_index == b.vertex_index);
+        CHECK(a.multiplicity == b.multiplicity);
+    }
+    REQUIRE(actual.ee_constraints.size() == expected.ee_constraints.size());
+    for (size_t j = 0; j < expected.ee_constraints.size(); j++) {
+        const auto& a = actual.ee_constraints[j];
+        const auto& b = expected.ee_constraints[j];
+        CHECK(a.edge0_index == b.edge0_index);
+        CHECK(a.edge1_index == b.edge1_index);
+        CHECK(a.eps_x == Approx(b.eps_x));
+    }
+    REQUIRE(actual.fv_constraints.size() == expected.fv_constraints.size());
+    for (size_t j = 0; j < expected.fv_constraints.size(); j++) {
+        const auto& a = actual.fv_constraints[j];
+        const auto& b = expected.fv_constraints[j];
+        CHECK(a.face_index == b.face_index);
+        CHECK(a.vertex_index == b.vertex_index);
+    }
+}
+
+} // namespace
+
+TEST_CASE(
+    "Incremental active set",
+    "[opt][DistanceBarrier][DistanceBarrierConstraint][active_set]")
+{
+    Eigen::MatrixXd V(4, 3);
+    V << 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    auto geometry = std::make_shared<const RigidBodyGeometry>(V, E, F);
+
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < 2; i++) {
+        rbs.emplace_back(
+            geometry, PoseD::Zero(3), PoseD::Zero(3), PoseD::Zero(3), 1.0,
+            VectorMax6b::Zero(6), /*oriented=*/false, /*group_id=*/i,
+            i == 0 ? RigidBodyType::STATIC : RigidBodyType::DYNAMIC);
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    // Only the unfiltered constraint set is built from every candidate
+    DistanceBarrierConstraint full, incremental;
+    for (DistanceBarrierConstraint* constraint : { &full, &incremental }) {
+        constraint->detection_method = DetectionMethod::BRUTE_FORCE;
+        constraint->initial_barrier_activation_distance = 0.1;
+        constraint->sort_constraints = true;
+        constraint->initialize();
+    }
+    full.candidate_skin = 0;
+    incremental.candidate_skin = GENERATE(-1.0, 0.5);
+
+    // Lower the second tet (wobbling) until its bottom face is 0.02 above the
+    // apex of the first one, with a few jumps that re-detect the candidates.
+    const int num_poses = 60;
+    int num_active_poses = 0;
+    PosesD poses(2, PoseD::Zero(3));
+    for (int i = 0; i <= num_poses; i++) {
+        const double t = i / double(num_poses);
+        poses[1].position << -0.1 + 0.02 * std::sin(20 * t),
+            -0.1 + 0.02 * std::cos(20 * t),
+            1.3 - 0.28 * t + (i % 20 == 10 ? 0.1 : 0);
+        poses[1].rotation << 0.05 * std::sin(10 * t), 0.05 * t, 0.1 * t;
+        CAPTURE(i);
+
+        const Constraints& expected =
+            *full.construct_constraint_set(bodies, poses);
+        const Constraints& actual =
+            *incremental.construct_constraint_set(bodies, poses);
+        num_active_poses += expected.size() > 0;
+
+        check_same_constraints(actual, expected);
+    }
+    // The sequence goes in and out of contact
+    CHECK(num_active_poses > 0);
+    CHECK(num_active_poses < num_poses);
+}
+
+TEST_CASE(
+    "Incremental active set with nearly parallel edges",
+    "[opt][DistanceBarrier][DistanceBarrierConstraint][active_set]")
+{
+    // A tet with a top edge along x and a bottom edge along y
+    Eigen::MatrixXd V(4, 3);
+    V << -1, 0, 1, 1, 0, 1, 0, -1, 0, 0, 1, 0;
+    Eigen::MatrixXi F(4, 3);
+    F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+    Eigen::MatrixXi E(6, 2);
+    E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    auto geometry = std::make_shared<const RigidBodyGeometry>(V, E, F);
+
+    // Pose placing the input vertices at R * v + p
+    const auto input_pose = [&](const Eigen::Matrix3d& R,
+                                const Eigen::Vector3d& p) {
+        const Eigen::AngleAxisd r(
+            Eigen::Matrix3d(R * Eigen::Matrix3d(geometry->R0)));
+        return PoseD(
+            R * Eigen::Vector3d(geometry->center_of_mass) + p,
+            r.angle() * r.axis());
+    };
+
+    std::vector<RigidBody> rbs;
+    for (int i = 0; i < 2; i++) {
+        rbs.emplace_back(
+            geometry, PoseD::Zero(3), PoseD::Zero(3), PoseD::Zero(3), 1.0,
+            VectorMax6b::Zero(6), /*oriented=*/false, /*group_id=*/i,
+            i == 0 ? RigidBodyType::STATIC : RigidBodyType::DYNAMIC);
+    }
+    RigidBodyAssembler bodies;
+    bodies.init(rbs);
+
+    DistanceBarrierConstraint full, incremental;
+    for (DistanceBarrierConstraint* constraint : { &full, &incremental }) {
+        constraint->detection_method = DetectionMethod::BRUTE_FORCE;
+        constraint->initial_barrier_activation_distance = 0.1;
+        constraint->sort_constraints = true;
+        constraint->initialize();
+    }
+    full.candidate_skin = 0;
+    incremental.candidate_skin = GENERATE(-1.0, 0.5);
+
+    // Hold the bottom edge of the second tet 0.02 above and 0.05 beside the
+    // top edge of the first one, and turn it about z so that the edges stop
+    // being mollified (sin²θ ≥ 1e-3) while their closest points stay at an
+    // endpoint (sin θ < 0.05). Only the mollifier state changes.
+    const int num_poses = 60;
+    int num_mollified = 0;
+    PosesD poses(2);
+    poses[0] = input_pose(Eigen::Matrix3d::Identity(), Eigen::Vector3d::Zero());
+    for (int i = 0; i <= num_poses; i++) {
+        const double theta = 0.02 + 0.025 * i / double(num_poses);
+        poses[1] = input_pose(
+            Eigen::AngleAxisd(M_PI / 2 + theta, Eigen::Vector3d::UnitZ())
+                .toRotationMatrix(),
+            Eigen::Vector3d(0, 0.05, 1.02));
+        CAPTURE(i, theta);
+
+        // Top edge of the first tet and bottom edge of the second one
+        const Eigen::MatrixXd world_V = bodies.world_vertices(poses);
+        const Eigen::Vector3d ea0 = world_V.row(0), ea1 = world_V.row(1);
+        const Eigen::Vector3d eb0 = world_V.row(4 + 2);
+        const Eigen::Vector3d eb1 = world_V.row(4 + 3);
+        REQUIRE(ea0.isApprox(V.row(0).transpose()));
+        REQUIRE(eb0.z() == Approx(1.02));
+        REQUIRE(eb1.z() == Approx(1.02));
+        num_mollified += edge_edge_cross_squarednorm(ea0, ea1, eb0, eb1)
+            < edge_edge_mollifier_threshold(ea0, ea1, eb0, eb1);
+
+        const Constraints& expected =
+            *full.construct_constraint_set(bodies, poses);
+        const Constraints& actual =
+            *incremental.construct_constraint_set(bodies, poses);
+        CHECK(expected.size() > 0);
+        check_same_constraints(actual, expected);
+    }
+    // The sequence crosses the mollifier threshold
+    CHECK(num_mollified > 0);
+    CHECK(num_mollified < num_poses);
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch.hpp>
+
+#include <igl/slice.h>
+
+#include <opt/dof_reduction.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Reduce to the free DoF", "[opt][dof_reduction]")
+{
+    const int n = 6;
+    Eigen::VectorXi free_dof;
+    SECTION("All free") { free_dof = Eigen::VectorXi::LinSpaced(n, 0, n - 1); }
+    SECTION("Some fixed")
+    {
+        free_dof.resize(3);
+        free_dof << 0, 2, 5;
+    }
+    SECTION("All fixed") { free_dof.resize(0); }
+
+    DofReduction reduction(free_dof, n);
+    CHECK(reduction.num_dof() == n);
+    CHECK(reduction.num_free_dof() == free_dof.size());
+    CHECK(reduction.is_identity() == (free_dof.size() == n));
+
+    Eigen::MatrixXd dense = Eigen::MatrixXd::Random(n, n);
+    dense = (dense + dense.transpose()).eval();
+    dense(1, 4) = dense(4, 1) = 0;
+    Eigen::SparseMatrix<double> A = dense.sparseView();
+
+    Eigen::SparseMatrix<double> expected_A_free;
+    igl::slice(A, free_dof, free_dof, expected_A_free);
+    Eigen::SparseMatrix<double> A_free;
+    reduction.reduce(A, A_free);
+    CHECK(Eigen::MatrixXd(A_free).isApprox(Eigen::MatrixXd(expected_A_free)));
+
+    Eigen::VectorXd x = Eigen::VectorXd::Random(n), x_free;
+    reduction.reduce(x, x_free);
+    Eigen::VectorXd expected_x_free;
+    igl::slice(x, free_dof, expected_x_free);
+    CHECK(x_free == expected_x_free);
+
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(n);
+    reduction.expand(x_free, y);
+    for (int i = 0; i < free_dof.size(); i++) {
+        CHECK(y(free_dof(i)) == x(free_dof(i)));
+    }
+    CHECK(y.sum() == Approx(x_free.sum()));
+}
@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+
+#include <finitediff.hpp>
+
+#include <autodiff/autodiff_types.hpp>
+#include <problems/distance_barrier_rb_problem.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// Expose the per-body energies of the problem
+class BodyEnergyProblem : public DistanceBarrierRBProblem {
+public:
+    using DistanceBarrierRBProblem::body_energy_integration_method;
+    using DistanceBarrierRBProblem::compute_body_energy;
+    using RigidBodyProblem::timestep;
+};
+
+template <int dim>
+void check_body_energy(BodyEnergyProblem& problem, const PoseD& pose)
+{
+    typedef AutodiffType<Eigen::Dynamic, /*maxN=*/6> Diff;
+    constexpr int ndof = dim == 2 ? 3 : 6;
+    const RigidBody& body = problem.m_assembler[0];
+
+    Eigen::Matrix<double, ndof, 1> grad;
+    Eigen::Matrix<double, ndof, ndof> hess;
+    double energy = problem.compute_body_energy<dim>(
+        body, pose, grad, hess, /*compute_grad=*/true, /*compute_hess=*/true);
+
+    Diff::activate(ndof);
+    Pose<Diff::DDouble2> pose_diff(Diff::d2vars(0, pose.dof()));
+    Diff::DDouble2 expected = problem.compute_body_energy<Diff::DDouble2>(
+        body, pose_diff, VectorMax6d::Zero(ndof));
+
+    CHECK(energy == Approx(expected.getValue()));
+    CHECK(fd::compare_gradient(
+        Eigen::VectorXd(grad), Eigen::VectorXd(expected.getGradient())));
+    CHECK(fd::compare_jacobian(
+        Eigen::MatrixXd(hess), Eigen::MatrixXd(expected.getHessian())));
+}
+
+} // namespace
+
+TEST_CASE("Closed-form body energy", "[RB][RB-Problem][body_energy]")
+{
+    const int dim = GENERATE(2, 3);
+    const BodyEnergyIntegrationMethod method =
+        GENERATE(IMPLICIT_EULER, IMPLICIT_NEWMARK, STABILIZED_NEWMARK);
+    // Free, fixed position, or fixed rotation
+    const int fixed_dof = GENERATE(0, 1, 2);
+    // The closed form switches to Taylor series for |θ| < 0.1
+    const double theta_norm = GENERATE(0.0, 0.1 - 1e-6, 0.1 + 1e-6, 2.5);
+    CAPTURE(dim, method, fixed_dof, theta_norm);
+
+    const int ndof = PoseD::dim_to_ndof(dim);
+    const int pos_ndof = PoseD::dim_to_pos_ndof(dim);
+    const int rot_ndof = PoseD::dim_to_rot_ndof(dim);
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi E, F;
+    if (dim == 2) {
+        V.resize(4, 2);
+        V << 0, 0, 2, 0, 2, 1, 0, 1;
+        E.resize(4, 2);
+        E << 0, 1, 1, 2, 2, 3, 3, 0;
+    } else {
+        V.resize(4, 3);
+        V << 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 3;
+        F.resize(4, 3);
+        F << 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3;
+        E.resize(6, 2);
+        E << 0, 1, 1, 2, 2, 0, 0, 3, 1, 3, 2, 3;
+    }
+
+    VectorMax6b is_dof_fixed = VectorMax6b::Zero(ndof);
+    if (fixed_dof == 1) {
+        is_dof_fixed.head(pos_ndof).setOnes();
+    } else if (fixed_dof == 2) {
+        is_dof_fixed.tail(rot_ndof).setOnes();
+    }
+
+    RigidBody body(
+        V, E, F,
+        PoseD(VectorMax3d::Random(dim), VectorMax3d::Random(rot_ndof)),
+        PoseD(VectorMax3d::Random(dim), VectorMax3d::Random(rot_ndof)),
+        PoseD(VectorMax3d::Random(dim), VectorMax3d::Random(rot_ndof)),
+        /*density=*/1.0, is_dof_fixed, /*oriented=*/false, /*group_id=*/0);
+    body.acceleration =
+        PoseD(VectorMax3d::Random(dim), VectorMax3d::Random(rot_ndof));
+    body.Qdot = Eigen::Matrix3d::Random();
+    body.Qddot = Eigen::Matrix3d::Random();
+
+    BodyEnergyProblem problem;
+    problem.init({ body });
+    problem.timestep(0.01);
+    problem.gravity = VectorMax3d::Random(dim);
+    problem.body_energy_integration_method = method;
+
+    PoseD pose(
+        VectorMax3d::Random(dim),
+        theta_norm * VectorMax3d::Random(rot_ndof).normalized());
+
+    if (dim == 2) {
+        check_body_energy<2>(problem, pose);
+    } else {
+        check_body_energy<3>(problem, pose);
+    }
+}
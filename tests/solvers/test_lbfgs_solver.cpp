@@ -0,0 +1,130 @@
+#include <catch2/catch.hpp>
+
+#include <SimState.hpp>
+#include <solvers/lbfgs_solver.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// Expose the curvature history of the L-BFGS solver
+class LBFGSHistory : public LBFGSSolver {
+public:
+    using LBFGSSolver::gradient_free;
+    using LBFGSSolver::history;
+    using LBFGSSolver::history_size;
+    using LBFGSSolver::prev_gradient_free;
+    using LBFGSSolver::prev_x_free;
+    using LBFGSSolver::update_history;
+};
+
+} // namespace
+
+TEST_CASE("L-BFGS solver", "[opt][lbfgs]")
+{
+    // A spinning box dropped on the ground, so the barrier is active
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "newton_solver": {
+            "velocity_conv_tol": 1e-8
+        },
+        "rigid_body_problem": {
+            "gravity": [0, -9.81],
+            "rigid_bodies": [{
+                "vertices": [[-2, -1], [2, -1], [2, 0], [-2, 0]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "type": "static"
+            }, {
+                "vertices": [[0, 0.02], [1, 0.02], [1, 1.02], [0, 1.02]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "linear_velocity": [0.5, -1],
+                "angular_velocity": [1]
+            }]
+        }
+    })"_json;
+    const int num_steps = 10;
+
+    std::vector<PosesD> expected_poses;
+    for (const std::string solver : { "ipc_solver", "lbfgs_solver" }) {
+        CAPTURE(solver);
+        scene["solver"] = solver;
+
+        SimState sim;
+        REQUIRE(sim.init(scene));
+        REQUIRE(sim.problem_ptr->solver().name() == solver);
+        for (int i = 0; i < num_steps; i++) {
+            sim.simulation_step();
+            REQUIRE(sim.problem_ptr->opt_result.success);
+            sim.save_simulation_step();
+        }
+        CHECK(!sim.m_step_has_intersections);
+        REQUIRE(sim.num_states() == num_steps + 1);
+
+        // The L-BFGS steps converge to the Newton solutions
+        for (size_t i = 0; i < sim.num_states(); i++) {
+            const PosesD poses = sim.get_poses(i);
+            if (solver == "ipc_solver") {
+                expected_poses.push_back(poses);
+                continue;
+            }
+            for (size_t j = 0; j < poses.size(); j++) {
+                CHECK(
+                    (poses[j].position - expected_poses[i][j].position).norm()
+                    == Approx(0).margin(1e-5));
+                CHECK(
+                    (poses[j].rotation - expected_poses[i][j].rotation).norm()
+                    == Approx(0).margin(1e-5));
+            }
+        }
+
+        if (solver == "lbfgs_solver") {
+            const nlohmann::json stats = sim.problem_ptr->solver().stats();
+            CHECK(stats["num_hessian_refreshes"].get<size_t>() > 0);
+            CHECK(stats["num_quasi_newton_steps"].get<size_t>() > 0);
+        }
+    }
+}
+
+TEST_CASE("L-BFGS curvature history", "[opt][lbfgs]")
+{
+    LBFGSHistory solver;
+    solver.history_size = 2;
+    solver.prev_x_free = Eigen::Vector2d::Zero();
+    solver.prev_gradient_free = Eigen::Vector2d::Zero();
+    const Eigen::Vector2d x_free(1, 0);
+
+    SECTION("Negative curvature")
+    {
+        solver.gradient_free = Eigen::Vector2d(-1, 0);
+        solver.update_history(x_free);
+        CHECK(solver.history.empty());
+    }
+    SECTION("Zero curvature")
+    {
+        solver.gradient_free = Eigen::Vector2d(0, 1);
+        solver.update_history(x_free);
+        CHECK(solver.history.empty());
+    }
+    SECTION("Positive curvature")
+    {
+        solver.gradient_free = Eigen::Vector2d(2, 1);
+        solver.update_history(x_free);
+        REQUIRE(solver.history.size() == 1);
+        CHECK(solver.history[0].s == x_free);
+        CHECK(solver.history[0].y == solver.gradient_free);
+        CHECK(solver.history[0].rho == Approx(0.5));
+    }
+    // The next pair starts from this iterate even if the pair was skipped
+    CHECK(solver.prev_x_free == x_free);
+    CHECK(solver.prev_gradient_free == solver.gradient_free);
+
+    // Only the most recent pairs are kept
+    for (int i = 2; i <= 4; i++) {
+        solver.gradient_free += Eigen::Vector2d(i, 0);
+        solver.update_history(Eigen::Vector2d(i, 0));
+    }
+    REQUIRE(solver.history.size() == 2);
+    CHECK(solver.history.back().s == Eigen::Vector2d(1, 0));
+    CHECK(solver.history.back().y == Eigen::Vector2d(4, 0));
+}
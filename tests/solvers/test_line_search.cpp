@@ -0,0 +1,81 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+#include <tbb/task_arena.h>
+
+#include <SimState.hpp>
+#include <problems/distance_barrier_rb_problem.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+TEST_CASE("Batched line search", "[opt][newtons_method][line_search]")
+{
+    // A spinning box dropped on the ground, so the concurrent evaluations
+    // share the constraint set caches
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "rigid_body_problem": {
+            "gravity": [0, -9.81],
+            "rigid_bodies": [{
+                "vertices": [[-2, -1], [2, -1], [2, 0], [-2, 0]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "type": "static"
+            }, {
+                "vertices": [[0, 0.02], [1, 0.02], [1, 1.02], [0, 1.02]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "linear_velocity": [0.5, -1],
+                "angular_velocity": [1]
+            }]
+        }
+    })"_json;
+    const int num_steps = 20;
+
+    // Evaluate the batches on more than one thread
+    tbb::task_arena arena(4);
+
+    std::vector<PosesD> expected_poses;
+    int num_contacts = 0;
+    for (int batch_size : { 1, 4 }) {
+        CAPTURE(batch_size);
+        scene["newton_solver"]["line_search_batch_size"] = batch_size;
+
+        SimState sim;
+        REQUIRE(sim.init(scene));
+        auto problem = std::dynamic_pointer_cast<DistanceBarrierRBProblem>(
+            sim.problem_ptr);
+        REQUIRE(problem != nullptr);
+        CHECK(problem->is_thread_safe());
+        arena.execute([&] {
+            for (int i = 0; i < num_steps; i++) {
+                sim.simulation_step();
+                sim.save_simulation_step();
+            }
+        });
+        CHECK(!sim.m_step_has_collision);
+        CHECK(!sim.m_step_has_intersections);
+        REQUIRE(sim.num_states() == num_steps + 1);
+
+        // The batches take the same steps as the serial backtracking
+        for (size_t i = 0; i < sim.num_states(); i++) {
+            const PosesD poses = sim.get_poses(i);
+            if (batch_size == 1) {
+                expected_poses.push_back(poses);
+                continue;
+            }
+            for (size_t j = 0; j < poses.size(); j++) {
+                CHECK(
+                    (poses[j].position - expected_poses[i][j].position).norm()
+                    == Approx(0).margin(1e-8));
+                CHECK(
+                    (poses[j].rotation - expected_poses[i][j].rotation).norm()
+                    == Approx(0).margin(1e-8));
+            }
+        }
+        num_contacts = *std::max_element(
+            sim.num_contacts.begin(), sim.num_contacts.end());
+    }
+    // The box reaches the ground
+    CHECK(num_contacts > 0);
+}
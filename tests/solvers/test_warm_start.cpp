@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <numeric>
+#include <string>
+
+#include <SimState.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+namespace {
+
+/// Total number of Newton iterations of the steps in [begin, end)
+int count_iterations(const SimState& sim, size_t begin, size_t end)
+{
+    return std::accumulate(
+        sim.solver_iterations.begin() + begin,
+        sim.solver_iterations.begin() + end, 0);
+}
+
+} // namespace
+
+TEST_CASE("Warm start", "[opt][newtons_method][warm_start]")
+{
+    // A tumbling tetrahedron, so the rotational energy is not quadratic and
+    // the Newton solves take more than one iteration
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "rigid_body_problem": {
+            "gravity": [0, -9.81, 0],
+            "rigid_bodies": [{
+                "vertices": [[0, 0, 0], [1, 0, 0], [0, 2, 0], [0, 0, 3]],
+                "faces": [[0, 2, 1], [0, 1, 3], [0, 3, 2], [1, 2, 3]],
+                "edges": [[0, 1], [1, 2], [2, 0], [0, 3], [1, 3], [2, 3]],
+                "linear_velocity": [1, 2, 0],
+                "angular_velocity": [360, 720, 180]
+            }]
+        }
+    })"_json;
+    const int num_steps = 10;
+
+    std::array<int, 2> full_step_iterations, half_step_iterations;
+    for (const std::string warm_start : { "none", "previous_delta" }) {
+        CAPTURE(warm_start);
+        scene["rigid_body_problem"]["warm_start"] = warm_start;
+
+        SimState sim;
+        REQUIRE(sim.init(scene));
+        for (int i = 0; i < num_steps; i++) {
+            sim.simulation_step();
+            REQUIRE(sim.problem_ptr->opt_result.success);
+        }
+        // The previous velocity is repeated over the shorter steps
+        sim.problem_ptr->timestep(0.005);
+        for (int i = 0; i < num_steps; i++) {
+            sim.simulation_step();
+            REQUIRE(sim.problem_ptr->opt_result.success);
+        }
+        REQUIRE(sim.solver_iterations.size() == 2 * num_steps);
+
+        const int j = warm_start == "none" ? 0 : 1;
+        // Skip the first step, which has no previous step to repeat
+        full_step_iterations[j] = count_iterations(sim, 1, num_steps);
+        half_step_iterations[j] =
+            count_iterations(sim, num_steps, 2 * num_steps);
+    }
+
+    CHECK(full_step_iterations[1] < full_step_iterations[0]);
+    CHECK(half_step_iterations[1] < half_step_iterations[0]);
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+
+#include <SimState.hpp>
+#include <physics/rigid_body_problem.hpp>
+#include <time_stepper/adaptive_timestep.hpp>
+
+using namespace ipc;
+using namespace ipc::rigid;
+
+// Advance a frame and return the number of substeps taken.
+int advance_frame(
+    AdaptiveTimestep& controller,
+    double frame_timestep,
+    const SubstepDifficulty& difficulty)
+{
+    controller.begin_frame(frame_timestep);
+    double time = 0;
+    int num_substeps = 0;
+    do {
+        double substep = controller.next_substep();
+        CHECK(substep > 0);
+        time += substep;
+        controller.end_substep(substep, difficulty);
+        num_substeps++;
+        REQUIRE(num_substeps < 1000);
+    } while (!controller.is_frame_finished());
+    CHECK(time == Approx(frame_timestep));
+    return num_substeps;
+}
+
+TEST_CASE("Adaptive time-step", "[time_stepper][adaptive_timestep]")
+{
+    const double h = 0.01;
+    AdaptiveTimestep controller;
+    controller.enabled = true;
+    controller.min_timestep = h / 16;
+
+    SubstepDifficulty easy;
+    SubstepDifficulty hard;
+    SECTION("Not converged") { hard.success = false; }
+    SECTION("Many iterations")
+    {
+        hard.num_iterations = controller.max_iterations + 1;
+    }
+    SECTION("Line-search failure") { hard.num_line_search_failures = 1; }
+    SECTION("Early impact") { hard.earliest_toi = controller.min_toi / 2; }
+
+    // Easy frames are advanced in a single step
+    CHECK(advance_frame(controller, h, easy) == 1);
+    CHECK(controller.timestep() == h);
+
+    // Hard substeps shrink the following substeps down to the minimum
+    CHECK(advance_frame(controller, h, hard) == 1);
+    CHECK(controller.timestep() < h);
+    CHECK(advance_frame(controller, h, hard) > 1);
+    for (int i = 0; i < 5; i++) {
+        advance_frame(controller, h, hard);
+    }
+    CHECK(controller.timestep() == Approx(controller.min_timestep));
+    CHECK(advance_frame(controller, h, hard) == 16);
+
+    // Easy substeps grow back to the frame length
+    for (int i = 0; i < 5; i++) {
+        advance_frame(controller, h, easy);
+    }
+    CHECK(controller.timestep() == h);
+    CHECK(advance_frame(controller, h, easy) == 1);
+}
+
+TEST_CASE("Disabled adaptive time-step", "[time_stepper][adaptive_timestep]")
+{
+    const double h = 0.01;
+    AdaptiveTimestep controller;
+    controller.enabled = false;
+
+    SubstepDifficulty hard;
+    hard.success = false;
+    CHECK(advance_frame(controller, h, hard) == 1);
+    CHECK(advance_frame(controller, h, hard) == 1);
+}
+
+TEST_CASE(
+    "Warm start does not shrink the time-step",
+    "[time_stepper][adaptive_timestep][warm_start]")
+{
+    using namespace nlohmann;
+    const double h = 0.01;
+    // A square moving 0.1 per time-step toward a static square 0.105 away
+    nlohmann::json scene = R"({
+        "timestep": 0.01,
+        "adaptive_timestep": {"enabled": true},
+        "rigid_body_problem": {
+            "gravity": [0, 0],
+            "warm_start": "previous_delta",
+            "rigid_bodies": [{
+                "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "type": "static"
+            }, {
+                "vertices": [[0, 0], [1, 0], [1, 1], [0, 1]],
+                "edges": [[0, 1], [1, 2], [2, 3], [3, 0]],
+                "position": [1.105, 0],
+                "linear_velocity": [-10, 0]
+            }]
+        }
+    })"_json;
+
+    SimState sim;
+    REQUIRE(sim.init(scene));
+    auto rbp = std::dynamic_pointer_cast<RigidBodyProblem>(sim.problem_ptr);
+    REQUIRE(rbp != nullptr);
+    RigidBody& body = rbp->m_assembler[1];
+    REQUIRE(body.type == RigidBodyType::DYNAMIC);
+
+    // The first step ends 0.005 from the static square without an impact
+    sim.simulation_step();
+    CHECK(sim.m_step_num_substeps == 1);
+    CHECK(sim.adaptive_timestep.timestep() == Approx(h));
+
+    // Stop the square. The warm start repeats the previous displacement,
+    // which hits the static square early, but the step itself stays put.
+    body.velocity = PoseD::Zero(2);
+    sim.simulation_step();
+    CHECK(
+        sim.problem_ptr->step_earliest_toi()
+        >= sim.adaptive_timestep.min_toi);
+    CHECK(sim.m_step_num_substeps == 1);
+    CHECK(sim.adaptive_timestep.timestep() == Approx(h));
+}